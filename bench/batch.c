@@ -0,0 +1,254 @@
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <math.h>
+#include <time.h>
+
+#include "blm.h"
+#include "lfg.h"
+#include "pm.h"
+#include "tsfunc.h"
+
+/* Parameter spread across the batch.
+ * */
+#define BATCH_SPREAD		0.2
+
+typedef struct {
+
+	double		eA;
+	double		eW;
+	long		count;
+}
+batch_stat_t;
+
+typedef struct {
+
+	blm_batch_t	mb;
+	pmc_t		pm[BLM_LANES];
+
+	int		lane;
+
+	batch_stat_t	stat[BLM_LANES];
+}
+batch_t;
+
+static __thread batch_t		*batch_local;
+
+static void
+batch_proc_DC(int A, int B, int C)
+{
+	batch_t		*bt = batch_local;
+
+	bt->mb.pwm_A[bt->lane] = A;
+	bt->mb.pwm_B[bt->lane] = B;
+	bt->mb.pwm_C[bt->lane] = C;
+}
+
+static void
+batch_proc_Z(int Z)
+{
+	batch_t		*bt = batch_local;
+
+	bt->mb.pwm_Z[bt->lane] = (Z != PM_Z_ABC) ? BLM_Z_NONE : BLM_Z_DETACHED;
+}
+
+static void
+batch_runtime(batch_t *bt, double dT, int stat)
+{
+	blm_batch_t	*mb = &bt->mb;
+	pmfb_t		fb;
+	double		stop, eA, eW;
+	int		i;
+
+	stop = mb->time + dT;
+
+	/* Plant callbacks have no context argument.
+	 * */
+	batch_local = bt;
+
+	while (mb->time < stop) {
+
+		blm_batch_update(mb);
+
+		for (i = 0; i < BLM_LANES; ++i) {
+
+			pmc_t		*pm = &bt->pm[i];
+
+			fb.current_A = mb->analog_iA[i];
+			fb.current_B = mb->analog_iB[i];
+			fb.current_C = mb->analog_iC[i];
+			fb.voltage_U = mb->analog_uS[i];
+			fb.voltage_A = mb->analog_uA[i];
+			fb.voltage_B = mb->analog_uB[i];
+			fb.voltage_C = mb->analog_uC[i];
+
+			fb.analog_SIN = mb->analog_SIN[i];
+			fb.analog_COS = mb->analog_COS[i];
+
+			fb.pulse_HS = mb->pulse_HS[i];
+			fb.pulse_EP = mb->pulse_EP[i];
+
+			bt->lane = i;
+
+			pm_feedback(pm, &fb);
+
+			if (stat != 0 && pm->lu_MODE != PM_LU_DISABLED) {
+
+				/* Estimate error against the machine state.
+				 * */
+				eA = atan2(pm->lu_F[1] * cos(mb->state[3][i])
+						- pm->lu_F[0] * sin(mb->state[3][i]),
+						pm->lu_F[0] * cos(mb->state[3][i])
+						+ pm->lu_F[1] * sin(mb->state[3][i]));
+
+				eW = pm->lu_wS - mb->state[2][i];
+
+				bt->stat[i].eA += eA * eA;
+				bt->stat[i].eW += eW * eW;
+				bt->stat[i].count += 1;
+			}
+		}
+	}
+}
+
+static void
+batch_speed(batch_t *bt, float speed)
+{
+	int		i;
+
+	for (i = 0; i < BLM_LANES; ++i) {
+
+		bt->pm[i].s_setpoint_speed = speed * bt->pm[i].k_EMAX / 100.f
+			* bt->pm[i].const_fb_U / bt->pm[i].const_lambda;
+	}
+}
+
+static void
+batch_load(batch_t *bt, double load)
+{
+	int		i;
+
+	for (i = 0; i < BLM_LANES; ++i) {
+
+		bt->mb.Mq[0][i] = - 1.5 * bt->mb.Zp * bt->mb.lambda[i] * load;
+	}
+}
+
+static long long
+batch_clock()
+{
+	struct timespec		ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+
+	return (long long) ts.tv_sec * 1000000000LL + (long long) ts.tv_nsec;
+}
+
+void batch_script()
+{
+	sim_t		*S;
+	batch_t		*bt;
+
+	long long	clock;
+	double		tSIM;
+	int		i;
+
+	S = calloc(1, sizeof(sim_t));
+	bt = calloc(1, sizeof(batch_t));
+
+	if (S == NULL || bt == NULL) {
+
+		fprintf(stderr, "calloc: failed\n");
+		abort();
+	}
+
+	/* We tune PMC on nominal machine.
+	 * */
+	S->fd_log = stderr;
+
+	blm_enable(&S->m);
+	blm_restart(&S->m);
+
+	S->m.Rs = 14.e-3;
+	S->m.Ld = 10.e-6;
+	S->m.Lq = 15.e-6;
+	S->m.Udc = 22.;
+	S->m.Rdc = 0.1;
+	S->m.Zp = 14;
+	S->m.lambda = blm_Kv_lambda(&S->m, 270.);
+	S->m.Jm = 4.e-4;
+
+	ts_script_default(S);
+	ts_script_base(S);
+
+	S->pm.config_LU_DRIVE = PM_DRIVE_SPEED;
+
+	S->pm.s_accel_forward = 300000.f;
+	S->pm.s_accel_reverse = S->pm.s_accel_forward;
+
+	blm_batch_enable(&bt->mb, &S->m);
+
+	/* Lane 0 keeps nominal parameters.
+	 * */
+	for (i = 1; i < BLM_LANES; ++i) {
+
+		bt->mb.Rs[i] *= 1. + BATCH_SPREAD * lfg_urand();
+		bt->mb.Ld[i] *= 1. + BATCH_SPREAD * lfg_urand();
+		bt->mb.Lq[i] *= 1. + BATCH_SPREAD * lfg_urand();
+	}
+
+	blm_batch_restart(&bt->mb);
+
+	for (i = 0; i < BLM_LANES; ++i) {
+
+		memcpy(&bt->pm[i], &S->pm, sizeof(pmc_t));
+
+		bt->pm[i].proc_set_DC = &batch_proc_DC;
+		bt->pm[i].proc_set_Z = &batch_proc_Z;
+		bt->pm[i].proc_defer = NULL;
+
+		bt->pm[i].fsm_req = PM_STATE_LU_STARTUP;
+	}
+
+	clock = batch_clock();
+
+	batch_runtime(bt, .2, 0);
+
+	batch_speed(bt, 50.f);
+	batch_runtime(bt, .5, 0);
+	batch_runtime(bt, .5, 1);
+
+	batch_load(bt, 20.);
+	batch_runtime(bt, .5, 1);
+
+	batch_load(bt, 0.);
+	batch_speed(bt, 10.f);
+	batch_runtime(bt, .5, 0);
+	batch_runtime(bt, .5, 1);
+
+	clock = batch_clock() - clock;
+
+	tSIM = bt->mb.time;
+
+	printf("lane;Rs@%%;Ld@%%;Lq@%%;angle_RMS@deg;speed_RMS@rad/s;lu_MODE;fsm_errno;\n");
+
+	for (i = 0; i < BLM_LANES; ++i) {
+
+		const batch_stat_t	*st = &bt->stat[i];
+
+		printf("%i;%+.1f;%+.1f;%+.1f;%.3f;%.3f;%i;%s;\n", i,
+				(bt->mb.Rs[i] / S->m.Rs - 1.) * 100.,
+				(bt->mb.Ld[i] / S->m.Ld - 1.) * 100.,
+				(bt->mb.Lq[i] / S->m.Lq - 1.) * 100.,
+				(st->count > 0) ? sqrt(st->eA / st->count) * (180. / M_PI) : 0.,
+				(st->count > 0) ? sqrt(st->eW / st->count) : 0.,
+				bt->pm[i].lu_MODE, pm_strerror(bt->pm[i].fsm_errno));
+	}
+
+	printf("%i lanes %.3f (s) simulated in %.3f (s) sol_nstep = %li\n",
+			BLM_LANES, tSIM, (double) clock * 1.e-9, bt->mb.sol_nstep);
+
+	free(S);
+	free(bt);
+}
+
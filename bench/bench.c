@@ -4,10 +4,13 @@
 #include <errno.h>
 #include <math.h>
 #include <time.h>
+#include <pthread.h>
 
 #include "blm.h"
 #include "lfg.h"
+#include "mldata.h"
 #include "pm.h"
+#include "replay.h"
 #include "tsfunc.h"
 
 #define TLM_FILE	"/tmp/pm-TLM"
@@ -15,113 +18,140 @@
 #define MLD_FILE	"/tmp/pm-mldata"
 #define AGP_FILE	"/tmp/pm-auto.gp"
 
-#define TLM_SIZE	100
+__thread sim_t		*sim_local;
 
-blm_t			m;
-pmc_t			pm;
+static const mld_chan_t	mld_chan[] = {
 
-typedef struct {
+	{ "iX",		"A",		50.f },
+	{ "iY",		"A",		50.f },
+	{ "uX",		"V",		20.f },
+	{ "uY",		"V",		20.f },
+	{ "cos",	"",		1.f },
+	{ "sin",	"",		1.f },
+	{ "wS",		"rad/s",	5000.f },
+	{ "Tc",		"C",		100.f }
+};
 
-	int		hatch;
+#define MLD_CHAN_N		(sizeof(mld_chan) / sizeof(mld_chan[0]))
 
-	float		y[TLM_SIZE];
+static void
+sim_fname(sim_t *S, const char *file, char *name)
+{
+	if (S->unit != 0) {
 
-	FILE		*fd_tlm;
-	FILE		*fd_pwm;
-	FILE		*fd_mld;
-	FILE		*fd_gp;
+		sprintf(name, "%s.%i", file, S->unit);
+	}
+	else {
+		strcpy(name, file);
+	}
 }
-tlm_t;
 
-static tlm_t		tlm;
+static FILE *
+sim_fopen(sim_t *S, const char *file, const char *mode)
+{
+	char		name[80];
+	FILE		*fd;
+
+	sim_fname(S, file, name);
+
+	fd = fopen(name, mode);
+
+	if (fd == NULL) {
+
+		fprintf(stderr, "fopen: %s\n", strerror(errno));
+		abort();
+	}
+
+	return fd;
+}
 
 static void
-tlm_page_GP(int nGP, const char *figure, const char *label)
+tlm_page_GP(sim_t *S, int nGP, const char *figure, const char *label)
 {
-	fprintf(tlm.fd_gp, "page \"%s\"\n", figure);
-	if (label != NULL) { fprintf(tlm.fd_gp, "label 1 \"(%s)\"\n", label); }
-	fprintf(tlm.fd_gp, "figure 0 %i \"%s\"\n\n", nGP, figure);
+	fprintf(S->tlm.fd_gp, "page \"%s\"\n", figure);
+	if (label != NULL) { fprintf(S->tlm.fd_gp, "label 1 \"(%s)\"\n", label); }
+	fprintf(S->tlm.fd_gp, "figure 0 %i \"%s\"\n\n", nGP, figure);
 }
 
 static void
-tlm_plot_grab()
+tlm_plot_grab(sim_t *S)
 {
-	const double	kRPM = 30. / M_PI / m.Zp;
+	const double	kRPM = 30. / M_PI / S->m.Zp;
 	const double	kDEG = 180. / M_PI;
 
 	double		A, B, C, D, Q, rel;
 	int		nGP;
 
-#define sym_GP(x, s, l)		{ tlm.y[nGP] = (float) (x); if (tlm.fd_gp != NULL) \
-				{ tlm_page_GP(nGP, s, (const char *) l); } nGP++; }
-#define fmt_GP(x, l)		sym_GP(x, #x, l)
-#define fmk_GP(x, k, l)		sym_GP((x) * (k), #x, l)
+#define sym_GP(x, s, l)		{ S->tlm.y[nGP] = (float) (x); if (S->tlm.fd_gp != NULL) \
+				{ tlm_page_GP(S, nGP, s, (const char *) l); } nGP++; }
+#define fmt_GP(x, l)		sym_GP(S->x, #x, l)
+#define fmk_GP(x, k, l)		sym_GP((S->x) * (k), #x, l)
 
 	/* Machine State Variables.
 	 * */
-	tlm.y[0] = m.time;
-	tlm.y[1] = m.state[0];
-	tlm.y[2] = m.state[1];
-	tlm.y[3] = m.state[2] * kRPM;
-	tlm.y[4] = m.state[3] * kDEG;
-	tlm.y[5] = m.state[4];
-	tlm.y[6] = m.state[6];
+	S->tlm.y[0] = S->m.time;
+	S->tlm.y[1] = S->m.state[0];
+	S->tlm.y[2] = S->m.state[1];
+	S->tlm.y[3] = S->m.state[2] * kRPM;
+	S->tlm.y[4] = S->m.state[3] * kDEG;
+	S->tlm.y[5] = S->m.state[4];
+	S->tlm.y[6] = S->m.state[6];
 
 	/* Duty Cycle.
 	 * */
-	tlm.y[7] = (double) m.pwm_A * 100. / (double) m.pwm_resolution;
-	tlm.y[8] = (double) m.pwm_B * 100. / (double) m.pwm_resolution;
-	tlm.y[9] = (double) m.pwm_C * 100. / (double) m.pwm_resolution;
+	S->tlm.y[7] = (double) S->m.pwm_A * 100. / (double) S->m.pwm_resolution;
+	S->tlm.y[8] = (double) S->m.pwm_B * 100. / (double) S->m.pwm_resolution;
+	S->tlm.y[9] = (double) S->m.pwm_C * 100. / (double) S->m.pwm_resolution;
 
 	/* VSI Voltage.
 	 * */
-	tlm.y[10] = pm.vsi_X;
-	tlm.y[11] = pm.vsi_Y;
+	S->tlm.y[10] = S->pm.vsi_X;
+	S->tlm.y[11] = S->pm.vsi_Y;
 
 	/* Estimated Current.
 	 * */
-	tlm.y[12] = pm.lu_iD;
-	tlm.y[13] = pm.lu_iQ;
+	S->tlm.y[12] = S->pm.lu_iD;
+	S->tlm.y[13] = S->pm.lu_iQ;
 
-	D = cos(m.state[3]);
-	Q = sin(m.state[3]);
-	A = D * pm.lu_F[0] + Q * pm.lu_F[1];
-	B = D * pm.lu_F[1] - Q * pm.lu_F[0];
+	D = cos(S->m.state[3]);
+	Q = sin(S->m.state[3]);
+	A = D * S->pm.lu_F[0] + Q * S->pm.lu_F[1];
+	B = D * S->pm.lu_F[1] - Q * S->pm.lu_F[0];
 	rel = atan2(B, A);
 
-	if (m.unsync_flag != 0 && fabs(rel) > 1.2) {
+	if (S->m.unsync_flag != 0 && fabs(rel) > 1.2) {
 
 		/* Throw an ERROR if position estimate deviation is too large.
 		 * */
-		pm.fsm_errno = PM_ERROR_NO_SYNC_FAULT;
+		S->pm.fsm_errno = PM_ERROR_NO_SYNC_FAULT;
 	}
 
-	tlm.y[14] = rel * kDEG;
+	S->tlm.y[14] = rel * kDEG;
 
 	/* Estimated Position.
 	 * */
-	tlm.y[15] = atan2(pm.lu_F[1], pm.lu_F[0]) * kDEG;
+	S->tlm.y[15] = atan2(S->pm.lu_F[1], S->pm.lu_F[0]) * kDEG;
 
 	/* Estimated Speed.
 	 * */
-	tlm.y[16] = pm.lu_wS * kRPM;
+	S->tlm.y[16] = S->pm.lu_wS * kRPM;
 
 	/* Power Consumption.
 	 * */
-	tlm.y[17] = m.drain_wP;
-	tlm.y[18] = pm.watt_drain_wP;
+	S->tlm.y[17] = S->m.drain_wP;
+	S->tlm.y[18] = S->pm.watt_drain_wP;
 
 	/* DC link Voltage.
 	 * */
-	tlm.y[19] = pm.const_fb_U;
+	S->tlm.y[19] = S->pm.const_fb_U;
 
-	blm_DQ_ABC(m.state[3], m.state[0], m.state[1], &A, &B, &C);
+	blm_DQ_ABC(S->m.state[3], S->m.state[0], S->m.state[1], &A, &B, &C);
 
 	/* Absolute Current.
 	 * */
-	tlm.y[20] = fabsf(A);
-	tlm.y[21] = fabsf(B);
-	tlm.y[22] = fabsf(C);
+	S->tlm.y[20] = fabsf(A);
+	S->tlm.y[21] = fabsf(B);
+	S->tlm.y[22] = fabsf(C);
 
 	/* NOTE: Private parameters are managed with automatic generation of GP
 	 * configuration. So you only need to add a one line of code for each
@@ -152,13 +182,13 @@ tlm_plot_grab()
 	fmt_GP(pm.dcu_DY, "V");
 
 	fmt_GP(pm.lu_MODE, 0);
-	fmk_GP(pm.lu_mq_produce, pm.const_Zp, "Nm");
-	fmk_GP(pm.lu_mq_load, pm.const_Zp, "Nm");
+	fmk_GP(pm.lu_mq_produce, S->pm.const_Zp, "Nm");
+	fmk_GP(pm.lu_mq_load, S->pm.const_Zp, "Nm");
 
 	fmt_GP(pm.base_TIM, 0);
 	fmt_GP(pm.hold_TIM, 0);
 
-	sym_GP(atan2(pm.forced_F[1], pm.forced_F[0]) * kDEG, "pm.forced_F", "deg");
+	sym_GP(atan2(S->pm.forced_F[1], S->pm.forced_F[0]) * kDEG, "pm.forced_F", "deg");
 	fmk_GP(pm.forced_wS, kRPM, "rpm");
 
 	fmt_GP(pm.forced_track_D, "A");
@@ -171,7 +201,7 @@ tlm_plot_grab()
 	fmt_GP(pm.flux_X[0], "Wb");
 	fmt_GP(pm.flux_X[1], "Wb");
 	fmt_GP(pm.flux_lambda, "Wb");
-	sym_GP(atan2(pm.flux_F[1], pm.flux_F[0]) * kDEG, "pm.flux_F", "deg");
+	sym_GP(atan2(S->pm.flux_F[1], S->pm.flux_F[0]) * kDEG, "pm.flux_F", "deg");
 	fmk_GP(pm.flux_wS, kRPM, "rpm");
 
 	fmt_GP(pm.kalman_rsu_D, "A");
@@ -184,12 +214,12 @@ tlm_plot_grab()
 	fmt_GP(pm.hfi_wave[0], 0);
 	fmt_GP(pm.hfi_wave[1], 0);
 
-	sym_GP(atan2(pm.hall_F[1], pm.hall_F[0]) * kDEG, "pm.hall_F", "deg");
+	sym_GP(atan2(S->pm.hall_F[1], S->pm.hall_F[0]) * kDEG, "pm.hall_F", "deg");
 	fmk_GP(pm.hall_wS, kRPM, "rpm");
 
 	fmt_GP(pm.eabi_ADJUST, 0);
 
-	sym_GP(atan2(pm.eabi_F[1], pm.eabi_F[0]) * kDEG, "pm.eabi_F", "deg");
+	sym_GP(atan2(S->pm.eabi_F[1], S->pm.eabi_F[0]) * kDEG, "pm.eabi_F", "deg");
 	fmk_GP(pm.eabi_wS, kRPM, "rpm");
 
 	fmt_GP(pm.watt_DC_MAX, 0);
@@ -199,7 +229,7 @@ tlm_plot_grab()
 	fmt_GP(pm.watt_lpf_Q, "V");
 
 	fmt_GP(pm.i_setpoint_current, "A");
-	fmk_GP(pm.i_setpoint_torque, pm.const_Zp, "Nm");
+	fmk_GP(pm.i_setpoint_torque, S->pm.const_Zp, "Nm");
 	fmt_GP(pm.i_track_D, "A");
 	fmt_GP(pm.i_track_Q, "A");
 	fmt_GP(pm.i_integral_D, "V");
@@ -214,336 +244,502 @@ tlm_plot_grab()
 	fmk_GP(pm.s_track, kRPM, "rpm");
 	fmt_GP(pm.s_integral, "A");
 
-	if (tlm.fd_gp != NULL) { fclose(tlm.fd_gp); tlm.fd_gp = NULL; }
+	if (S->tlm.fd_gp != NULL) { fclose(S->tlm.fd_gp); S->tlm.fd_gp = NULL; }
 
-	fwrite(tlm.y, sizeof(float), TLM_SIZE, tlm.fd_tlm);
+	fwrite(S->tlm.y, sizeof(float), TLM_SIZE, S->tlm.fd_tlm);
 
-	if (tlm.fd_mld != NULL) {
+	if (S->tlm.mld != NULL) {
 
-		D = cos(m.state[3]);
-		Q = sin(m.state[3]);
+		D = cos(S->m.state[3]);
+		Q = sin(S->m.state[3]);
 
-		C = (m.pwm_A + m.pwm_B + m.pwm_C) / 3.;
-		A = (m.pwm_A - C) * m.state[6] / (double) m.pwm_resolution;
-		B = (m.pwm_B - C) * m.state[6] / (double) m.pwm_resolution;
+		C = (S->m.pwm_A + S->m.pwm_B + S->m.pwm_C) / 3.;
+		A = (S->m.pwm_A - C) * S->m.state[6] / (double) S->m.pwm_resolution;
+		B = (S->m.pwm_B - C) * S->m.state[6] / (double) S->m.pwm_resolution;
 
 		B = 0.577350269189626 * A + 1.15470053837925 * B;
 
-		tlm.y[0] = D * m.state[0] + Q * m.state[1];	/* iX */
-		tlm.y[1] = D * m.state[1] - Q * m.state[0];	/* iY */
-		tlm.y[2] = A;					/* uX */
-		tlm.y[3] = B;					/* uY */
-		tlm.y[4] = D;					/* cos(\th) */
-		tlm.y[5] = Q;					/* sin(\th) */
-		tlm.y[6] = m.state[2];				/* \omega */
-		tlm.y[7] = m.state[4];				/* Tc */
-		tlm.y[8] = 0;
-		tlm.y[9] = 0;
-
-		fwrite(tlm.y, sizeof(float), 10, tlm.fd_mld);
+		S->tlm.y[0] = D * S->m.state[0] + Q * S->m.state[1];	/* iX */
+		S->tlm.y[1] = D * S->m.state[1] - Q * S->m.state[0];	/* iY */
+		S->tlm.y[2] = A;					/* uX */
+		S->tlm.y[3] = B;					/* uY */
+		S->tlm.y[4] = D;					/* cos(\th) */
+		S->tlm.y[5] = Q;					/* sin(\th) */
+		S->tlm.y[6] = S->m.state[2];				/* \omega */
+		S->tlm.y[7] = S->m.state[4];				/* Tc */
+
+		mld_put(S->tlm.mld, S->tlm.y);
 	}
 }
 
 static void
 tlm_proc_step(double dT)
 {
+	sim_t		*S = sim_local;
 	double		iA, iB, iC;
 
-	tlm.y[0] += dT / 1.e-6;
+	S->tlm.y[0] += dT / 1.e-6;
 
 	/* VSI Output.
 	 * */
-	tlm.y[1] = (m.xdtu[0] == 0) ? (float) m.xfet[0] : (float) tlm.hatch;
-	tlm.y[2] = (m.xdtu[1] == 0) ? (float) m.xfet[1] : (float) tlm.hatch;
-	tlm.y[3] = (m.xdtu[2] == 0) ? (float) m.xfet[2] : (float) tlm.hatch;
+	S->tlm.y[1] = (S->m.xdtu[0] == 0) ? (float) S->m.xfet[0] : (float) S->tlm.hatch;
+	S->tlm.y[2] = (S->m.xdtu[1] == 0) ? (float) S->m.xfet[1] : (float) S->tlm.hatch;
+	S->tlm.y[3] = (S->m.xdtu[2] == 0) ? (float) S->m.xfet[2] : (float) S->tlm.hatch;
 
 	/* Dead-Time Uncertainty.
 	 * */
-	tlm.y[4] = (float) m.xdtu[0];
-	tlm.y[5] = (float) m.xdtu[1];
-	tlm.y[6] = (float) m.xdtu[2];
+	S->tlm.y[4] = (float) S->m.xdtu[0];
+	S->tlm.y[5] = (float) S->m.xdtu[1];
+	S->tlm.y[6] = (float) S->m.xdtu[2];
 
-	blm_DQ_ABC(m.state[3], m.state[0], m.state[1], &iA, &iB, &iC);
+	blm_DQ_ABC(S->m.state[3], S->m.state[0], S->m.state[1], &iA, &iB, &iC);
 
 	/* Machine Current.
 	 * */
-	tlm.y[7] = iA;
-	tlm.y[8] = iB;
-	tlm.y[9] = iC;
+	S->tlm.y[7] = iA;
+	S->tlm.y[8] = iB;
+	S->tlm.y[9] = iC;
 
 	/* Machine DC link Voltage.
 	 * */
-	tlm.y[10] = m.state[6];
+	S->tlm.y[10] = S->m.state[6];
 
 	/* Machine ADC.
 	 * */
-	tlm.y[11] = m.state[7];
-	tlm.y[12] = m.state[8];
-	tlm.y[13] = m.state[9];
-	tlm.y[14] = m.state[10];
-	tlm.y[15] = m.state[11];
-	tlm.y[16] = m.state[12];
-	tlm.y[17] = m.state[13];
-	tlm.y[18] = m.state[14];
+	S->tlm.y[11] = S->m.state[7];
+	S->tlm.y[12] = S->m.state[8];
+	S->tlm.y[13] = S->m.state[9];
+	S->tlm.y[14] = S->m.state[10];
+	S->tlm.y[15] = S->m.state[11];
+	S->tlm.y[16] = S->m.state[12];
+	S->tlm.y[17] = S->m.state[13];
+	S->tlm.y[18] = S->m.state[14];
 
 	/* Analog feedback.
 	 * */
-	tlm.y[19] = m.hold_iA;
-	tlm.y[20] = m.hold_iB;
-	tlm.y[21] = m.hold_iC;
-	tlm.y[22] = m.analog_uA;
-	tlm.y[23] = m.analog_uB;
-	tlm.y[24] = m.analog_uC;
-	tlm.y[25] = m.analog_uS;
+	S->tlm.y[19] = S->m.hold_iA;
+	S->tlm.y[20] = S->m.hold_iB;
+	S->tlm.y[21] = S->m.hold_iC;
+	S->tlm.y[22] = S->m.analog_uA;
+	S->tlm.y[23] = S->m.analog_uB;
+	S->tlm.y[24] = S->m.analog_uC;
+	S->tlm.y[25] = S->m.analog_uS;
 
-	fwrite(tlm.y, sizeof(float), 40, tlm.fd_pwm);
+	fwrite(S->tlm.y, sizeof(float), 40, S->tlm.fd_pwm);
 
-	tlm.hatch = (tlm.hatch == 0) ? 1 : 0;
+	S->tlm.hatch = (S->tlm.hatch == 0) ? 1 : 0;
 }
 
 static void
-tlm_PWM_grab()
+tlm_PWM_grab(sim_t *S)
 {
 	double		usual_dT;
 
-	tlm.fd_pwm = fopen(PWM_FILE, "wb");
-
-	if (tlm.fd_pwm == NULL) {
-
-		fprintf(stderr, "fopen: %s\n", strerror(errno));
-		abort();
-	}
+	S->tlm.fd_pwm = sim_fopen(S, PWM_FILE, "wb");
+	S->tlm.y[0] = 0.f;
 
-	tlm.y[0] = 0.f;
+	sim_local = S;
 
-	usual_dT = m.sol_dT;
-	m.sol_dT = 10.e-9;
-	m.proc_step = &tlm_proc_step;
+	usual_dT = S->m.sol_dT;
+	S->m.sol_dT = 10.e-9;
+	S->m.proc_step = &tlm_proc_step;
 
 	/* Collect telemetry in three PWM cycle.
 	 * */
-	blm_update(&m);
-	blm_update(&m);
-	blm_update(&m);
+	blm_update(&S->m);
+	blm_update(&S->m);
+	blm_update(&S->m);
 
-	fclose(tlm.fd_pwm);
+	fclose(S->tlm.fd_pwm);
 
-	m.sol_dT = usual_dT;
-	m.proc_step = NULL;
+	S->m.sol_dT = usual_dT;
+	S->m.proc_step = NULL;
 }
 
-void tlm_restart()
+void tlm_restart(sim_t *S)
 {
-	if (tlm.fd_tlm == NULL) {
-
-		tlm.fd_tlm = fopen(TLM_FILE, "wb");
+	if (S->tlm.fd_tlm == NULL) {
 
-		if (tlm.fd_tlm == NULL) {
+		S->tlm.fd_tlm = sim_fopen(S, TLM_FILE, "wb");
+		S->tlm.fd_gp = sim_fopen(S, AGP_FILE, "w");
+	}
+	else {
+		S->tlm.fd_tlm = freopen(NULL, "wb", S->tlm.fd_tlm);
+	}
+}
 
-			fprintf(stderr, "fopen: %s\n", strerror(errno));
-			abort();
-		}
+void tlm_stop(sim_t *S)
+{
+	if (S->tlm.fd_gp != NULL) {
 
-		tlm.fd_gp = fopen(AGP_FILE, "w");
+		fclose(S->tlm.fd_gp);
+		S->tlm.fd_gp = NULL;
+	}
 
-		if (tlm.fd_gp == NULL) {
+	if (S->tlm.fd_tlm != NULL) {
 
-			fprintf(stderr, "fopen: %s\n", strerror(errno));
-			abort();
-		}
+		fclose(S->tlm.fd_tlm);
+		S->tlm.fd_tlm = NULL;
 	}
-	else {
-		tlm.fd_tlm = freopen(NULL, "wb", tlm.fd_tlm);
+}
+
+void sim_fault(sim_t *S)
+{
+	if (S != NULL && S->fault != NULL) {
+
+		longjmp(*S->fault, 1);
 	}
 }
 
-void sim_runtime(double dT)
+void sim_feedback(sim_t *S, pmfb_t *fb)
+{
+	fb->current_A = S->m.analog_iA;
+	fb->current_B = S->m.analog_iB;
+	fb->current_C = S->m.analog_iC;
+	fb->voltage_U = S->m.analog_uS;
+	fb->voltage_A = S->m.analog_uA;
+	fb->voltage_B = S->m.analog_uB;
+	fb->voltage_C = S->m.analog_uC;
+
+	fb->analog_SIN = S->m.analog_SIN;
+	fb->analog_COS = S->m.analog_COS;
+
+	fb->pulse_HS = S->m.pulse_HS;
+	fb->pulse_EP = S->m.pulse_EP;
+}
+
+void sim_runtime(sim_t *S, double dT)
 {
 	pmfb_t		fb;
 	double		stop;
 
-	stop = m.time + dT;
+	stop = S->m.time + dT;
 
-	while (m.time < stop) {
+	/* Plant callbacks have no context argument.
+	 * */
+	sim_local = S;
+
+	while (S->m.time < stop) {
 
 		/* Plant model update.
 		 * */
-		blm_update(&m);
-
-		fb.current_A = m.analog_iA;
-		fb.current_B = m.analog_iB;
-		fb.current_C = m.analog_iC;
-		fb.voltage_U = m.analog_uS;
-		fb.voltage_A = m.analog_uA;
-		fb.voltage_B = m.analog_uB;
-		fb.voltage_C = m.analog_uC;
-
-		fb.analog_SIN = m.analog_SIN;
-		fb.analog_COS = m.analog_COS;
+		blm_update(&S->m);
 
-		fb.pulse_HS = m.pulse_HS;
-		fb.pulse_EP = m.pulse_EP;
+		sim_feedback(S, &fb);
 
 		/* PM update.
 		 * */
-		pm_feedback(&pm, &fb);
+		pm_feedback(&S->pm, &fb);
 
-		if (tlm.fd_tlm != NULL) {
+		/* Worker task.
+		 * */
+		pm_defer(&S->pm);
+
+		if (S->tlm.fd_tlm != NULL) {
 
 			/* Collect telemetry.
 			 * */
-			tlm_plot_grab();
+			tlm_plot_grab(S);
 		}
 
-		if (pm.fsm_errno != PM_OK) {
+		if (S->pm.fsm_errno != PM_OK) {
 
-			fprintf(stderr, "fsm_errno: %s\n", pm_strerror(pm.fsm_errno));
+			fprintf(stderr, "fsm_errno: %s\n", pm_strerror(S->pm.fsm_errno));
 
-			if (tlm.fd_tlm != NULL) {
+			if (S->tlm.fd_tlm != NULL) {
 
-				fclose(tlm.fd_tlm);
+				fclose(S->tlm.fd_tlm);
+				S->tlm.fd_tlm = NULL;
 			}
 
+			sim_fault(S);
 			abort();
 		}
 	}
 }
 
-void bench_script()
+void bench_script(sim_t *S)
 {
-	blm_enable(&m);
-	blm_restart(&m);
+	blm_enable(&S->m);
+	blm_restart(&S->m);
 
-	tlm_restart();
+	tlm_restart(S);
 
-	m.Rs = 20.e-3;
-	m.Ld = 15.e-6;
-	m.Lq = 25.e-6;
-	m.Udc = 49.;
-	m.Rdc = 0.1;
-	m.Zp = 5;
-	m.lambda = blm_Kv_lambda(&m, 58.);
-	m.Jm = 17.e-3;
+	S->m.Rs = 20.e-3;
+	S->m.Ld = 15.e-6;
+	S->m.Lq = 25.e-6;
+	S->m.Udc = 49.;
+	S->m.Rdc = 0.1;
+	S->m.Zp = 5;
+	S->m.lambda = blm_Kv_lambda(&S->m, 58.);
+	S->m.Jm = 17.e-3;
 
-	ts_script_default();
-	ts_script_base();
-	blm_restart(&m);
+	ts_script_default(S);
+	ts_script_base(S);
+	blm_restart(&S->m);
 
-	m.Jm = 5.e+7;
+	S->m.Jm = 5.e+7;
 
-	pm.fsm_req = PM_STATE_PROBE_CONST_SATURATION;
-	ts_wait_IDLE();
+	S->pm.fsm_req = PM_STATE_PROBE_CONST_SATURATION;
+	ts_wait_IDLE(S);
 
-	printf("const_im_Ld = %.4e (H)\n", pm.const_im_Ld);
-	printf("const_im_Lq = %.4e (H)\n", pm.const_im_Lq);
+	fprintf(S->fd_log, "const_im_Ld = %.4e (H)\n", S->pm.const_im_Ld);
+	fprintf(S->fd_log, "const_im_Lq = %.4e (H)\n", S->pm.const_im_Lq);
 
-	pm.fsm_req = PM_STATE_PROBE_CONST_RESISTANCE;
-	ts_wait_IDLE();
+	S->pm.fsm_req = PM_STATE_PROBE_CONST_RESISTANCE;
+	ts_wait_IDLE(S);
 
-	pm.const_Rs = pm.const_im_Rz;
+	S->pm.const_Rs = S->pm.const_im_Rz;
 
-	printf("const_Rs = %.4e (Ohm)\n", pm.const_Rs);
-	printf("self_DTu = %.4f (V)\n", pm.self_DTu);
+	fprintf(S->fd_log, "const_Rs = %.4e (Ohm)\n", S->pm.const_Rs);
+	fprintf(S->fd_log, "self_DTu = %.4f (V)\n", S->pm.self_DTu);
 
-	/*ts_adjust_sensor_hall();
-	blm_restart(&m);
+	/*ts_adjust_sensor_hall(S);
+	blm_restart(&S->m);
 
-	pm.config_LU_SENSOR = PM_SENSOR_HALL;
+	S->pm.config_LU_SENSOR = PM_SENSOR_HALL;
 
-	pm.watt_wA_maximal = 80.f;
-	pm.watt_wA_reverse = 80.f;
+	S->pm.watt_wA_maximal = 80.f;
+	S->pm.watt_wA_reverse = 80.f;
 
-	pm.fsm_req = PM_STATE_LU_STARTUP;
-	ts_wait_IDLE();
+	S->pm.fsm_req = PM_STATE_LU_STARTUP;
+	ts_wait_IDLE(S);
 
-	pm.s_setpoint_speed = 800.f;
-	sim_runtime(2.0);*/
+	S->pm.s_setpoint_speed = 800.f;
+	sim_runtime(S, 2.0);*/
 
-	tlm_PWM_grab();
+	tlm_PWM_grab(S);
 }
 
-void mld_script()
+void mld_script(sim_t *S)
 {
-	blm_enable(&m);
-	blm_restart(&m);
+	char		name[80];
+	float		kS = 1.f;
+
+	blm_enable(&S->m);
+	blm_restart(&S->m);
+
+	tlm_restart(S);
 
-	tlm_restart();
+	S->m.Rs = 14.e-3;
+	S->m.Ld = 10.e-6;
+	S->m.Lq = 15.e-6;
+	S->m.Udc = 22.;
+	S->m.Rdc = 0.1;
+	S->m.Zp = 14;
+	S->m.lambda = blm_Kv_lambda(&S->m, 270.);
+	S->m.Jm = 4.e-4;
 
-	m.Rs = 14.e-3;
-	m.Ld = 10.e-6;
-	m.Lq = 15.e-6;
-	m.Udc = 22.;
-	m.Rdc = 0.1;
-	m.Zp = 14;
-	m.lambda = blm_Kv_lambda(&m, 270.);
-	m.Jm = 4.e-4;
+	ts_script_default(S);
+	ts_script_base(S);
+	blm_restart(&S->m);
 
-	ts_script_default();
-	ts_script_base();
-	blm_restart(&m);
+	S->pm.config_LU_ESTIMATE = PM_FLUX_KALMAN;
+	S->pm.config_HFI_WAVETYPE = PM_HFI_SINE;
 
-	pm.config_LU_ESTIMATE = PM_FLUX_KALMAN;
-	pm.config_HFI_WAVETYPE = PM_HFI_SINE;
+	S->pm.fsm_req = PM_STATE_LU_STARTUP;
+	ts_wait_IDLE(S);
 
-	pm.fsm_req = PM_STATE_LU_STARTUP;
-	ts_wait_IDLE();
+	if (S->unit != 0) {
 
-	pm.s_setpoint_speed = 60.f;
-	sim_runtime(1.0);
+		/* Each unit runs a bit different speed profile.
+		 * */
+		kS = 1.f + 0.3f * (float) lfg_urand();
+	}
 
-	tlm.fd_mld = fopen(MLD_FILE, "wb");
+	S->pm.s_setpoint_speed = 60.f * kS;
+	sim_runtime(S, 1.0);
 
-	if (tlm.fd_mld == NULL) {
+	sim_fname(S, MLD_FILE, name);
 
-		fprintf(stderr, "fopen: %s\n", strerror(errno));
+	S->tlm.mld = mld_open(name, MLD_CHAN_N, mld_chan,
+			1. / S->m.pwm_dT, MLD_COMPRESS_LZ4);
+
+	if (S->tlm.mld == NULL) {
+
+		abort();
+	}
+
+	S->pm.s_setpoint_speed = 60.f * kS;
+	sim_runtime(S, 1.0);
+
+	S->pm.s_setpoint_speed = 900.f * kS;
+	sim_runtime(S, 1.0);
+
+	S->pm.s_setpoint_speed = - 60.f * kS;
+	sim_runtime(S, 1.0);
+
+	S->pm.s_setpoint_speed = - 900.f * kS;
+	sim_runtime(S, 1.0);
+
+	S->pm.s_setpoint_speed = 5500.f * kS;
+	sim_runtime(S, 2.0);
+
+	mld_close(S->tlm.mld);
+	S->tlm.mld = NULL;
+}
+
+typedef struct {
+
+	sim_t		sim;
+
+	char		*log_buf;
+	size_t		log_len;
+
+	int		seed;
+}
+mld_unit_t;
+
+static void *
+mld_thread(void *arg)
+{
+	mld_unit_t	*un = (mld_unit_t *) arg;
+	sim_t		*S = &un->sim;
+
+	lfg_start(un->seed);
+
+	S->fd_log = open_memstream(&un->log_buf, &un->log_len);
+
+	mld_script(S);
+	tlm_stop(S);
+
+	fclose(S->fd_log);
+
+	return NULL;
+}
+
+void mld_script_pool(int njobs, int solver)
+{
+	mld_unit_t	*un;
+	pthread_t	*thread;
+	int		N, seed;
+
+	un = calloc(njobs, sizeof(mld_unit_t));
+	thread = calloc(njobs, sizeof(pthread_t));
+
+	if (un == NULL || thread == NULL) {
+
+		fprintf(stderr, "calloc: %s\n", strerror(errno));
 		abort();
 	}
 
-	pm.s_setpoint_speed = 60.f;
-	sim_runtime(1.0);
+	seed = (int) time(NULL);
 
-	pm.s_setpoint_speed = 900.f;
-	sim_runtime(1.0);
+	/* Each unit writes its own dataset file.
+	 * */
+	for (N = 0; N < njobs; ++N) {
 
-	pm.s_setpoint_speed = - 60.f;
-	sim_runtime(1.0);
+		un[N].sim.unit = N + 1;
+		un[N].sim.m.solver = solver;
+		un[N].seed = seed + N;
 
-	pm.s_setpoint_speed = - 900.f;
-	sim_runtime(1.0);
+		pthread_create(&thread[N], NULL, &mld_thread, &un[N]);
+	}
+
+	for (N = 0; N < njobs; ++N) {
 
-	pm.s_setpoint_speed = 5500.f;
-	sim_runtime(2.0);
+		pthread_join(thread[N], NULL);
+
+		fwrite(un[N].log_buf, 1, un[N].log_len, stdout);
+		free(un[N].log_buf);
+	}
 
-	fclose(tlm.fd_mld);
+	free(un);
+	free(thread);
 }
 
 int main(int argc, char *argv[])
 {
+	static sim_t	sim;
+
+	int		njobs = 1, solver = BLM_SOLVER_HEUN, rc = 0, i;
+
 	if (argc < 2) {
 
 		abort();
 	}
 
+	for (i = 2; i < argc - 1; i += 2) {
+
+		if (strcmp(argv[i], "-j") == 0) {
+
+			njobs = atoi(argv[i + 1]);
+			njobs = (njobs < 1) ? 1 : njobs;
+		}
+		else if (strcmp(argv[i], "-s") == 0) {
+
+			if (strcmp(argv[i + 1], "heun") == 0) {
+
+				solver = BLM_SOLVER_HEUN;
+			}
+			else if (strcmp(argv[i + 1], "exact") == 0) {
+
+				solver = BLM_SOLVER_EXACT;
+			}
+			else if (strcmp(argv[i + 1], "rk45") == 0) {
+
+				solver = BLM_SOLVER_RK45;
+			}
+			else {
+				fprintf(stderr, "unknown solver: %s\n", argv[i + 1]);
+				abort();
+			}
+		}
+	}
+
 	lfg_start((int) time(NULL));
 
+	sim.m.solver = solver;
+	sim.fd_log = stdout;
+
 	if (strcmp(argv[1], "test") == 0) {
 
-		ts_script_test();
+		ts_script_test(njobs, solver);
 	}
 	else if (strcmp(argv[1], "bench") == 0) {
 
-		bench_script();
+		bench_script(&sim);
 	}
 	else if (strcmp(argv[1], "data") == 0) {
 
-		mld_script();
+		if (njobs > 1) {
+
+			mld_script_pool(njobs, solver);
+		}
+		else {
+			mld_script(&sim);
+		}
 	}
+	else if (strcmp(argv[1], "perf") == 0) {
 
-	if (tlm.fd_tlm != NULL) {
+		perf_script();
+	}
+	else if (strcmp(argv[1], "batch") == 0) {
 
-		fclose(tlm.fd_tlm);
+		batch_script();
 	}
+	else if (strcmp(argv[1], "step") == 0) {
 
-	return 0;
-}
+		step_script();
+	}
+	else if (strcmp(argv[1], "replay") == 0 && argc > 2) {
+
+		replay_script(argv[argc - 1]);
+	}
+	else if (strcmp(argv[1], "sweep") == 0 && argc > 3) {
 
+		sweep_script(njobs, argv[argc - 2], argv[argc - 1]);
+	}
+	else if (strcmp(argv[1], "run") == 0) {
+
+		/* Options go first then the list of scenario files.
+		 * */
+		for (i = 2; i < argc - 1 && argv[i][0] == '-'; i += 2) ;
+
+		rc = (scene_script(njobs, solver, argc - i, argv + i) != 0) ? 1 : 0;
+	}
+
+	tlm_stop(&sim);
+
+	return rc;
+}
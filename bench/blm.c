@@ -1,5 +1,6 @@
 #include <stddef.h>
 #include <math.h>
+#include <complex.h>
 
 #include "blm.h"
 #include "lfg.h"
@@ -49,6 +50,18 @@ void blm_enable(blm_t *m)
 
 	m->time = 0.;		/* Simulation TIME (Second) */
 	m->sol_dT = 5.e-6;	/* ODE solver step (Second) */
+	m->sol_tol = 1.e-7;	/* Adaptive solver tolerance */
+
+	/* Thermal and DC link macro step (Second). These equations are
+	 * held constant over electrical steps and updated at the end of
+	 * PWM cycle when the macro step is elapsed. Zero value is to solve
+	 * them together with electrical equations.
+	 * */
+	m->slow_dT = 0.;
+
+	/* NOTE: ODE solver type (m->solver) is not reset here so it can be
+	 * selected from the command line before the script starts.
+	 * */
 
 	m->pwm_dT = 35.e-6;		/* PWM cycle (Second)    */
 	m->pwm_deadtime = 90.e-9;	/* PWM deadtime (Second) */
@@ -150,6 +163,13 @@ void blm_restart(blm_t *m)
 {
 	m->unsync_flag = 0;
 
+	m->sol_h = m->sol_dT;
+
+	m->slow_T = 0.;
+	m->slow_wJ = 0.;
+	m->slow_wH = 0.;
+	m->slow_hP = 0.;
+
 	m->state[0] = 0.;	/* Axis D current (Ampere) */
 	m->state[1] = 0.;	/* Axis Q current (Ampere) */
 	m->state[2] = 0.;	/* Electrical Speed (Radian/Sec) */
@@ -192,22 +212,19 @@ void blm_restart(blm_t *m)
 }
 
 static void
-blm_equation(const blm_t *m, const double state[7], double y[7])
+blm_equation_DQ(const blm_t *m, const double state[7], double eD, double eQ, double y[7])
 {
-	double		uA, uB, uD, uQ, Rs, lambda, mP, mQ, mS;
+	double		uD, uQ, Rs, lambda, mP, mQ, mS;
 
 	/* Thermal drift.
 	 * */
 	Rs = m->Rs * (1. + 3.93E-3 * (state[4] - m->Ta));
 	lambda = m->lambda * (1. - 1.20E-3 * (state[4] - m->Ta));
 
-	/* Voltage from VSI.
+	/* Voltage from VSI (eD, eQ are relative to DC link).
 	 * */
-	uQ = (m->xfet[0] + m->xfet[1] + m->xfet[2]) / 3.;
-	uA = (m->xfet[0] - uQ) * state[6];
-	uB = (m->xfet[1] - uQ) * state[6];
-
-	blm_AB_DQ(state[3], uA, uB, &uD, &uQ);
+	uD = eD * state[6];
+	uQ = eQ * state[6];
 
 	/* Energy consumption equation.
 	 * */
@@ -215,7 +232,8 @@ blm_equation(const blm_t *m, const double state[7], double y[7])
 
 	/* DC link voltage equation.
 	 * */
-	y[6] = ((m->Udc - state[6]) / m->Rdc - y[5] / state[6]) / m->Cdc;
+	y[6] = (m->slow_dT > 0.) ? 0.
+		: ((m->Udc - state[6]) / m->Rdc - y[5] / state[6]) / m->Cdc;
 
 	/* Electrical equations of PMSM.
 	 * */
@@ -242,17 +260,88 @@ blm_equation(const blm_t *m, const double state[7], double y[7])
 
 	/* Thermal equation.
 	 * */
-	y[4] = (1.5f * Rs * (state[0] * state[0] + state[1] * state[1])
+	y[4] = (m->slow_dT > 0.) ? 0.
+		: (1.5f * Rs * (state[0] * state[0] + state[1] * state[1])
 			+ (m->Ta - state[4]) / m->Rt) / m->Ct;
 }
 
 static void
-blm_ode_step(blm_t *m, double dT)
+blm_equation(const blm_t *m, const double state[7], double y[7])
 {
-	double		x0[7], y0[7], y1[7];
+	double		eA, eB, eD, eQ;
+
+	/* Voltage from VSI.
+	 * */
+	eQ = (m->xfet[0] + m->xfet[1] + m->xfet[2]) / 3.;
+	eA = m->xfet[0] - eQ;
+	eB = m->xfet[1] - eQ;
+
+	blm_AB_DQ(state[3], eA, eB, &eD, &eQ);
+
+	blm_equation_DQ(m, state, eD, eQ, y);
+}
 
+static void
+blm_sensor_step(blm_t *m, double dT)
+{
 	double		iA, iB, iC, uA, uB, uC;
-	double		kA, kB, uMIN;
+	double		kA, kB, uMIN, hP;
+
+	/* Sensor transient (FAST).
+	 * */
+	kA = 1.0 - exp(- dT / m->tau_A);
+	kB = 1.0 - exp(- dT / m->tau_B);
+
+	blm_DQ_ABC(m->state[3], m->state[0], m->state[1], &iA, &iB, &iC);
+
+	m->state[7] += (iA - m->state[7]) * kA;
+	m->state[8] += (iB - m->state[8]) * kA;
+	m->state[9] += (iC - m->state[9]) * kA;
+
+	if (m->pwm_Z != BLM_Z_DETACHED) {
+
+		uA = m->xfet[0] * m->state[6];
+		uB = m->xfet[1] * m->state[6];
+		uC = m->xfet[2] * m->state[6];
+	}
+	else {
+		blm_DQ_ABC(m->state[3], 0., m->lambda * m->state[2], &uA, &uB, &uC);
+
+		uMIN = (uA < uB) ? uA : uB;
+		uMIN = (uMIN < uC) ? uMIN : uC;
+
+		uA += - uMIN;
+		uB += - uMIN;
+		uC += - uMIN;
+	}
+
+	m->state[10] += (m->state[6]  - m->state[10]) * kA;
+	m->state[11] += (m->state[10] - m->state[11]) * kB;
+	m->state[12] += (uA - m->state[12]) * kB;
+	m->state[13] += (uB - m->state[13]) * kB;
+	m->state[14] += (uC - m->state[14]) * kB;
+
+	if (m->slow_dT > 0.) {
+
+		/* Heat losses for the thermal macro step (SLOW).
+		 * */
+		hP = 1.5 * m->Rs * (1. + 3.93E-3 * (m->state[4] - m->Ta))
+			* (m->state[0] * m->state[0] + m->state[1] * m->state[1]);
+
+		m->slow_wH += (m->slow_hP + hP) * dT / 2.;
+		m->slow_hP = hP;
+	}
+
+	if (m->proc_step != NULL) {
+
+		m->proc_step(dT);
+	}
+}
+
+static void
+blm_ode_step(blm_t *m, double dT)
+{
+	double		x0[7], y0[7], y1[7];
 
 	/* Second-order ODE solver.
 	 * */
@@ -293,43 +382,284 @@ blm_ode_step(blm_t *m, double dT)
 	m->state[5] += (y0[5] + y1[5]) * dT / 2.;
 	m->state[6] += (y0[6] + y1[6]) * dT / 2.;
 
-	/* Sensor transient (FAST).
+	blm_sensor_step(m, dT);
+
+	m->sol_nstep++;
+}
+
+static void
+blm_exact_current(const blm_t *m, double complex eF, double complex eW,
+		double dT, double iDQ[2])
+{
+	double complex	cD, cQ, zD, zQ, zDET;
+
+	double		Rs, lambda, wS, a, b, c, d, fQ;
+	double		hS, q, r, eH, kC, kS, iC[2], x0[2];
+
+	/* Thermal drift.
 	 * */
-	kA = 1.0 - exp(- dT / m->tau_A);
-	kB = 1.0 - exp(- dT / m->tau_B);
+	Rs = m->Rs * (1. + 3.93E-3 * (m->state[4] - m->Ta));
+	lambda = m->lambda * (1. - 1.20E-3 * (m->state[4] - m->Ta));
 
-	blm_DQ_ABC(m->state[3], m->state[0], m->state[1], &iA, &iB, &iC);
+	wS = m->state[2];
 
-	m->state[7] += (iA - m->state[7]) * kA;
-	m->state[8] += (iB - m->state[8]) * kA;
-	m->state[9] += (iC - m->state[9]) * kA;
+	/* We hold the speed, DC link voltage and temperature over the
+	 * interval. So the electrical equations of PMSM are linear
+	 * x' = A * x + f(t) and we solve it in closed form.
+	 * */
+	a = - Rs / m->Ld;
+	b = wS * m->Lq / m->Ld;
+	c = - wS * m->Ld / m->Lq;
+	d = - Rs / m->Lq;
+
+	/* Forced response on the EMF term.
+	 * */
+	fQ = - lambda * wS / m->Lq;
+
+	iC[0] = b * fQ / (a * d - b * c);
+	iC[1] = - a * fQ / (a * d - b * c);
+
+	/* Forced response on the VSI voltage that is rotating in DQ frame
+	 * as Re(c * exp(- j * wS * t)).
+	 * */
+	cD = eF / m->Ld;
+	cQ = - I * eF / m->Lq;
+
+	zDET = (- I * wS - a) * (- I * wS - d) - b * c;
+	zDET = conj(zDET) / (creal(zDET) * creal(zDET) + cimag(zDET) * cimag(zDET));
+
+	zD = ((- I * wS - d) * cD + b * cQ) * zDET;
+	zQ = (c * cD + (- I * wS - a) * cQ) * zDET;
+
+	/* Free response exp(A * dT) applied to initial deviation.
+	 * */
+	x0[0] = m->state[0] - iC[0] - creal(zD);
+	x0[1] = m->state[1] - iC[1] - creal(zQ);
+
+	hS = (a + d) / 2.;
+	q = (a - d) * (a - d) / 4. + b * c;
+
+	if (q > 0.) {
+
+		r = sqrt(q);
+		kC = cosh(r * dT);
+		kS = (r * dT > 1E-8) ? sinh(r * dT) / r : dT;
+	}
+	else {
+		r = sqrt(- q);
+		kC = cos(r * dT);
+		kS = (r * dT > 1E-8) ? sin(r * dT) / r : dT;
+	}
+
+	eH = exp(hS * dT);
+
+	iDQ[0] = eH * (kC * x0[0] + kS * ((a - hS) * x0[0] + b * x0[1]))
+		+ iC[0] + creal(zD * eW);
+
+	iDQ[1] = eH * (kC * x0[1] + kS * (c * x0[0] + (d - hS) * x0[1]))
+		+ iC[1] + creal(zQ * eW);
+}
+
+static void
+blm_exact_step(blm_t *m, double dT)
+{
+	double		x0[7], y0[7], y1[7];
+	double		eA, eB, eX, eY, tS, tC, wS, wC, eD, eQ;
+
+	/* Exact current propagation and second-order solver for the
+	 * rest of the state.
+	 * */
+
+	eX = (m->xfet[0] + m->xfet[1] + m->xfet[2]) / 3.;
+	eA = m->xfet[0] - eX;
+	eB = m->xfet[1] - eX;
+
+	eX = eA;
+	eY = 0.577350269189626 * eA + 1.15470053837925 * eB;
+
+	/* We take the rotor angle at the end of interval as rotated by the
+	 * initial speed. Thus trigonometry is evaluated only once.
+	 * */
+	tS = sin(m->state[3]);
+	tC = cos(m->state[3]);
+
+	wS = sin(m->state[2] * dT);
+	wC = cos(m->state[2] * dT);
+
+	eD = tC * eX + tS * eY;
+	eQ = tC * eY - tS * eX;
+
+	blm_equation_DQ(m, m->state, eD, eQ, y0);
+
+	x0[2] = m->state[2] + y0[2] * dT;
+	x0[3] = m->state[3] + y0[3] * dT;
+	x0[4] = m->state[4] + y0[4] * dT;
+	x0[5] = m->state[5] + y0[5] * dT;
+	x0[6] = m->state[6] + y0[6] * dT;
 
 	if (m->pwm_Z != BLM_Z_DETACHED) {
 
-		uA = m->xfet[0] * m->state[6];
-		uB = m->xfet[1] * m->state[6];
-		uC = m->xfet[2] * m->state[6];
+		/* DC link voltage is taken at the middle of interval.
+		 * */
+		blm_exact_current(m, (eD + I * eQ) * (m->state[6] + x0[6]) / 2.,
+				wC - I * wS, dT, x0);
 	}
 	else {
-		blm_DQ_ABC(m->state[3], 0., m->lambda * m->state[2], &uA, &uB, &uC);
+		x0[0] = 0.;
+		x0[1] = 0.;
+	}
 
-		uMIN = (uA < uB) ? uA : uB;
-		uMIN = (uMIN < uC) ? uMIN : uC;
+	eD = wC * tC - wS * tS;
+	tS = wC * tS + wS * tC;
+	tC = eD;
 
-		uA += - uMIN;
-		uB += - uMIN;
-		uC += - uMIN;
+	eD = tC * eX + tS * eY;
+	eQ = tC * eY - tS * eX;
+
+	blm_equation_DQ(m, x0, eD, eQ, y1);
+
+	m->state[0] = x0[0];
+	m->state[1] = x0[1];
+
+	m->state[2] += (y0[2] + y1[2]) * dT / 2.;
+	m->state[3] += (y0[3] + y1[3]) * dT / 2.;
+	m->state[4] += (y0[4] + y1[4]) * dT / 2.;
+	m->state[5] += (y0[5] + y1[5]) * dT / 2.;
+	m->state[6] += (y0[6] + y1[6]) * dT / 2.;
+
+	blm_sensor_step(m, dT);
+
+	m->sol_nstep++;
+}
+
+static void
+blm_rk45_equation(const blm_t *m, const double state[7], double y[7])
+{
+	blm_equation(m, state, y);
+
+	if (m->pwm_Z == BLM_Z_DETACHED) {
+
+		y[0] = 0.;
+		y[1] = 0.;
 	}
+}
 
-	m->state[10] += (m->state[6]  - m->state[10]) * kA;
-	m->state[11] += (m->state[10] - m->state[11]) * kB;
-	m->state[12] += (uA - m->state[12]) * kB;
-	m->state[13] += (uB - m->state[13]) * kB;
-	m->state[14] += (uC - m->state[14]) * kB;
+static void
+blm_rk45_solve(blm_t *m, double dT)
+{
+	/* Dormand-Prince coefficients.
+	 * */
+	const double	a21 = 1. / 5.,
+			a31 = 3. / 40., a32 = 9. / 40.,
+			a41 = 44. / 45., a42 = - 56. / 15., a43 = 32. / 9.,
+			a51 = 19372. / 6561., a52 = - 25360. / 2187.,
+			a53 = 64448. / 6561., a54 = - 212. / 729.,
+			a61 = 9017. / 3168., a62 = - 355. / 33., a63 = 46732. / 5247.,
+			a64 = 49. / 176., a65 = - 5103. / 18656.,
+			b1 = 35. / 384., b3 = 500. / 1113., b4 = 125. / 192.,
+			b5 = - 2187. / 6784., b6 = 11. / 84.,
+			e1 = 71. / 57600., e3 = - 71. / 16695., e4 = 71. / 1920.,
+			e5 = - 17253. / 339200., e6 = 22. / 525., e7 = - 1. / 40.;
+
+	double		k1[7], k2[7], k3[7], k4[7], k5[7], k6[7], k7[7];
+	double		x0[7], x5[7], h, hmax, rel, err, fix;
+	int		i, fsal = 0;
+
+	/* The VSI state is constant until the next event so we are free
+	 * to take any steps inside the interval. Step size is kept from
+	 * interval to interval.
+	 * */
+	hmax = (m->proc_step != NULL) ? m->sol_dT : dT;
 
-	if (m->proc_step != NULL) {
+	if (m->pwm_Z == BLM_Z_DETACHED) {
 
-		m->proc_step(dT);
+		m->state[0] = 0.;
+		m->state[1] = 0.;
+	}
+
+	while (dT > 0.) {
+
+		h = (m->sol_h < hmax) ? m->sol_h : hmax;
+		h = (h < dT) ? h : dT;
+
+		if (fsal == 0) {
+
+			blm_rk45_equation(m, m->state, k1);
+		}
+
+		for (i = 0; i < 7; ++i) { x0[i] = m->state[i] + h * (a21 * k1[i]); }
+
+		blm_rk45_equation(m, x0, k2);
+
+		for (i = 0; i < 7; ++i) { x0[i] = m->state[i] + h * (a31 * k1[i]
+					+ a32 * k2[i]); }
+
+		blm_rk45_equation(m, x0, k3);
+
+		for (i = 0; i < 7; ++i) { x0[i] = m->state[i] + h * (a41 * k1[i]
+					+ a42 * k2[i] + a43 * k3[i]); }
+
+		blm_rk45_equation(m, x0, k4);
+
+		for (i = 0; i < 7; ++i) { x0[i] = m->state[i] + h * (a51 * k1[i]
+					+ a52 * k2[i] + a53 * k3[i] + a54 * k4[i]); }
+
+		blm_rk45_equation(m, x0, k5);
+
+		for (i = 0; i < 7; ++i) { x0[i] = m->state[i] + h * (a61 * k1[i]
+					+ a62 * k2[i] + a63 * k3[i] + a64 * k4[i]
+					+ a65 * k5[i]); }
+
+		blm_rk45_equation(m, x0, k6);
+
+		for (i = 0; i < 7; ++i) { x5[i] = m->state[i] + h * (b1 * k1[i]
+					+ b3 * k3[i] + b4 * k4[i] + b5 * k5[i]
+					+ b6 * k6[i]); }
+
+		blm_rk45_equation(m, x5, k7);
+
+		/* Local error estimate relative to the state magnitude.
+		 * */
+		err = 0.;
+
+		for (i = 0; i < 7; ++i) {
+
+			rel = h * (e1 * k1[i] + e3 * k3[i] + e4 * k4[i]
+					+ e5 * k5[i] + e6 * k6[i] + e7 * k7[i]);
+
+			rel = fabs(rel) / (m->sol_tol * (1. + fabs(x5[i])));
+			err = (err < rel) ? rel : err;
+		}
+
+		/* Step size control.
+		 * */
+		fix = (err > 1E-10) ? 0.9 * pow(err, - 0.2) : 5.;
+		fix = (fix < 0.2) ? 0.2 : (fix > 5.) ? 5. : fix;
+
+		if (err <= 1. || h < 1E-12) {
+
+			for (i = 0; i < 7; ++i) {
+
+				m->state[i] = x5[i];
+				k1[i] = k7[i];
+			}
+
+			fsal = 1;
+			dT -= h;
+
+			blm_sensor_step(m, h);
+
+			m->sol_nstep++;
+			m->sol_emax = (m->sol_emax < err) ? err : m->sol_emax;
+
+			/* Do not shrink the step because of short interval.
+			 * */
+			m->sol_h = (h < m->sol_h && fix > 1.) ? m->sol_h : h * fix;
+		}
+		else {
+			m->sol_nfail++;
+			m->sol_h = h * fix;
+		}
 	}
 }
 
@@ -385,15 +715,37 @@ blm_solve(blm_t *m, double dT)
 		m->state[10] += lfg_gauss() * 2.;
 	}
 
-	/* Divide the long interval.
-	 * */
-	while (dT > m->sol_dT) {
+	if (m->solver == BLM_SOLVER_RK45) {
 
-		blm_ode_step(m, m->sol_dT);
-		dT -= m->sol_dT;
+		blm_rk45_solve(m, dT);
 	}
+	else if (m->solver == BLM_SOLVER_EXACT) {
 
-	blm_ode_step(m, dT);
+		/* Do one step from event to event unless the fine
+		 * resolution is requested by telemetry.
+		 * */
+		if (m->proc_step != NULL) {
+
+			while (dT > m->sol_dT) {
+
+				blm_exact_step(m, m->sol_dT);
+				dT -= m->sol_dT;
+			}
+		}
+
+		blm_exact_step(m, dT);
+	}
+	else {
+		/* Divide the long interval.
+		 * */
+		while (dT > m->sol_dT) {
+
+			blm_ode_step(m, m->sol_dT);
+			dT -= m->sol_dT;
+		}
+
+		blm_ode_step(m, dT);
+	}
 
 	if (m->state[3] < - M_PI) {
 
@@ -413,6 +765,32 @@ blm_solve(blm_t *m, double dT)
 	m->xfet[5] = m->xfet[2];
 }
 
+static void
+blm_slow_step(blm_t *m)
+{
+	double		dT, wP, wH, xF;
+
+	/* Thermal and DC link equations are linear if we take the average
+	 * losses and current over macro step. So we solve them in closed
+	 * form that is stable for any macro step.
+	 * */
+	dT = m->slow_T;
+
+	wH = m->slow_wH / dT;
+	xF = m->Ta + wH * m->Rt;
+
+	m->state[4] = xF + (m->state[4] - xF) * exp(- dT / (m->Rt * m->Ct));
+
+	wP = m->slow_wJ / dT;
+	xF = m->Udc - m->Rdc * wP / m->state[6];
+
+	m->state[6] = xF + (m->state[6] - xF) * exp(- dT / (m->Rdc * m->Cdc));
+
+	m->slow_T = 0.;
+	m->slow_wJ = 0.;
+	m->slow_wH = 0.;
+}
+
 static double
 blm_ADC(double vconv, double vmin, double vmax)
 {
@@ -706,6 +1084,17 @@ blm_pwm_solve(blm_t *m)
 		blm_solve(m, dTu * (xMAX - level));
 	}
 
+	if (m->slow_dT > 0.) {
+
+		m->slow_T += m->pwm_dT;
+		m->slow_wJ += m->state[5];
+
+		if (m->slow_T >= m->slow_dT) {
+
+			blm_slow_step(m);
+		}
+	}
+
 	/* Get average POWER on PWM cycle.
 	 * */
 	m->drain_wP = m->state[5] / m->pwm_dT;
@@ -719,3 +1108,500 @@ void blm_update(blm_t *m)
 	m->time += m->pwm_dT;
 }
 
+
+void blm_batch_enable(blm_batch_t *mb, const blm_t *m)
+{
+	int		i;
+
+	/* All lanes start with parameters of the scalar model. You are free
+	 * to spread the machine parameters across lanes then.
+	 * */
+	mb->time = 0.;
+	mb->sol_dT = m->sol_dT;
+
+	mb->pwm_dT = m->pwm_dT;
+	mb->pwm_deadtime = m->pwm_deadtime;
+	mb->pwm_minimal = m->pwm_minimal;
+	mb->pwm_resolution = m->pwm_resolution;
+
+	mb->Dtol = m->Dtol;
+
+	for (i = 0; i < BLM_LANES; ++i) {
+
+		mb->Rs[i] = m->Rs;
+		mb->Ld[i] = m->Ld;
+		mb->Lq[i] = m->Lq;
+		mb->lambda[i] = m->lambda;
+		mb->Jm[i] = m->Jm;
+
+		mb->Mq[0][i] = m->Mq[0];
+		mb->Mq[1][i] = m->Mq[1];
+		mb->Mq[2][i] = m->Mq[2];
+		mb->Mq[3][i] = m->Mq[3];
+	}
+
+	mb->Zp = m->Zp;
+
+	mb->Ta = m->Ta;
+	mb->Ct = m->Ct;
+	mb->Rt = m->Rt;
+
+	mb->Udc = m->Udc;
+	mb->Rdc = m->Rdc;
+	mb->Cdc = m->Cdc;
+
+	mb->adc_Tconv = m->adc_Tconv;
+	mb->adc_Toffset = m->adc_Toffset;
+
+	mb->tau_A = m->tau_A;
+	mb->tau_B = m->tau_B;
+	mb->range_A = m->range_A;
+	mb->range_B = m->range_B;
+
+	mb->hall[0] = m->hall[0];
+	mb->hall[1] = m->hall[1];
+	mb->hall[2] = m->hall[2];
+
+	mb->eabi_ERES = m->eabi_ERES;
+	mb->eabi_WRAP = m->eabi_WRAP;
+	mb->eabi_Zq = m->eabi_Zq;
+
+	mb->analog_Zq = m->analog_Zq;
+}
+
+void blm_batch_restart(blm_batch_t *mb)
+{
+	int		i;
+
+	mb->sol_nstep = 0;
+
+	for (i = 0; i < BLM_LANES; ++i) {
+
+		mb->pwm_A[i] = 0;
+		mb->pwm_B[i] = 0;
+		mb->pwm_C[i] = 0;
+		mb->pwm_Z[i] = BLM_Z_NONE;
+
+		mb->state[0][i] = 0.;
+		mb->state[1][i] = 0.;
+		mb->state[2][i] = 0.;
+		mb->state[3][i] = 0.;
+		mb->state[4][i] = mb->Ta;
+		mb->state[5][i] = 0.;
+		mb->state[6][i] = mb->Udc;
+
+		mb->state[7][i] = 0.;
+		mb->state[8][i] = 0.;
+		mb->state[9][i] = 0.;
+		mb->state[10][i] = mb->Udc;
+		mb->state[11][i] = mb->Udc;
+		mb->state[12][i] = 0.;
+		mb->state[13][i] = 0.;
+		mb->state[14][i] = 0.;
+
+		mb->xfet[0][i] = 0.;
+		mb->xfet[1][i] = 0.;
+		mb->xfet[2][i] = 0.;
+
+		mb->revol[i] = 0;
+	}
+}
+
+static void
+blm_batch_equation(const blm_batch_t *mb, const double (*x)[BLM_LANES],
+		const double *eD, const double *eQ, double (*y)[BLM_LANES])
+{
+	double		uD, uQ, Rs, lambda, mP, mQ, mS;
+	int		i;
+
+	/* Same as blm_equation_DQ but across all lanes.
+	 * */
+	for (i = 0; i < BLM_LANES; ++i) {
+
+		Rs = mb->Rs[i] * (1. + 3.93E-3 * (x[4][i] - mb->Ta));
+		lambda = mb->lambda[i] * (1. - 1.20E-3 * (x[4][i] - mb->Ta));
+
+		uD = eD[i] * x[6][i];
+		uQ = eQ[i] * x[6][i];
+
+		y[5][i] = 1.5 * (x[0][i] * uD + x[1][i] * uQ);
+		y[6][i] = ((mb->Udc - x[6][i]) / mb->Rdc - y[5][i] / x[6][i]) / mb->Cdc;
+
+		uD += - Rs * x[0][i] + mb->Lq[i] * x[2][i] * x[1][i];
+		uQ += - Rs * x[1][i] - mb->Ld[i] * x[2][i] * x[0][i] - lambda * x[2][i];
+
+		y[0][i] = uD / mb->Ld[i];
+		y[1][i] = uQ / mb->Lq[i];
+
+		mP = 1.5 * mb->Zp * (lambda + (mb->Ld[i] - mb->Lq[i]) * x[0][i]) * x[1][i];
+
+		mS = x[2][i] / mb->Zp;
+		mQ = mb->Mq[0][i] - mS * (mb->Mq[1][i] + fabs(mS) * mb->Mq[2][i]);
+		mQ += - mS / (1. + fabs(mS)) * mb->Mq[3][i];
+
+		y[2][i] = mb->Zp * (mP + mQ) / mb->Jm[i];
+		y[3][i] = x[2][i];
+
+		y[4][i] = (1.5 * Rs * (x[0][i] * x[0][i] + x[1][i] * x[1][i])
+				+ (mb->Ta - x[4][i]) / mb->Rt) / mb->Ct;
+	}
+}
+
+static void
+blm_batch_DQ(const double (*x)[BLM_LANES], const double (*e)[BLM_LANES],
+		double *eD, double *eQ)
+{
+	double		tS[BLM_LANES], tC[BLM_LANES], eN, X, Y;
+	int		i;
+
+	for (i = 0; i < BLM_LANES; ++i) {
+
+		tS[i] = sin(x[3][i]);
+		tC[i] = cos(x[3][i]);
+	}
+
+	for (i = 0; i < BLM_LANES; ++i) {
+
+		eN = (e[0][i] + e[1][i] + e[2][i]) / 3.;
+
+		X = e[0][i] - eN;
+		Y = 0.577350269189626 * X + 1.15470053837925 * (e[1][i] - eN);
+
+		eD[i] = tC[i] * X + tS[i] * Y;
+		eQ[i] = tC[i] * Y - tS[i] * X;
+	}
+}
+
+static void
+blm_batch_ABC(const double (*x)[BLM_LANES], const double *D, const double *Q,
+		double (*iABC)[BLM_LANES])
+{
+	double		tS[BLM_LANES], tC[BLM_LANES], X, Y;
+	int		i;
+
+	for (i = 0; i < BLM_LANES; ++i) {
+
+		tS[i] = sin(x[3][i]);
+		tC[i] = cos(x[3][i]);
+	}
+
+	for (i = 0; i < BLM_LANES; ++i) {
+
+		X = tC[i] * D[i] - tS[i] * Q[i];
+		Y = tS[i] * D[i] + tC[i] * Q[i];
+
+		iABC[0][i] = X;
+		iABC[1][i] = - 0.5 * X + 0.866025403784439 * Y;
+		iABC[2][i] = - 0.5 * X - 0.866025403784439 * Y;
+	}
+}
+
+static void
+blm_batch_step(blm_batch_t *mb, double lo, double hi, double dT,
+		const double (*xH)[BLM_LANES], const double (*xL)[BLM_LANES])
+{
+	double		x0[7][BLM_LANES], y0[7][BLM_LANES], y1[7][BLM_LANES];
+	double		e[3][BLM_LANES], iABC[3][BLM_LANES], uABC[3][BLM_LANES];
+	double		eD[BLM_LANES], eQ[BLM_LANES], zD[BLM_LANES], zQ[BLM_LANES];
+	double		fH, fL, kA, kB, uMIN;
+	int		i, k;
+
+	blm_batch_ABC(mb->state, mb->state[0], mb->state[1], iABC);
+
+	/* VSI output is averaged over the step. So we do not need to stop at
+	 * each PWM edge which are different across the lanes.
+	 * */
+	for (k = 0; k < 3; ++k) {
+
+		for (i = 0; i < BLM_LANES; ++i) {
+
+			/* Diode conduction during Dead-Time.
+			 * */
+			mb->xfet[k][i] = (iABC[k][i] > mb->Dtol) ? 0.
+				: (iABC[k][i] < - mb->Dtol) ? 1. : mb->xfet[k][i];
+
+			fH = xH[k][i] - lo;
+			fH = (fH < 0.) ? 0. : (fH > hi - lo) ? hi - lo : fH;
+
+			fL = xL[k][i] - lo;
+			fL = (fL < 0.) ? 0. : (fL > hi - lo) ? hi - lo : fL;
+
+			e[k][i] = (fH + (fL - fH) * mb->xfet[k][i]) / (hi - lo);
+		}
+	}
+
+	for (k = 0; k < 3; ++k) {
+
+		for (i = 0; i < BLM_LANES; ++i) {
+
+			if (xH[k][i] > lo && xH[k][i] < hi) {
+
+				/* ADC surge.
+				 * */
+				mb->state[7 + k][i] += lfg_gauss() * 5.;
+				mb->state[10][i] += lfg_gauss() * 2.;
+			}
+		}
+	}
+
+	/* Second-order ODE solver.
+	 * */
+	blm_batch_DQ(mb->state, e, eD, eQ);
+	blm_batch_equation(mb, mb->state, eD, eQ, y0);
+
+	for (k = 0; k < 7; ++k) {
+
+		for (i = 0; i < BLM_LANES; ++i) {
+
+			x0[k][i] = mb->state[k][i] + y0[k][i] * dT;
+		}
+	}
+
+	for (i = 0; i < BLM_LANES; ++i) {
+
+		if (mb->pwm_Z[i] == BLM_Z_DETACHED) {
+
+			x0[0][i] = 0.;
+			x0[1][i] = 0.;
+		}
+	}
+
+	blm_batch_DQ(x0, e, eD, eQ);
+	blm_batch_equation(mb, x0, eD, eQ, y1);
+
+	for (k = 0; k < 7; ++k) {
+
+		for (i = 0; i < BLM_LANES; ++i) {
+
+			mb->state[k][i] += (y0[k][i] + y1[k][i]) * dT / 2.;
+		}
+	}
+
+	for (i = 0; i < BLM_LANES; ++i) {
+
+		if (mb->pwm_Z[i] == BLM_Z_DETACHED) {
+
+			mb->state[0][i] = 0.;
+			mb->state[1][i] = 0.;
+		}
+	}
+
+	/* Sensor transient.
+	 * */
+	kA = 1.0 - exp(- dT / mb->tau_A);
+	kB = 1.0 - exp(- dT / mb->tau_B);
+
+	blm_batch_ABC(mb->state, mb->state[0], mb->state[1], iABC);
+
+	for (i = 0; i < BLM_LANES; ++i) {
+
+		zD[i] = 0.;
+		zQ[i] = mb->lambda[i] * mb->state[2][i];
+	}
+
+	blm_batch_ABC(mb->state, zD, zQ, uABC);
+
+	for (i = 0; i < BLM_LANES; ++i) {
+
+		if (mb->pwm_Z[i] != BLM_Z_DETACHED) {
+
+			uABC[0][i] = e[0][i] * mb->state[6][i];
+			uABC[1][i] = e[1][i] * mb->state[6][i];
+			uABC[2][i] = e[2][i] * mb->state[6][i];
+		}
+		else {
+			uMIN = (uABC[0][i] < uABC[1][i]) ? uABC[0][i] : uABC[1][i];
+			uMIN = (uMIN < uABC[2][i]) ? uMIN : uABC[2][i];
+
+			uABC[0][i] += - uMIN;
+			uABC[1][i] += - uMIN;
+			uABC[2][i] += - uMIN;
+		}
+	}
+
+	for (i = 0; i < BLM_LANES; ++i) {
+
+		mb->state[7][i] += (iABC[0][i] - mb->state[7][i]) * kA;
+		mb->state[8][i] += (iABC[1][i] - mb->state[8][i]) * kA;
+		mb->state[9][i] += (iABC[2][i] - mb->state[9][i]) * kA;
+
+		mb->state[10][i] += (mb->state[6][i] - mb->state[10][i]) * kA;
+		mb->state[11][i] += (mb->state[10][i] - mb->state[11][i]) * kB;
+		mb->state[12][i] += (uABC[0][i] - mb->state[12][i]) * kB;
+		mb->state[13][i] += (uABC[1][i] - mb->state[13][i]) * kB;
+		mb->state[14][i] += (uABC[2][i] - mb->state[14][i]) * kB;
+	}
+
+	for (i = 0; i < BLM_LANES; ++i) {
+
+		if (mb->state[3][i] < - M_PI) {
+
+			mb->state[3][i] += 2. * M_PI;
+			mb->revol[i] -= 1;
+		}
+		else if (mb->state[3][i] > M_PI) {
+
+			mb->state[3][i] -= 2. * M_PI;
+			mb->revol[i] += 1;
+		}
+	}
+
+	mb->sol_nstep++;
+}
+
+static void
+blm_batch_solve(blm_batch_t *mb, int from, int to,
+		const double (*xH)[BLM_LANES], const double (*xL)[BLM_LANES])
+{
+	double		dTu, level, step;
+	int		N, nstep;
+
+	if (from == to)
+		return ;
+
+	dTu = mb->pwm_dT / (double) (mb->pwm_resolution * 2);
+
+	/* Divide the long interval.
+	 * */
+	nstep = (int) ceil(dTu * fabs((double) (to - from)) / mb->sol_dT);
+	step = (double) (to - from) / (double) nstep;
+
+	for (N = 0; N < nstep; ++N) {
+
+		level = from + step * N;
+
+		if (step < 0.) {
+
+			blm_batch_step(mb, level + step, level, - step * dTu, xH, xL);
+		}
+		else {
+			blm_batch_step(mb, level, level + step, step * dTu, xH, xL);
+		}
+	}
+}
+
+static void
+blm_batch_sample(blm_batch_t *mb)
+{
+	double		location, angle, mX, mY;
+	int		i, k, HS, EP;
+
+	for (i = 0; i < BLM_LANES; ++i) {
+
+		mb->analog_uC[i] = (float) blm_ADC(mb->state[14][i], 0., mb->range_B);
+
+		mb->analog_iA[i] = mb->hold_iA[i];
+		mb->analog_iB[i] = mb->hold_iB[i];
+		mb->analog_iC[i] = mb->hold_iC[i];
+
+		location = mb->state[3][i] + (2. * M_PI) * (double) mb->revol[i];
+
+		/* Resolver SIN/COS.
+		 * */
+		angle = location * mb->analog_Zq / mb->Zp;
+
+		mb->analog_SIN[i] = (float) blm_ADC(sin(angle), - 3., 3.);
+		mb->analog_COS[i] = (float) blm_ADC(cos(angle), - 3., 3.);
+
+		/* Hall Sensors.
+		 * */
+		mX = cos(mb->state[3][i]);
+		mY = sin(mb->state[3][i]);
+
+		HS = 0;
+
+		for (k = 0; k < 3; ++k) {
+
+			angle = mb->hall[k] * (M_PI / 180.);
+
+			HS |= (mX * cos(angle) + mY * sin(angle) < 0.) ? (1 << k) : 0;
+		}
+
+		mb->pulse_HS[i] = HS;
+
+		/* EABI encoder.
+		 * */
+		angle = location * mb->eabi_Zq / mb->Zp;
+
+		EP = (int) (angle / (2. * M_PI) * (double) mb->eabi_ERES);
+
+		EP = EP - (EP / mb->eabi_WRAP) * mb->eabi_WRAP;
+		EP += (EP < 0) ? mb->eabi_WRAP : 0;
+
+		mb->pulse_EP[i] = EP;
+	}
+}
+
+void blm_batch_update(blm_batch_t *mb)
+{
+	double		xH[3][BLM_LANES], xL[3][BLM_LANES], dTu;
+	int		xDC, xMIN, xMAX, xAD, xCONV, xDT, i, k;
+
+	dTu = mb->pwm_dT / (double) (mb->pwm_resolution * 2);
+
+	xMIN = (int) (mb->pwm_minimal * (double) mb->pwm_resolution / mb->pwm_dT);
+	xMAX = mb->pwm_resolution;
+
+	xAD = (int) (mb->adc_Toffset / dTu);
+	xCONV = (int) (mb->adc_Tconv / dTu);
+	xDT = (int) (mb->pwm_deadtime / dTu);
+
+	for (k = 0; k < 3; ++k) {
+
+		for (i = 0; i < BLM_LANES; ++i) {
+
+			xDC =     (k == 0) ? mb->pwm_A[i]
+				: (k == 1) ? mb->pwm_B[i] : mb->pwm_C[i];
+
+			/* FET high side.
+			 * */
+			xH[k][i] = (xDC < xMIN) ? 0 : (xDC > xMAX - xMIN) ? xMAX : xDC;
+
+			/* FET low side.
+			 * */
+			xDC = (xDC < xMIN) ? 0 : xDC + xDT;
+			xL[k][i] = (xDC < xMIN) ? 0 : (xDC > xMAX - xMIN) ? xMAX : xDC;
+		}
+	}
+
+	/* PWM count up. We stop at ADC sampling only as it is the same
+	 * across the lanes.
+	 * */
+	blm_batch_solve(mb, xMAX, xMAX + xAD - xCONV, xH, xL);
+
+	for (i = 0; i < BLM_LANES; ++i) {
+
+		mb->analog_uS[i] = (float) blm_ADC(mb->state[11][i], 0., mb->range_B);
+		mb->analog_uA[i] = (float) blm_ADC(mb->state[12][i], 0., mb->range_B);
+		mb->analog_uB[i] = (float) blm_ADC(mb->state[13][i], 0., mb->range_B);
+	}
+
+	blm_batch_solve(mb, xMAX + xAD - xCONV, xMAX + xAD - 2 * xCONV, xH, xL);
+
+	blm_batch_sample(mb);
+
+	blm_batch_solve(mb, xMAX + xAD - 2 * xCONV, 0, xH, xL);
+
+	/* PWM count down.
+	 * */
+	blm_batch_solve(mb, 0, xMAX - xAD, xH, xL);
+
+	for (i = 0; i < BLM_LANES; ++i) {
+
+		mb->hold_iA[i] = (float) blm_ADC(mb->state[7][i], - mb->range_A, mb->range_A);
+		mb->hold_iB[i] = (float) blm_ADC(mb->state[8][i], - mb->range_A, mb->range_A);
+		mb->hold_iC[i] = (float) blm_ADC(mb->state[9][i], - mb->range_A, mb->range_A);
+	}
+
+	blm_batch_solve(mb, xMAX - xAD, xMAX, xH, xL);
+
+	/* Get average POWER on PWM cycle.
+	 * */
+	for (i = 0; i < BLM_LANES; ++i) {
+
+		mb->drain_wP[i] = mb->state[5][i] / mb->pwm_dT;
+		mb->state[5][i] = 0.;
+	}
+
+	mb->time += mb->pwm_dT;
+}
@@ -6,11 +6,32 @@ enum {
 	BLM_Z_DETACHED
 };
 
+enum {
+	BLM_SOLVER_HEUN		= 0,
+	BLM_SOLVER_EXACT,
+	BLM_SOLVER_RK45
+};
+
 typedef struct {
 
 	double		time;
 	double		sol_dT;
 
+	int		solver;
+
+	double		sol_tol;
+	double		sol_h;
+
+	long		sol_nstep;
+	long		sol_nfail;
+	double		sol_emax;
+
+	double		slow_dT;
+	double		slow_T;
+	double		slow_wJ;
+	double		slow_wH;
+	double		slow_hP;
+
 	int		unsync_flag;
 
 	double		pwm_dT;
@@ -94,6 +115,90 @@ typedef struct {
 }
 blm_t;
 
+/* Number of lanes in the batch plant. Lanes are stored in SoA layout so the
+ * compiler is able to vectorize the solver across them.
+ * */
+#define BLM_LANES		8
+
+typedef struct {
+
+	double		time;
+	double		sol_dT;
+	long		sol_nstep;
+
+	double		pwm_dT;
+	double		pwm_deadtime;
+	double		pwm_minimal;
+	int		pwm_resolution;
+
+	double		Dtol;
+
+	int		pwm_A[BLM_LANES];
+	int		pwm_B[BLM_LANES];
+	int		pwm_C[BLM_LANES];
+	int		pwm_Z[BLM_LANES];
+
+	double		state[15][BLM_LANES];
+	double		drain_wP[BLM_LANES];
+
+	double		xfet[3][BLM_LANES];
+	int		revol[BLM_LANES];
+
+	/* Machine parameters that vary across lanes.
+	 * */
+	double		Rs[BLM_LANES];
+	double		Ld[BLM_LANES];
+	double		Lq[BLM_LANES];
+	double		lambda[BLM_LANES];
+	double		Jm[BLM_LANES];
+	double		Mq[4][BLM_LANES];
+
+	int		Zp;
+
+	double		Ta;
+	double		Ct;
+	double		Rt;
+
+	double		Udc;
+	double		Rdc;
+	double		Cdc;
+
+	double		adc_Tconv;
+	double		adc_Toffset;
+
+	double		tau_A;
+	double		tau_B;
+	double		range_A;
+	double		range_B;
+
+	double		hall[3];
+
+	int		eabi_ERES;
+	int		eabi_WRAP;
+	double		eabi_Zq;
+
+	double		analog_Zq;
+
+	float		hold_iA[BLM_LANES];
+	float		hold_iB[BLM_LANES];
+	float		hold_iC[BLM_LANES];
+
+	float		analog_iA[BLM_LANES];
+	float		analog_iB[BLM_LANES];
+	float		analog_iC[BLM_LANES];
+	float		analog_uS[BLM_LANES];
+	float		analog_uA[BLM_LANES];
+	float		analog_uB[BLM_LANES];
+	float		analog_uC[BLM_LANES];
+
+	int		pulse_HS[BLM_LANES];
+	int		pulse_EP[BLM_LANES];
+
+	float		analog_SIN[BLM_LANES];
+	float		analog_COS[BLM_LANES];
+}
+blm_batch_t;
+
 void blm_AB_DQ(double theta, double A, double B, double *D, double *Q);
 void blm_DQ_ABC(double theta, double D, double Q, double *A, double *B, double *C);
 double blm_Kv_lambda(blm_t *m, double Kv);
@@ -102,5 +207,9 @@ void blm_enable(blm_t *m);
 void blm_restart(blm_t *m);
 void blm_update(blm_t *m);
 
+void blm_batch_enable(blm_batch_t *mb, const blm_t *m);
+void blm_batch_restart(blm_batch_t *mb);
+void blm_batch_update(blm_batch_t *mb);
+
 #endif /* _H_BLM_ */
 
@@ -1,14 +1,59 @@
 #!/usr/bin/python3
 
 import tensorflow as tf
-import os, random, keras, numpy as np
+import os, glob, struct, random, keras, numpy as np
+import lz4.block
 
-f = open('/tmp/pm-mldata', 'rb')
-raw = np.fromfile(f, dtype=np.float32).reshape((-1, 10))
+def mld_load(file):
 
-f.close()
+    # Read the dataset written by bench (see bench/mldata.h).
+    mm = np.memmap(file, dtype=np.uint8, mode='r')
 
-data = raw[:, :6] / np.array([50, 50, 20, 20, 1, 1])
+    magic, nchan, length, compress, reserved, rate = \
+            struct.unpack_from('<8sIIIId', mm, 0)
+
+    if magic != b'PMLDATA1':
+        raise ValueError(file + ': not a dataset')
+
+    chan = []
+
+    for N in range(nchan):
+        name, unit, scale = struct.unpack_from('<32s16sf', mm, 32 + N * 52)
+        chan.append((name.rstrip(b'\0').decode(),
+                     unit.rstrip(b'\0').decode(), scale))
+
+    offset, nshard, imagic = struct.unpack_from('<QI4s', mm, len(mm) - 16)
+
+    if imagic != b'PMIX':
+        raise ValueError(file + ': no index found')
+
+    shard = []
+
+    for N in range(nshard):
+        soffset, slength, ssize = struct.unpack_from('<QII', mm, offset + N * 16)
+
+        if compress == 0:
+            shard.append(np.frombuffer(mm, dtype=np.float32,
+                count=slength * nchan, offset=soffset).reshape((-1, nchan)))
+        else:
+            raw = lz4.block.decompress(bytes(mm[soffset:soffset + ssize]),
+                    uncompressed_size=slength * nchan * 4)
+            shard.append(np.frombuffer(raw, dtype=np.float32).reshape((-1, nchan)))
+
+    return np.concatenate(shard), chan, rate
+
+datasets = []
+
+for file in sorted(glob.glob('/tmp/pm-mldata*')):
+
+    raw, chan, rate = mld_load(file)
+
+    print(file, raw.shape, rate, [c[0] for c in chan])
+
+    scale = np.array([c[2] for c in chan], dtype=np.float32)
+    datasets.append(raw[:, :6] / scale[:6])
+
+data = np.concatenate(datasets)
 
 fmean = np.mean(data, axis=0)
 fstd = np.max(data, axis=0) - np.min(data, axis=0)
@@ -10,7 +10,7 @@ typedef struct {
 }
 lfg_t;
 
-static lfg_t		lfg;
+static __thread lfg_t	lfg;
 
 static uint32_t
 lfg_lcgu(uint32_t rseed)
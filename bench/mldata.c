@@ -0,0 +1,289 @@
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <errno.h>
+#include <pthread.h>
+
+#include "mldata.h"
+#include "../pgui/gp/lz4.h"
+
+struct mld_s {
+
+	FILE		*fd;
+
+	int		nchan;
+	int		compress;
+
+	/* Shards are filled by simulation and handed over to the writer
+	 * thread so that simulation does not block on the file output.
+	 * */
+	float		*buf[MLD_QUEUE];
+	int		fill[MLD_QUEUE];
+
+	int		head;
+	int		tail;
+	int		count;
+	int		stop;
+
+	int		put;
+
+	char		*zbuf;
+	int		zlen;
+
+	mld_index_t	*index;
+	int		nshard;
+	int		nshard_MAX;
+
+	uint64_t	offset;
+
+	pthread_mutex_t	lock;
+	pthread_cond_t	cond;
+	pthread_t	thread;
+};
+
+static void
+mld_write(mld_t *ml, const void *data, size_t size)
+{
+	if (fwrite(data, 1, size, ml->fd) != size) {
+
+		fprintf(stderr, "fwrite: %s\n", strerror(errno));
+		abort();
+	}
+
+	ml->offset += size;
+}
+
+static void
+mld_shard_write(mld_t *ml, const float *buf, int length)
+{
+	mld_shard_t	shard;
+	const char	*data;
+	int		size;
+
+	size = length * ml->nchan * sizeof(float);
+	data = (const char *) buf;
+
+	if (ml->compress == MLD_COMPRESS_LZ4) {
+
+		size = LZ4_compress_default(data, ml->zbuf, size, ml->zlen);
+		data = ml->zbuf;
+
+		if (size <= 0) {
+
+			fprintf(stderr, "LZ4_compress_default: failed\n");
+			abort();
+		}
+	}
+
+	shard.length = length;
+	shard.size = size;
+
+	mld_write(ml, &shard, sizeof(shard));
+
+	if (ml->nshard >= ml->nshard_MAX) {
+
+		ml->nshard_MAX = (ml->nshard_MAX != 0) ? ml->nshard_MAX * 2 : 64;
+		ml->index = realloc(ml->index, ml->nshard_MAX * sizeof(mld_index_t));
+	}
+
+	ml->index[ml->nshard].offset = ml->offset;
+	ml->index[ml->nshard].length = length;
+	ml->index[ml->nshard].size = size;
+
+	ml->nshard += 1;
+
+	mld_write(ml, data, size);
+}
+
+static void *
+mld_thread(void *arg)
+{
+	mld_t		*ml = (mld_t *) arg;
+	int		N;
+
+	do {
+		pthread_mutex_lock(&ml->lock);
+
+		while (ml->count == 0 && ml->stop == 0) {
+
+			pthread_cond_wait(&ml->cond, &ml->lock);
+		}
+
+		if (ml->count == 0) {
+
+			pthread_mutex_unlock(&ml->lock);
+			break;
+		}
+
+		N = ml->tail;
+
+		pthread_mutex_unlock(&ml->lock);
+
+		mld_shard_write(ml, ml->buf[N], ml->fill[N]);
+
+		pthread_mutex_lock(&ml->lock);
+
+		ml->tail = (ml->tail + 1) % MLD_QUEUE;
+		ml->count -= 1;
+
+		pthread_cond_broadcast(&ml->cond);
+		pthread_mutex_unlock(&ml->lock);
+	}
+	while (1);
+
+	return NULL;
+}
+
+mld_t *mld_open(const char *file, int nchan, const mld_chan_t *chan,
+		double rate, int compress)
+{
+	mld_t		*ml;
+	mld_header_t	hdr;
+	int		N;
+
+	if (nchan < 1 || nchan > MLD_CHAN_MAX) {
+
+		fprintf(stderr, "mld_open: %i channels are not supported\n", nchan);
+		return NULL;
+	}
+
+	ml = calloc(1, sizeof(mld_t));
+
+	if (ml == NULL) {
+
+		fprintf(stderr, "calloc: %s\n", strerror(errno));
+		abort();
+	}
+
+	ml->fd = fopen(file, "wb");
+
+	if (ml->fd == NULL) {
+
+		fprintf(stderr, "fopen(\"%s\"): %s\n", file, strerror(errno));
+
+		free(ml);
+		return NULL;
+	}
+
+	ml->nchan = nchan;
+	ml->compress = compress;
+
+	for (N = 0; N < MLD_QUEUE; ++N) {
+
+		ml->buf[N] = malloc(MLD_SHARD_LENGTH * nchan * sizeof(float));
+
+		if (ml->buf[N] == NULL) {
+
+			fprintf(stderr, "malloc: %s\n", strerror(errno));
+			abort();
+		}
+	}
+
+	if (compress == MLD_COMPRESS_LZ4) {
+
+		ml->zlen = LZ4_compressBound(MLD_SHARD_LENGTH * nchan * sizeof(float));
+		ml->zbuf = malloc(ml->zlen);
+
+		if (ml->zbuf == NULL) {
+
+			fprintf(stderr, "malloc: %s\n", strerror(errno));
+			abort();
+		}
+	}
+
+	memset(&hdr, 0, sizeof(hdr));
+	memcpy(hdr.magic, MLD_MAGIC, sizeof(hdr.magic));
+
+	hdr.nchan = nchan;
+	hdr.length = MLD_SHARD_LENGTH;
+	hdr.compress = compress;
+	hdr.rate = rate;
+
+	mld_write(ml, &hdr, sizeof(hdr));
+	mld_write(ml, chan, nchan * sizeof(mld_chan_t));
+
+	pthread_mutex_init(&ml->lock, NULL);
+	pthread_cond_init(&ml->cond, NULL);
+
+	pthread_create(&ml->thread, NULL, &mld_thread, ml);
+
+	return ml;
+}
+
+static void
+mld_submit(mld_t *ml)
+{
+	pthread_mutex_lock(&ml->lock);
+
+	ml->fill[ml->head] = ml->put;
+	ml->head = (ml->head + 1) % MLD_QUEUE;
+	ml->count += 1;
+
+	pthread_cond_broadcast(&ml->cond);
+
+	/* Block only if the writer is behind by the whole queue.
+	 * */
+	while (ml->count >= MLD_QUEUE) {
+
+		pthread_cond_wait(&ml->cond, &ml->lock);
+	}
+
+	pthread_mutex_unlock(&ml->lock);
+
+	ml->put = 0;
+}
+
+void mld_put(mld_t *ml, const float *y)
+{
+	memcpy(ml->buf[ml->head] + ml->put * ml->nchan, y, ml->nchan * sizeof(float));
+
+	ml->put += 1;
+
+	if (ml->put >= MLD_SHARD_LENGTH) {
+
+		mld_submit(ml);
+	}
+}
+
+void mld_close(mld_t *ml)
+{
+	mld_trailer_t	trailer;
+	int		N;
+
+	if (ml->put > 0) {
+
+		mld_submit(ml);
+	}
+
+	pthread_mutex_lock(&ml->lock);
+
+	ml->stop = 1;
+
+	pthread_cond_broadcast(&ml->cond);
+	pthread_mutex_unlock(&ml->lock);
+
+	pthread_join(ml->thread, NULL);
+
+	trailer.offset = ml->offset;
+	trailer.nshard = ml->nshard;
+
+	memcpy(trailer.magic, MLD_INDEX_MAGIC, sizeof(trailer.magic));
+
+	mld_write(ml, ml->index, ml->nshard * sizeof(mld_index_t));
+	mld_write(ml, &trailer, sizeof(trailer));
+
+	fclose(ml->fd);
+
+	pthread_mutex_destroy(&ml->lock);
+	pthread_cond_destroy(&ml->cond);
+
+	for (N = 0; N < MLD_QUEUE; ++N) {
+
+		free(ml->buf[N]);
+	}
+
+	free(ml->zbuf);
+	free(ml->index);
+	free(ml);
+}
+
@@ -0,0 +1,88 @@
+#ifndef _H_MLDATA_
+#define _H_MLDATA_
+
+#include <stdint.h>
+
+#define MLD_MAGIC		"PMLDATA1"
+#define MLD_INDEX_MAGIC		"PMIX"
+
+#define MLD_CHAN_MAX		16
+#define MLD_SHARD_LENGTH	16384
+#define MLD_QUEUE		4
+
+enum {
+	MLD_COMPRESS_NONE	= 0,
+	MLD_COMPRESS_LZ4
+};
+
+/* Dataset file layout (little-endian).
+ *
+ *	mld_header_t			file header
+ *	mld_chan_t [nchan]		channel description
+ *
+ *	mld_shard_t			shard header
+ *	float [length][nchan]		shard data (LZ4 block if compressed)
+ *	...
+ *
+ *	mld_index_t [nshard]		shard index
+ *	mld_trailer_t			points to the index
+ *
+ * */
+typedef struct {
+
+	char		magic[8];
+
+	uint32_t	nchan;
+	uint32_t	length;
+	uint32_t	compress;
+	uint32_t	reserved;
+
+	double		rate;
+}
+mld_header_t;
+
+typedef struct {
+
+	char		name[32];
+	char		unit[16];
+
+	/* Normalization hint for the training.
+	 * */
+	float		scale;
+}
+mld_chan_t;
+
+typedef struct {
+
+	uint32_t	length;
+	uint32_t	size;
+}
+mld_shard_t;
+
+typedef struct {
+
+	uint64_t	offset;
+	uint32_t	length;
+	uint32_t	size;
+}
+mld_index_t;
+
+typedef struct {
+
+	uint64_t	offset;
+	uint32_t	nshard;
+
+	char		magic[4];
+}
+mld_trailer_t;
+
+typedef struct mld_s mld_t;
+
+mld_t *mld_open(const char *file, int nchan, const mld_chan_t *chan,
+		double rate, int compress);
+
+void mld_put(mld_t *ml, const float *y);
+void mld_close(mld_t *ml);
+
+#endif /* _H_MLDATA_ */
+
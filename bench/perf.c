@@ -0,0 +1,447 @@
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <errno.h>
+#include <math.h>
+#include <time.h>
+#include <unistd.h>
+
+#include <sys/syscall.h>
+#include <linux/perf_event.h>
+
+#include "blm.h"
+#include "lfg.h"
+#include "pm.h"
+#include "tsfunc.h"
+
+#define PERF_SAMPLES		20000
+#define PERF_STAGE_MAX		8
+
+typedef struct {
+
+	const char	*name;
+
+	void		(* proc) (pmc_t *);
+}
+perf_stage_t;
+
+typedef struct {
+
+	const char	*name;
+
+	int		config_LU_ESTIMATE;
+	int		config_LU_SENSOR;
+	int		config_HFI_WAVETYPE;
+
+	/* Speed setpoint in percents of maximal EMF.
+	 * */
+	float		speed;
+
+	perf_stage_t	stage[PERF_STAGE_MAX];
+
+	int		config_RELUCTANCE;
+	int		config_MTPA_TABLE;
+}
+perf_mode_t;
+
+static const perf_mode_t	perf_mode_list[] = {
+
+	{ "ortega", PM_FLUX_ORTEGA, PM_SENSOR_NONE, PM_HFI_NONE, 50.f, {
+
+		{ "pm_feedback", NULL },
+		{ "pm_flux_ortega", &pm_perf_flux_ortega },
+		{ "pm_loop_current", &pm_perf_loop_current },
+		{ "pm_voltage", &pm_perf_voltage } }
+	},
+
+	{ "ortega_mtpa", PM_FLUX_ORTEGA, PM_SENSOR_NONE, PM_HFI_NONE, 50.f, {
+
+		{ "pm_feedback", NULL },
+		{ "pm_loop_current", &pm_perf_loop_current } },
+
+		PM_ENABLED, PM_DISABLED
+	},
+
+	{ "ortega_mtpa_table", PM_FLUX_ORTEGA, PM_SENSOR_NONE, PM_HFI_NONE, 50.f, {
+
+		{ "pm_feedback", NULL },
+		{ "pm_loop_current", &pm_perf_loop_current } },
+
+		PM_ENABLED, PM_ENABLED
+	},
+
+	{ "kalman", PM_FLUX_KALMAN, PM_SENSOR_NONE, PM_HFI_NONE, 50.f, {
+
+		{ "pm_feedback", NULL },
+		{ "pm_kalman_forecast", &pm_perf_kalman_forecast },
+		{ "pm_kalman_update", &pm_perf_kalman_update },
+		{ "pm_loop_current", &pm_perf_loop_current },
+		{ "pm_voltage", &pm_perf_voltage } }
+	},
+
+	{ "kalman_sched", PM_FLUX_KALMAN_SCHEDULED, PM_SENSOR_NONE, PM_HFI_NONE, 50.f, {
+
+		{ "pm_feedback", NULL },
+		{ "pm_kalman_forecast", &pm_perf_kalman_forecast },
+		{ "pm_kalman_update", &pm_perf_kalman_update },
+		{ "pm_loop_current", &pm_perf_loop_current },
+		{ "pm_voltage", &pm_perf_voltage } }
+	},
+
+	{ "kalman_hfi", PM_FLUX_KALMAN, PM_SENSOR_NONE, PM_HFI_SINE, 0.f, {
+
+		{ "pm_feedback", NULL },
+		{ "pm_kalman_forecast", &pm_perf_kalman_forecast },
+		{ "pm_kalman_update", &pm_perf_kalman_update },
+		{ "pm_hfi_wave", &pm_perf_hfi_wave },
+		{ "pm_loop_current", &pm_perf_loop_current },
+		{ "pm_voltage", &pm_perf_voltage } }
+	},
+
+	{ "hall", PM_FLUX_NONE, PM_SENSOR_HALL, PM_HFI_NONE, 50.f, {
+
+		{ "pm_feedback", NULL },
+		{ "pm_sensor_hall", &pm_perf_sensor_hall },
+		{ "pm_loop_current", &pm_perf_loop_current },
+		{ "pm_voltage", &pm_perf_voltage } }
+	},
+
+	{ "eabi", PM_FLUX_NONE, PM_SENSOR_EABI, PM_HFI_NONE, 50.f, {
+
+		{ "pm_feedback", NULL },
+		{ "pm_sensor_eabi", &pm_perf_sensor_eabi },
+		{ "pm_loop_current", &pm_perf_loop_current },
+		{ "pm_voltage", &pm_perf_voltage } }
+	},
+
+	{ "sincos", PM_FLUX_NONE, PM_SENSOR_SINCOS, PM_HFI_NONE, 50.f, {
+
+		{ "pm_feedback", NULL },
+		{ "pm_sensor_sincos", &pm_perf_sensor_sincos },
+		{ "pm_loop_current", &pm_perf_loop_current },
+		{ "pm_voltage", &pm_perf_voltage } }
+	}
+};
+
+#define PERF_MODE_MAX		(sizeof(perf_mode_list) / sizeof(perf_mode_list[0]))
+
+static long long
+perf_clock()
+{
+	struct timespec		ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+
+	return (long long) ts.tv_sec * 1000000000LL + (long long) ts.tv_nsec;
+}
+
+static long long
+perf_counter(int fd)
+{
+	long long		count = 0;
+
+	if (read(fd, &count, sizeof(count)) != sizeof(count)) {
+
+		count = 0;
+	}
+
+	return count;
+}
+
+static int
+perf_event_open_instructions()
+{
+	struct perf_event_attr	attr;
+
+	memset(&attr, 0, sizeof(attr));
+
+	attr.type = PERF_TYPE_HARDWARE;
+	attr.size = sizeof(attr);
+	attr.config = PERF_COUNT_HW_INSTRUCTIONS;
+	attr.exclude_kernel = 1;
+	attr.exclude_hv = 1;
+
+	/* NOTE: It may be not permitted by perf_event_paranoid or be not
+	 * supported at all in a virtual machine. We report null then.
+	 * */
+	return (int) syscall(SYS_perf_event_open, &attr, 0, -1, -1, 0);
+}
+
+static int
+perf_cmp(const void *a, const void *b)
+{
+	long long	x = *(const long long *) a;
+	long long	y = *(const long long *) b;
+
+	return (x < y) ? -1 : (x > y) ? 1 : 0;
+}
+
+static void
+perf_setup(sim_t *S, const perf_mode_t *mode)
+{
+	if (mode->config_LU_SENSOR == PM_SENSOR_HALL) {
+
+		ts_adjust_sensor_hall(S);
+		blm_restart(&S->m);
+	}
+	else if (mode->config_LU_SENSOR == PM_SENSOR_EABI) {
+
+		S->pm.config_EABI_FRONTEND = PM_EABI_INCREMENTAL;
+		S->pm.eabi_ADJUST = PM_DISABLED;
+
+		ts_adjust_sensor_eabi(S);
+		blm_restart(&S->m);
+	}
+	else if (mode->config_LU_SENSOR == PM_SENSOR_SINCOS) {
+
+		ts_adjust_sensor_sincos(S);
+		blm_restart(&S->m);
+	}
+
+	S->pm.config_LU_ESTIMATE = mode->config_LU_ESTIMATE;
+	S->pm.config_LU_SENSOR = mode->config_LU_SENSOR;
+	S->pm.config_LU_DRIVE = PM_DRIVE_SPEED;
+	S->pm.config_HFI_WAVETYPE = mode->config_HFI_WAVETYPE;
+	S->pm.config_RELUCTANCE = mode->config_RELUCTANCE;
+	S->pm.config_MTPA_TABLE = mode->config_MTPA_TABLE;
+
+	S->pm.fsm_req = PM_STATE_LU_STARTUP;
+	ts_wait_IDLE(S);
+
+	if (mode->config_HFI_WAVETYPE != PM_HFI_NONE) {
+
+		/* Get the observer converged before stop on HFI.
+		 * */
+		S->pm.s_setpoint_speed = 1.f / S->pm.const_lambda;
+		sim_runtime(S, 1.);
+	}
+
+	S->pm.s_setpoint_speed = mode->speed * S->pm.k_EMAX / 100.f
+			* S->pm.const_fb_U / S->pm.const_lambda;
+
+	ts_wait_spinup(S);
+	sim_runtime(S, 0.5);
+
+	fprintf(S->fd_log, "lu_MODE = %i\n", S->pm.lu_MODE);
+	fprintf(S->fd_log, "lu_wS = %.2f (rad/s)\n", S->pm.lu_wS);
+}
+
+static void
+perf_stage(const perf_mode_t *mode, const perf_stage_t *stage,
+		const pmc_t *pm0, const pmfb_t *fb, int fd, int *comma)
+{
+	static pmc_t	pm, px;
+
+	long long	*ns, t0, t1, zero_ns, c0, c1, zero_in, instr;
+	double		mean, dev;
+	int		i, N = PERF_SAMPLES;
+
+	ns = malloc(N * sizeof(long long));
+
+	if (ns == NULL) {
+
+		fprintf(stderr, "malloc: %s\n", strerror(errno));
+		abort();
+	}
+
+	/* Overhead of the measurement itself.
+	 * */
+	zero_ns = 1000000000LL;
+
+	for (i = 0; i < 1000; ++i) {
+
+		t0 = perf_clock();
+		t1 = perf_clock();
+
+		zero_ns = (t1 - t0 < zero_ns) ? t1 - t0 : zero_ns;
+	}
+
+	memcpy(&pm, pm0, sizeof(pmc_t));
+
+	for (i = 0; i < N; ++i) {
+
+		if (stage->proc == NULL) {
+
+			t0 = perf_clock();
+			pm_feedback(&pm, (pmfb_t *) &fb[i]);
+			t1 = perf_clock();
+		}
+		else {
+			pm_feedback(&pm, (pmfb_t *) &fb[i]);
+			memcpy(&px, &pm, sizeof(pmc_t));
+
+			t0 = perf_clock();
+			stage->proc(&px);
+			t1 = perf_clock();
+		}
+
+		ns[i] = t1 - t0 - zero_ns;
+		ns[i] = (ns[i] < 0) ? 0 : ns[i];
+	}
+
+	instr = -1;
+
+	if (fd >= 0) {
+
+		zero_in = 1000000000LL;
+
+		for (i = 0; i < 1000; ++i) {
+
+			c0 = perf_counter(fd);
+			c1 = perf_counter(fd);
+
+			zero_in = (c1 - c0 < zero_in) ? c1 - c0 : zero_in;
+		}
+
+		memcpy(&pm, pm0, sizeof(pmc_t));
+
+		instr = 0;
+
+		for (i = 0; i < N; ++i) {
+
+			if (stage->proc == NULL) {
+
+				c0 = perf_counter(fd);
+				pm_feedback(&pm, (pmfb_t *) &fb[i]);
+				c1 = perf_counter(fd);
+			}
+			else {
+				pm_feedback(&pm, (pmfb_t *) &fb[i]);
+				memcpy(&px, &pm, sizeof(pmc_t));
+
+				c0 = perf_counter(fd);
+				stage->proc(&px);
+				c1 = perf_counter(fd);
+			}
+
+			instr += c1 - c0 - zero_in;
+		}
+	}
+
+	mean = 0.;
+
+	for (i = 0; i < N; ++i) { mean += (double) ns[i]; }
+
+	mean /= (double) N;
+	dev = 0.;
+
+	for (i = 0; i < N; ++i) { dev += ((double) ns[i] - mean) * ((double) ns[i] - mean); }
+
+	dev = sqrt(dev / (double) N);
+
+	qsort(ns, N, sizeof(long long), &perf_cmp);
+
+	printf("%s\n  { \"mode\": \"%s\", \"stage\": \"%s\", \"calls\": %i,"
+			" \"ns_mean\": %.1f, \"ns_std\": %.1f,"
+			" \"ns_min\": %lli, \"ns_p50\": %lli, \"ns_p90\": %lli,"
+			" \"ns_p99\": %lli, \"ns_max\": %lli, ",
+			(*comma != 0) ? "," : "", mode->name, stage->name, N,
+			mean, dev, ns[0], ns[N / 2], ns[N * 9 / 10],
+			ns[N * 99 / 100], ns[N - 1]);
+
+	if (instr >= 0) {
+
+		printf("\"instructions\": %.1f }", (double) instr / (double) N);
+	}
+	else {
+		printf("\"instructions\": null }");
+	}
+
+	*comma = 1;
+
+	free(ns);
+}
+
+void perf_script()
+{
+	sim_t		*S, *base;
+	pmfb_t		*fb;
+	pmc_t		*pm0;
+
+	int		fd, comma = 0, N, i, j;
+
+	S = calloc(1, sizeof(sim_t));
+	base = calloc(1, sizeof(sim_t));
+	pm0 = calloc(1, sizeof(pmc_t));
+	fb = calloc(PERF_SAMPLES, sizeof(pmfb_t));
+
+	if (S == NULL || base == NULL || pm0 == NULL || fb == NULL) {
+
+		fprintf(stderr, "calloc: %s\n", strerror(errno));
+		abort();
+	}
+
+	/* We keep stdout clean for JSON output.
+	 * */
+	S->fd_log = stderr;
+
+	/* Same feedback sequence on each run.
+	 * */
+	lfg_start(1);
+
+	blm_enable(&S->m);
+	blm_restart(&S->m);
+
+	S->m.Rs = 14.e-3;
+	S->m.Ld = 10.e-6;
+	S->m.Lq = 15.e-6;
+	S->m.Udc = 22.;
+	S->m.Rdc = 0.1;
+	S->m.Zp = 14;
+	S->m.lambda = blm_Kv_lambda(&S->m, 270.);
+	S->m.Jm = 4.e-4;
+
+	ts_script_default(S);
+	ts_script_base(S);
+	blm_restart(&S->m);
+
+	memcpy(base, S, sizeof(sim_t));
+
+	fd = perf_event_open_instructions();
+
+	printf("[");
+
+	for (N = 0; N < (int) PERF_MODE_MAX; ++N) {
+
+		const perf_mode_t	*mode = &perf_mode_list[N];
+
+		memcpy(S, base, sizeof(sim_t));
+
+		fprintf(S->fd_log, "\n---- perf %s ----\n", mode->name);
+
+		perf_setup(S, mode);
+
+		/* Record the feedback stream in steady operation.
+		 * */
+		memcpy(pm0, &S->pm, sizeof(pmc_t));
+
+		sim_local = S;
+
+		for (i = 0; i < PERF_SAMPLES; ++i) {
+
+			blm_update(&S->m);
+			sim_feedback(S, &fb[i]);
+			pm_feedback(&S->pm, &fb[i]);
+		}
+
+		for (j = 0; j < PERF_STAGE_MAX; ++j) {
+
+			if (mode->stage[j].name == NULL)
+				break;
+
+			perf_stage(mode, &mode->stage[j], pm0, fb, fd, &comma);
+		}
+	}
+
+	printf("\n]\n");
+
+	if (fd >= 0) {
+
+		close(fd);
+	}
+
+	free(S);
+	free(base);
+	free(pm0);
+	free(fb);
+}
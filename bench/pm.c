@@ -2,3 +2,15 @@
 #include "../src/phobia/lse.c"
 #include "../src/phobia/pm.c"
 #include "../src/phobia/pm_fsm.c"
+
+/* Entry points to the private stages of PMC for micro-benchmark.
+ * */
+void pm_perf_flux_ortega(pmc_t *pm) { pm_flux_ortega(pm); }
+void pm_perf_kalman_forecast(pmc_t *pm) { pm_kalman_forecast(pm); }
+void pm_perf_kalman_update(pmc_t *pm) { pm_kalman_update(pm); }
+void pm_perf_loop_current(pmc_t *pm) { pm_loop_current(pm); }
+void pm_perf_voltage(pmc_t *pm) { pm_voltage(pm, pm->vsi_X, pm->vsi_Y); }
+void pm_perf_sensor_hall(pmc_t *pm) { pm_sensor_hall(pm); }
+void pm_perf_sensor_eabi(pmc_t *pm) { pm_sensor_eabi(pm); }
+void pm_perf_sensor_sincos(pmc_t *pm) { pm_sensor_sincos(pm); }
+void pm_perf_hfi_wave(pmc_t *pm) { (void) pm_hfi_wave(pm); }
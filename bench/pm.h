@@ -1,2 +1,12 @@
 #include "../src/phobia/libm.h"
 #include "../src/phobia/pm.h"
+
+void pm_perf_flux_ortega(pmc_t *pm);
+void pm_perf_kalman_forecast(pmc_t *pm);
+void pm_perf_kalman_update(pmc_t *pm);
+void pm_perf_loop_current(pmc_t *pm);
+void pm_perf_voltage(pmc_t *pm);
+void pm_perf_sensor_hall(pmc_t *pm);
+void pm_perf_sensor_eabi(pmc_t *pm);
+void pm_perf_sensor_sincos(pmc_t *pm);
+void pm_perf_hfi_wave(pmc_t *pm);
@@ -0,0 +1,405 @@
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <stdint.h>
+#include <time.h>
+
+#include "pm.h"
+#include "replay.h"
+
+#define REPLAY_FILE	"/tmp/pm-REPLAY"
+
+typedef struct {
+
+	const char	*sym;
+	const char	*fmt;
+	const char	*mode;
+
+	void		*link;
+
+	const char	*proc;
+}
+replay_def_t;
+
+static int
+replay_hex_line(replay_line_t *line, const char *s)
+{
+	uint32_t	word[sizeof(replay_line_t) / sizeof(uint32_t)];
+	char		*ep;
+	int		N;
+
+	for (N = 0; N < sizeof(word) / sizeof(word[0]); ++N) {
+
+		word[N] = (uint32_t) strtoul(s, &ep, 16);
+
+		if (ep == s || *ep != ';')
+			return 0;
+
+		s = ep + 1;
+	}
+
+	memcpy(line, word, sizeof(replay_line_t));
+
+	return 1;
+}
+
+int replay_load(replay_t *rp, const char *file)
+{
+	FILE		*fd;
+	char		text[400], sym[80], val[40];
+	uint32_t	hex;
+	int		length_MAX = 0;
+
+	fd = fopen(file, "r");
+
+	if (fd == NULL) {
+
+		fprintf(stderr, "fopen(\"%s\"): failed\n", file);
+		return 0;
+	}
+
+	memset(rp, 0, sizeof(replay_t));
+
+	while (fgets(text, sizeof(text), fd) != NULL) {
+
+		if (rp->length >= length_MAX) {
+
+			length_MAX = (length_MAX != 0) ? length_MAX * 2 : 4096;
+			rp->line = realloc(rp->line, length_MAX * sizeof(replay_line_t));
+		}
+
+		if (replay_hex_line(rp->line + rp->length, text) != 0) {
+
+			rp->length += 1;
+		}
+		else if (sscanf(text, "reg %79s %39s", sym, val) == 2) {
+
+			if (rp->reg_N < REPLAY_REG_MAX) {
+
+				strcpy(rp->reg[rp->reg_N].sym, sym);
+				strcpy(rp->reg[rp->reg_N].val, val);
+
+				rp->reg_N += 1;
+			}
+		}
+		else if (sscanf(text, "# pm.m_freq %x", &hex) == 1) {
+
+			memcpy(&rp->m_freq, &hex, sizeof(float));
+		}
+		else if (sscanf(text, "# pm.dc_resolution %i", &rp->dc_resolution) == 1) {
+
+			/* Nothing to do */
+		}
+	}
+
+	fclose(fd);
+
+	if (		rp->m_freq < 1.f
+			|| rp->dc_resolution < 1
+			|| rp->length < 1) {
+
+		fprintf(stderr, "%s: no valid record found\n", file);
+
+		replay_free(rp);
+
+		return 0;
+	}
+
+	return 1;
+}
+
+void replay_free(replay_t *rp)
+{
+	free(rp->line);
+
+	rp->line = NULL;
+	rp->length = 0;
+}
+
+static void
+replay_proc_DC(int A, int B, int C) { }
+
+static void
+replay_proc_Z(int Z) { }
+
+static int
+replay_reg_lookup(pmc_t *pm, const char *sym, replay_def_t *def, float *scale)
+{
+	/* We take the register list directly from firmware source so each
+	 * symbol is resolved the same way as shell does. Besides the
+	 * configuration you can replay any writable register like setpoint.
+	 * */
+#define REG_DEF(l, e, q, u, f, m, p, t)	{ #l #e, f, #m, (void *) &(l q), #p }
+#define pm				(*pm)
+
+	const replay_def_t		regfile[] = {
+
+#include "pmregs.h"
+
+		{ NULL, NULL, NULL, NULL, NULL }
+	};
+
+#undef pm
+#undef REG_DEF
+
+	const replay_def_t	*reg;
+
+	for (reg = regfile; reg->sym != NULL; ++reg) {
+
+		if (strcmp(reg->sym, sym) == 0)
+			break;
+	}
+
+	if (reg->sym == NULL)
+		return 0;
+
+	if (		   strcmp(reg->proc, "NULL") == 0
+			|| strcmp(reg->proc, "&reg_proc_config_lazy") == 0
+			|| strcmp(reg->proc, "&reg_proc_decimate") == 0) {
+
+		*scale = 1.f;
+	}
+	else if (	   strcmp(reg->proc, "&reg_proc_percent") == 0
+			|| strcmp(reg->proc, "&reg_proc_auto_loop_current") == 0
+			|| strcmp(reg->proc, "&reg_proc_auto_loop_speed") == 0) {
+
+		/* Registers are printed in human units. Undo the scale for
+		 * those that do not keep the raw value.
+		 * */
+		*scale = 0.01f;
+	}
+	else if (strcmp(reg->proc, "&reg_proc_mm") == 0) {
+
+		*scale = 0.001f;
+	}
+	else if (strcmp(reg->proc, "&reg_proc_rpm") == 0) {
+
+		*scale = (M_PI_F / 30.f) * (float) pm->const_Zp;
+	}
+	else if (strcmp(reg->proc, "&reg_proc_rpm_pc") == 0) {
+
+		if (pm->const_lambda < M_EPSILON)
+			return 0;
+
+		*scale = pm->k_EMAX / 100.f * pm->const_fb_U / pm->const_lambda;
+	}
+	else if (strcmp(reg->proc, "&reg_proc_load_nm") == 0) {
+
+		*scale = 1.f / (float) pm->const_Zp;
+	}
+	else if (	   strncmp(reg->proc, "&reg_proc_auto_", 15) == 0
+			|| strcmp(reg->proc, "&reg_proc_current_halt") == 0
+			|| strcmp(reg->proc, "&reg_proc_current_tol") == 0
+			|| strcmp(reg->proc, "&reg_proc_voltage_tol") == 0
+			|| strcmp(reg->proc, "&reg_proc_dc_threshold") == 0
+			|| strcmp(reg->proc, "&reg_proc_wattage") == 0) {
+
+		*scale = 1.f;
+	}
+	else {
+		fprintf(stderr, "%s: units are not supported\n", reg->sym);
+		return 0;
+	}
+
+	*def = *reg;
+
+	return 1;
+}
+
+int replay_reg_set(pmc_t *pm, const char *sym, const char *val)
+{
+	replay_def_t		def;
+	float			scale;
+
+	if (replay_reg_lookup(pm, sym, &def, &scale) == 0)
+		return 0;
+
+	if (strstr(def.mode, "REG_READ_ONLY") != NULL) {
+
+		fprintf(stderr, "%s: register is read only\n", def.sym);
+		return 0;
+	}
+
+	if (		   def.fmt[2] == 'i'
+			|| def.fmt[2] == 'x') {
+
+		* (int *) def.link = (int) strtol(val, NULL, 10);
+	}
+	else {
+		* (float *) def.link = strtof(val, NULL) * scale;
+	}
+
+	if (		   strcmp(def.proc, "&reg_proc_config_lazy") == 0
+			|| strcmp(def.proc, "&reg_proc_decimate") == 0) {
+
+		/* Firmware rebuilds lazy values on write.
+		 * */
+		pm_lazy_build(pm);
+	}
+
+	return 1;
+}
+
+int replay_reg_get(pmc_t *pm, const char *sym, float *val)
+{
+	replay_def_t		def;
+	float			scale;
+
+	if (replay_reg_lookup(pm, sym, &def, &scale) == 0)
+		return 0;
+
+	if (		   def.fmt[2] == 'i'
+			|| def.fmt[2] == 'x') {
+
+		*val = (float) * (int *) def.link;
+	}
+	else {
+		*val = * (float *) def.link / scale;
+	}
+
+	return 1;
+}
+
+void replay_config(const replay_t *rp, pmc_t *pm)
+{
+	int			N;
+
+	memset(pm, 0, sizeof(pmc_t));
+
+	pm->m_freq = rp->m_freq;
+	pm->m_dT = 1.f / pm->m_freq;
+	pm->dc_resolution = rp->dc_resolution;
+	pm->proc_set_DC = &replay_proc_DC;
+	pm->proc_set_Z = &replay_proc_Z;
+
+	pm_auto(pm, PM_AUTO_BASIC_DEFAULT);
+	pm_auto(pm, PM_AUTO_CONFIG_DEFAULT);
+
+	for (N = 0; N < rp->reg_N; ++N) {
+
+		replay_reg_set(pm, rp->reg[N].sym, rp->reg[N].val);
+	}
+}
+
+void replay_run(const replay_t *rp, pmc_t *pm, FILE *fd_log, FILE *fd_tlm)
+{
+	pmfb_t		fb;
+	float		time;
+	int		N, lu_MODE, fsm_errno;
+
+	lu_MODE = pm->lu_MODE;
+	fsm_errno = pm->fsm_errno;
+
+	if (fd_tlm != NULL) {
+
+		fprintf(fd_tlm, "time@s;pm.lu_MODE;pm.lu_iD@A;pm.lu_iQ@A;"
+				"pm.lu_wS@rad/s;pm.lu_F0;pm.lu_F1;pm.fsm_errno;\n");
+	}
+
+	for (N = 0; N < rp->length; ++N) {
+
+		const replay_line_t	*line = rp->line + N;
+
+		if (line->fsm_req != PM_STATE_IDLE) {
+
+			pm->fsm_req = line->fsm_req;
+		}
+
+		/* Copy the feedback as PMC is allowed to modify it.
+		 * */
+		fb = line->fb;
+
+		pm_feedback(pm, &fb);
+
+		time = (float) N * pm->m_dT;
+
+		if (fd_tlm != NULL) {
+
+			fprintf(fd_tlm, "%.7f;%i;%.4f;%.4f;%.4f;%.6f;%.6f;%i;\n",
+					time, pm->lu_MODE, pm->lu_iD, pm->lu_iQ,
+					pm->lu_wS, pm->lu_F[0], pm->lu_F[1],
+					pm->fsm_errno);
+		}
+
+		if (fd_log == NULL)
+			continue;
+
+		if (pm->lu_MODE != lu_MODE) {
+
+			fprintf(fd_log, "%8.6f line %i lu_MODE = %i\n",
+					time, N, pm->lu_MODE);
+
+			lu_MODE = pm->lu_MODE;
+		}
+
+		if (pm->fsm_errno != fsm_errno) {
+
+			fprintf(fd_log, "%8.6f line %i fsm_errno = %s\n",
+					time, N, pm_strerror(pm->fsm_errno));
+
+			fsm_errno = pm->fsm_errno;
+		}
+	}
+}
+
+static long long
+replay_clock()
+{
+	struct timespec		ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+
+	return (long long) ts.tv_sec * 1000000000LL + (long long) ts.tv_nsec;
+}
+
+void replay_script(const char *file)
+{
+	static replay_t		rp;
+	static pmc_t		pm;
+
+	FILE			*fd;
+	long long		clock;
+	double			tREC, tRUN;
+
+	if (replay_load(&rp, file) == 0) {
+
+		exit(1);
+	}
+
+	replay_config(&rp, &pm);
+
+	printf("replay %s: %i lines %i registers\n", file, rp.length, rp.reg_N);
+
+	clock = replay_clock();
+
+	replay_run(&rp, &pm, NULL, NULL);
+
+	clock = replay_clock() - clock;
+
+	tREC = (double) rp.length / rp.m_freq;
+	tRUN = (double) clock * 1.e-9;
+
+	printf("record %.3f (s) replay %.3f (s) speedup %.1f %.1f (ns/line)\n",
+			tREC, tRUN, tREC / tRUN, (double) clock / rp.length);
+
+	/* Second pass is logged. Since replay is deterministic it gives
+	 * the same result as the timed one.
+	 * */
+	replay_config(&rp, &pm);
+
+	fd = fopen(REPLAY_FILE, "w");
+
+	if (fd == NULL) {
+
+		fprintf(stderr, "fopen(\"%s\"): failed\n", REPLAY_FILE);
+		exit(1);
+	}
+
+	replay_run(&rp, &pm, stdout, fd);
+
+	fclose(fd);
+
+	printf("fsm_errno = %s\n", pm_strerror(pm.fsm_errno));
+
+	replay_free(&rp);
+}
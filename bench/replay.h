@@ -0,0 +1,51 @@
+#ifndef _H_REPLAY_
+#define _H_REPLAY_
+
+#include <stdio.h>
+
+#include "pm.h"
+
+#define REPLAY_REG_MAX		1000
+
+/* Record line is the same as in firmware telemetry.
+ * */
+typedef struct {
+
+	pmfb_t		fb;
+	int		fsm_req;
+}
+replay_line_t;
+
+typedef struct {
+
+	char		sym[80];
+	char		val[40];
+}
+replay_reg_t;
+
+typedef struct {
+
+	float		m_freq;
+	int		dc_resolution;
+
+	replay_reg_t	reg[REPLAY_REG_MAX];
+	int		reg_N;
+
+	replay_line_t	*line;
+	int		length;
+}
+replay_t;
+
+int replay_load(replay_t *rp, const char *file);
+void replay_free(replay_t *rp);
+
+int replay_reg_set(pmc_t *pm, const char *sym, const char *val);
+int replay_reg_get(pmc_t *pm, const char *sym, float *val);
+void replay_config(const replay_t *rp, pmc_t *pm);
+void replay_run(const replay_t *rp, pmc_t *pm, FILE *fd_log, FILE *fd_tlm);
+
+void replay_script(const char *file);
+void sweep_script(int njobs, const char *grid, const char *file);
+
+#endif /* _H_REPLAY_ */
+
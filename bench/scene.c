@@ -0,0 +1,508 @@
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <stddef.h>
+#include <math.h>
+#include <errno.h>
+#include <time.h>
+#include <setjmp.h>
+#include <pthread.h>
+
+#include "blm.h"
+#include "lfg.h"
+#include "pm.h"
+#include "replay.h"
+#include "tsfunc.h"
+
+typedef struct {
+
+	const char	*sym;
+	int		offset;
+	int		type;
+}
+scene_motor_t;
+
+enum {
+	SCENE_DOUBLE		= 0,
+	SCENE_INT,
+	SCENE_KV
+};
+
+#define SCENE_MOTOR(x, t)	{ #x, offsetof(blm_t, x), t }
+
+static const scene_motor_t	scene_motor[] = {
+
+	SCENE_MOTOR(Rs, SCENE_DOUBLE),
+	SCENE_MOTOR(Ld, SCENE_DOUBLE),
+	SCENE_MOTOR(Lq, SCENE_DOUBLE),
+	SCENE_MOTOR(lambda, SCENE_DOUBLE),
+	SCENE_MOTOR(Zp, SCENE_INT),
+	{ "Kv", 0, SCENE_KV },
+	SCENE_MOTOR(Ta, SCENE_DOUBLE),
+	SCENE_MOTOR(Ct, SCENE_DOUBLE),
+	SCENE_MOTOR(Rt, SCENE_DOUBLE),
+	SCENE_MOTOR(Udc, SCENE_DOUBLE),
+	SCENE_MOTOR(Rdc, SCENE_DOUBLE),
+	SCENE_MOTOR(Cdc, SCENE_DOUBLE),
+	SCENE_MOTOR(Jm, SCENE_DOUBLE),
+	SCENE_MOTOR(pwm_deadtime, SCENE_DOUBLE),
+	SCENE_MOTOR(slow_dT, SCENE_DOUBLE),
+	SCENE_MOTOR(unsync_flag, SCENE_INT),
+
+	{ "wS", offsetof(blm_t, state[2]), SCENE_DOUBLE },
+	{ "Tc", offsetof(blm_t, state[4]), SCENE_DOUBLE },
+	{ "Uc", offsetof(blm_t, state[6]), SCENE_DOUBLE },
+	SCENE_MOTOR(drain_wP, SCENE_DOUBLE),
+
+	{ NULL, 0, 0 }
+};
+
+typedef struct {
+
+	const char	*file;
+
+	int		passed;
+	int		nassert;
+	double		tSIM;
+
+	char		reason[200];
+
+	char		*log_buf;
+	size_t		log_len;
+}
+scene_job_t;
+
+typedef struct {
+
+	scene_job_t	*job;
+	int		job_N;
+
+	int		solver;
+	int		seed;
+	int		next;
+
+	int		failed;
+
+	pthread_mutex_t	lock;
+}
+scene_pool_t;
+
+static const scene_motor_t *
+scene_motor_find(const char *sym)
+{
+	const scene_motor_t	*mot;
+
+	for (mot = scene_motor; mot->sym != NULL; ++mot) {
+
+		if (strcmp(mot->sym, sym) == 0)
+			return mot;
+	}
+
+	return NULL;
+}
+
+static int
+scene_motor_set(sim_t *S, const char *sym, const char *val)
+{
+	const scene_motor_t	*mot;
+
+	mot = scene_motor_find(sym);
+
+	if (mot == NULL)
+		return 0;
+
+	if (mot->type == SCENE_DOUBLE) {
+
+		* (double *) ((char *) &S->m + mot->offset) = strtod(val, NULL);
+	}
+	else if (mot->type == SCENE_INT) {
+
+		* (int *) ((char *) &S->m + mot->offset) = (int) strtol(val, NULL, 10);
+	}
+	else {
+		S->m.lambda = blm_Kv_lambda(&S->m, strtod(val, NULL));
+	}
+
+	return 1;
+}
+
+static int
+scene_read(sim_t *S, const char *sym, double *val)
+{
+	const scene_motor_t	*mot;
+	float			reg;
+
+	if (strncmp(sym, "m.", 2) == 0) {
+
+		/* Machine constant or state.
+		 * */
+		mot = scene_motor_find(sym + 2);
+
+		if (mot == NULL || mot->type == SCENE_KV)
+			return 0;
+
+		if (mot->type == SCENE_DOUBLE) {
+
+			*val = * (double *) ((char *) &S->m + mot->offset);
+		}
+		else {
+			*val = (double) * (int *) ((char *) &S->m + mot->offset);
+		}
+
+		return 1;
+	}
+
+	if (replay_reg_get(&S->pm, sym, &reg) != 0) {
+
+		*val = (double) reg;
+		return 1;
+	}
+
+	return 0;
+}
+
+static int
+scene_value(sim_t *S, const char *tok, double *val)
+{
+	char		*ep;
+
+	*val = strtod(tok, &ep);
+
+	if (ep != tok && *ep == 0)
+		return 1;
+
+	/* Reference value may be another register.
+	 * */
+	return scene_read(S, tok, val);
+}
+
+/* Scenario file consists of lines that are executed in order.
+ *
+ *	motor <sym> <val>		machine constant (Rs Ld Lq Zp Kv Udc Jm ...)
+ *	tune				self adjust and probe PMC on the machine
+ *	reg <sym> <val>			write PMC register
+ *	startup				start PMC and wait for IDLE
+ *	shutdown			stop PMC and wait for IDLE
+ *	wait <spinup|motion|idle>	wait for condition
+ *	load <Mq0> [<Mq1> ...]		load torque polynomial (Nm)
+ *	run <dT>			run simulation for dT seconds
+ *	at <time>			run simulation until the time counted
+ *					from the end of tune
+ *	assert <sym> <ref> <tol>	check that |sym - ref| < tol, where ref
+ *					is a number or another register
+ *
+ * Symbols with "m." prefix refer to the machine (m.Tc is temperature, m.Uc
+ * is DC link voltage, m.wS is electrical speed).
+ *
+ * */
+static void
+scene_run(sim_t *S, scene_job_t *job, FILE *fd)
+{
+	char		text[400], *tok, *arg[5];
+	double		tMARK = 0., tSTART, val, ref, tol;
+	int		line = 0, ready = 0, N;
+
+	tSTART = S->m.time;
+
+	while (fgets(text, sizeof(text), fd) != NULL) {
+
+		line += 1;
+
+		tok = strtok(text, " \t\r\n");
+
+		if (tok == NULL || *tok == '#')
+			continue;
+
+		for (N = 0; N < 5; ++N) {
+
+			arg[N] = strtok(NULL, " \t\r\n");
+		}
+
+		if (		ready == 0
+				&& strcmp(tok, "motor") != 0) {
+
+			/* Default configuration goes first so that
+			 * it does not overwrite register writes.
+			 * */
+			ts_script_default(S);
+			ready = 1;
+		}
+
+		if (strcmp(tok, "motor") == 0 && arg[1] != NULL) {
+
+			if (scene_motor_set(S, arg[0], arg[1]) == 0) {
+
+				snprintf(job->reason, sizeof(job->reason),
+						"line %i: unknown motor constant \"%s\"",
+						line, arg[0]);
+				break;
+			}
+		}
+		else if (strcmp(tok, "tune") == 0) {
+
+			ts_script_base(S);
+			blm_restart(&S->m);
+
+			tMARK = S->m.time;
+		}
+		else if (strcmp(tok, "reg") == 0 && arg[1] != NULL) {
+
+			if (replay_reg_set(&S->pm, arg[0], arg[1]) == 0) {
+
+				snprintf(job->reason, sizeof(job->reason),
+						"line %i: unable to write \"%s\"",
+						line, arg[0]);
+				break;
+			}
+		}
+		else if (	   strcmp(tok, "startup") == 0
+				|| strcmp(tok, "shutdown") == 0) {
+
+			S->pm.fsm_req = (strcmp(tok, "startup") == 0)
+				? PM_STATE_LU_STARTUP : PM_STATE_LU_SHUTDOWN;
+
+			if (ts_wait_IDLE(S) != PM_OK) {
+
+				snprintf(job->reason, sizeof(job->reason),
+						"line %i: %s fsm_errno = %s", line, tok,
+						pm_strerror(S->pm.fsm_errno));
+				break;
+			}
+		}
+		else if (strcmp(tok, "wait") == 0 && arg[0] != NULL) {
+
+			if (strcmp(arg[0], "spinup") == 0) {
+
+				N = ts_wait_spinup(S);
+			}
+			else if (strcmp(arg[0], "motion") == 0) {
+
+				N = ts_wait_motion(S);
+			}
+			else if (strcmp(arg[0], "idle") == 0) {
+
+				N = ts_wait_IDLE(S);
+			}
+			else {
+				snprintf(job->reason, sizeof(job->reason),
+						"line %i: unknown condition \"%s\"",
+						line, arg[0]);
+				break;
+			}
+
+			if (N != PM_OK) {
+
+				snprintf(job->reason, sizeof(job->reason),
+						"line %i: wait %s fsm_errno = %s", line,
+						arg[0], pm_strerror(S->pm.fsm_errno));
+				break;
+			}
+		}
+		else if (strcmp(tok, "load") == 0 && arg[0] != NULL) {
+
+			for (N = 0; N < 4; ++N) {
+
+				S->m.Mq[N] = (arg[N] != NULL) ? strtod(arg[N], NULL) : 0.;
+			}
+		}
+		else if (strcmp(tok, "run") == 0 && arg[0] != NULL) {
+
+			sim_runtime(S, strtod(arg[0], NULL));
+		}
+		else if (strcmp(tok, "at") == 0 && arg[0] != NULL) {
+
+			val = tMARK + strtod(arg[0], NULL) - S->m.time;
+
+			if (val > 0.) {
+
+				sim_runtime(S, val);
+			}
+		}
+		else if (strcmp(tok, "assert") == 0 && arg[2] != NULL) {
+
+			if (		scene_read(S, arg[0], &val) == 0
+					|| scene_value(S, arg[1], &ref) == 0
+					|| scene_value(S, arg[2], &tol) == 0) {
+
+				snprintf(job->reason, sizeof(job->reason),
+						"line %i: unable to read \"%s\"",
+						line, arg[0]);
+				break;
+			}
+
+			job->nassert += 1;
+
+			if (fabs(val - ref) > fabs(tol)) {
+
+				snprintf(job->reason, sizeof(job->reason),
+						"line %i: assert %s = %.4g not %.4g +/- %.4g",
+						line, arg[0], val, ref, tol);
+				break;
+			}
+
+			fprintf(S->fd_log, "%s = %.4g\n", arg[0], val);
+		}
+		else {
+			snprintf(job->reason, sizeof(job->reason),
+					"line %i: unknown command \"%s\"", line, tok);
+			break;
+		}
+	}
+
+	job->tSIM = S->m.time - tSTART;
+	job->passed = (job->reason[0] == 0) ? 1 : 0;
+}
+
+static void
+scene_pool_run(scene_pool_t *pool, int N)
+{
+	scene_job_t	*job = &pool->job[N];
+	sim_t		*S;
+	FILE		*fd;
+	jmp_buf		fault;
+
+	fd = fopen(job->file, "r");
+
+	if (fd == NULL) {
+
+		snprintf(job->reason, sizeof(job->reason), "fopen: %s", strerror(errno));
+	}
+
+	S = calloc(1, sizeof(sim_t));
+
+	if (S == NULL) {
+
+		fprintf(stderr, "calloc: %s\n", strerror(errno));
+		abort();
+	}
+
+	lfg_start(pool->seed + N);
+
+	S->unit = N + 1;
+	S->fd_log = open_memstream(&job->log_buf, &job->log_len);
+	S->m.solver = pool->solver;
+
+	blm_enable(&S->m);
+	blm_restart(&S->m);
+
+	S->fault = &fault;
+
+	if (fd == NULL) {
+
+		/* Nothing to do */
+	}
+	else if (setjmp(fault) == 0) {
+
+		scene_run(S, job, fd);
+	}
+	else {
+		/* We get here on fsm_errno or on probe assert.
+		 * */
+		if (S->pm.fsm_errno != PM_OK) {
+
+			snprintf(job->reason, sizeof(job->reason), "fault at %.3f (s) fsm_errno = %s",
+					S->m.time, pm_strerror(S->pm.fsm_errno));
+		}
+		else {
+			snprintf(job->reason, sizeof(job->reason), "fault at %.3f (s) tune assert",
+					S->m.time);
+		}
+
+		job->passed = 0;
+	}
+
+	if (fd != NULL) {
+
+		fclose(fd);
+	}
+
+	tlm_stop(S);
+	fclose(S->fd_log);
+	free(S);
+
+	/* Stream the result as soon as the scenario is done.
+	 * */
+	pthread_mutex_lock(&pool->lock);
+
+	if (job->passed != 0) {
+
+		printf("PASS %s (%i asserts %.3f s)\n", job->file, job->nassert, job->tSIM);
+	}
+	else {
+		fwrite(job->log_buf, 1, job->log_len, stdout);
+		printf("FAIL %s: %s\n", job->file, job->reason);
+
+		pool->failed += 1;
+	}
+
+	fflush(stdout);
+
+	pthread_mutex_unlock(&pool->lock);
+
+	free(job->log_buf);
+}
+
+static void *
+scene_pool_thread(void *arg)
+{
+	scene_pool_t	*pool = (scene_pool_t *) arg;
+	int		N;
+
+	while ((N = __sync_fetch_and_add(&pool->next, 1)) < pool->job_N) {
+
+		scene_pool_run(pool, N);
+	}
+
+	return NULL;
+}
+
+int scene_script(int njobs, int solver, int nfiles, char *files[])
+{
+	scene_pool_t	pool;
+	pthread_t	*thread;
+	int		N;
+
+	memset(&pool, 0, sizeof(pool));
+
+	pool.job = calloc(nfiles, sizeof(scene_job_t));
+	thread = calloc(njobs, sizeof(pthread_t));
+
+	if (pool.job == NULL || thread == NULL) {
+
+		fprintf(stderr, "calloc: %s\n", strerror(errno));
+		abort();
+	}
+
+	for (N = 0; N < nfiles; ++N) {
+
+		pool.job[N].file = files[N];
+	}
+
+	njobs = (njobs > nfiles) ? nfiles : njobs;
+
+	pool.job_N = nfiles;
+	pool.solver = solver;
+	pool.seed = (int) time(NULL);
+
+	pthread_mutex_init(&pool.lock, NULL);
+
+	for (N = 0; N < njobs; ++N) {
+
+		pthread_create(&thread[N], NULL, &scene_pool_thread, &pool);
+	}
+
+	for (N = 0; N < njobs; ++N) {
+
+		pthread_join(thread[N], NULL);
+	}
+
+	pthread_mutex_destroy(&pool.lock);
+
+	printf("%i of %i scenarios passed\n", nfiles - pool.failed, nfiles);
+
+	free(pool.job);
+	free(thread);
+
+	return pool.failed;
+}
+
@@ -0,0 +1,189 @@
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <math.h>
+
+#include "blm.h"
+#include "lfg.h"
+#include "pm.h"
+#include "tsfunc.h"
+
+/* Number of PWM cycles recorded after the current step.
+ * */
+#define STEP_CYCLES		400
+
+/* Steady state is taken from this cycle on.
+ * */
+#define STEP_STEADY		200
+
+typedef struct {
+
+	const char	*name;
+
+	double		Rs;
+	double		Ld;
+	double		Lq;
+	double		Udc;
+	int		Zp;
+	double		Kv;
+
+	/* Current step in Ampere.
+	 * */
+	float		iSP;
+}
+step_motor_t;
+
+typedef struct {
+
+	const char	*name;
+
+	int		config_CC_DEADBEAT;
+}
+step_loop_t;
+
+static const step_motor_t	step_motor_list[] = {
+
+	{ "XNOVA", 8.e-3, 3.e-6, 5.e-6, 48., 5, 525., 20.f },
+	{ "RotoMax", 14.e-3, 10.e-6, 15.e-6, 22., 14, 270., 20.f }
+};
+
+static const step_loop_t	step_loop_list[] = {
+
+	{ "PI", PM_DISABLED },
+	{ "deadbeat", PM_ENABLED }
+};
+
+#define STEP_MOTOR_MAX		(sizeof(step_motor_list) / sizeof(step_motor_list[0]))
+#define STEP_LOOP_MAX		(sizeof(step_loop_list) / sizeof(step_loop_list[0]))
+
+static void
+step_response(sim_t *S, const step_motor_t *mt, const step_loop_t *lp)
+{
+	pmfb_t		fb;
+	double		iQ, eQ, eD, rQ = 0., rD = 0., iMAX = 0.;
+	int		rise = -1, i;
+
+	/* Spin up by speed loop with PI current regulator.
+	 * */
+	S->pm.config_CC_DEADBEAT = PM_DISABLED;
+	S->pm.config_LU_DRIVE = PM_DRIVE_SPEED;
+
+	S->pm.s_accel_forward = 300000.f;
+	S->pm.s_accel_reverse = S->pm.s_accel_forward;
+
+	pm_lazy_build(&S->pm);
+
+	S->pm.fsm_req = PM_STATE_LU_STARTUP;
+	ts_wait_IDLE(S);
+
+	S->pm.s_setpoint_speed = 30.f * S->pm.k_EMAX / 100.f
+			* S->pm.const_fb_U / S->pm.const_lambda;
+
+	ts_wait_spinup(S);
+	sim_runtime(S, 0.2);
+
+	/* Hold the speed by large inertia and go to current control.
+	 * */
+	S->m.Jm = 1.;
+
+	S->pm.config_LU_DRIVE = PM_DRIVE_CURRENT;
+	S->pm.config_CC_DEADBEAT = lp->config_CC_DEADBEAT;
+	S->pm.config_CC_SPEED_TRACK = PM_DISABLED;
+	S->pm.i_setpoint_current = 0.f;
+	S->pm.i_slew_rate = 1.e+9f;
+
+	pm_lazy_build(&S->pm);
+
+	sim_runtime(S, 0.05);
+
+	S->pm.i_setpoint_current = mt->iSP;
+
+	sim_local = S;
+
+	for (i = 0; i < STEP_CYCLES; ++i) {
+
+		blm_update(&S->m);
+		sim_feedback(S, &fb);
+		pm_feedback(&S->pm, &fb);
+
+		iQ = S->m.state[1];
+
+		if (rise < 0 && iQ >= 0.9 * mt->iSP) {
+
+			rise = i + 1;
+		}
+
+		iMAX = (iQ > iMAX) ? iQ : iMAX;
+
+		if (i >= STEP_STEADY) {
+
+			eQ = iQ - mt->iSP;
+			eD = S->m.state[0] - S->pm.i_track_D;
+
+			rQ += eQ * eQ;
+			rD += eD * eD;
+		}
+	}
+
+	rQ = sqrt(rQ / (STEP_CYCLES - STEP_STEADY));
+	rD = sqrt(rD / (STEP_CYCLES - STEP_STEADY));
+
+	printf("%s;%s;%i;%.1f;%.3f;%.3f;%i;%s;\n", mt->name, lp->name, rise,
+			(iMAX / mt->iSP - 1.) * 100., rQ, rD,
+			S->pm.lu_MODE, pm_strerror(S->pm.fsm_errno));
+}
+
+void step_script()
+{
+	sim_t		*S, *base;
+	int		N, K;
+
+	S = calloc(1, sizeof(sim_t));
+	base = calloc(1, sizeof(sim_t));
+
+	if (S == NULL || base == NULL) {
+
+		fprintf(stderr, "calloc: failed\n");
+		abort();
+	}
+
+	printf("motor;loop;rise@cycles;overshoot@%%;ripple_Q@A;ripple_D@A;lu_MODE;fsm_errno;\n");
+
+	for (N = 0; N < (int) STEP_MOTOR_MAX; ++N) {
+
+		const step_motor_t	*mt = &step_motor_list[N];
+
+		memset(S, 0, sizeof(sim_t));
+
+		S->fd_log = stderr;
+
+		blm_enable(&S->m);
+		blm_restart(&S->m);
+
+		S->m.Rs = mt->Rs;
+		S->m.Ld = mt->Ld;
+		S->m.Lq = mt->Lq;
+		S->m.Udc = mt->Udc;
+		S->m.Rdc = 0.1;
+		S->m.Zp = mt->Zp;
+		S->m.lambda = blm_Kv_lambda(&S->m, mt->Kv);
+		S->m.Jm = 2.e-4;
+
+		ts_script_default(S);
+		ts_script_base(S);
+		blm_restart(&S->m);
+
+		memcpy(base, S, sizeof(sim_t));
+
+		for (K = 0; K < (int) STEP_LOOP_MAX; ++K) {
+
+			memcpy(S, base, sizeof(sim_t));
+
+			step_response(S, mt, &step_loop_list[K]);
+		}
+	}
+
+	free(S);
+	free(base);
+}
+
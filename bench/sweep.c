@@ -0,0 +1,496 @@
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <math.h>
+#include <time.h>
+#include <pthread.h>
+
+#include "pm.h"
+#include "replay.h"
+
+#define SWEEP_AXIS_MAX		8
+#define SWEEP_VALUE_MAX		32
+#define SWEEP_REG_MAX		40
+
+typedef struct {
+
+	char		sym[80];
+	char		val[SWEEP_VALUE_MAX][40];
+	int		val_N;
+}
+sweep_axis_t;
+
+typedef struct {
+
+	float		vsi_X;
+	float		vsi_Y;
+
+	int		vsi_AF;
+	int		vsi_BF;
+	int		vsi_CF;
+	int		vsi_IF;
+	int		vsi_UF;
+}
+sweep_drive_t;
+
+typedef struct {
+
+	int		index;
+	int		fsm_errno;
+
+	double		angle_RMS;
+	double		speed_RMS;
+	long		count;
+}
+sweep_point_t;
+
+typedef struct {
+
+	const replay_t	*rp;
+
+	/* Registers applied to every run.
+	 * */
+	replay_reg_t	reg[SWEEP_REG_MAX];
+	int		reg_N;
+
+	/* Registers applied to the reference run only.
+	 * */
+	replay_reg_t	ref[SWEEP_REG_MAX];
+	int		ref_N;
+
+	sweep_axis_t	axis[SWEEP_AXIS_MAX];
+	int		axis_N;
+
+	/* Voltage that was actually applied on each line.
+	 * */
+	sweep_drive_t	*drive;
+
+	/* Reference angle and speed on each line.
+	 * */
+	float		*ref_F;
+	float		*ref_wS;
+
+	sweep_point_t	*point;
+	int		point_N;
+	int		next;
+}
+sweep_t;
+
+/* Grid file consists of lines as follows.
+ *
+ *	reg <sym> <val>			applied to every run
+ *	ref <sym> <val>			applied to the reference run only
+ *	grid <sym> <val> <val> ...	the grid axis
+ *
+ * */
+static int
+sweep_load(sweep_t *sw, const char *file)
+{
+	FILE		*fd;
+	char		text[1000], *tok;
+	int		N;
+
+	fd = fopen(file, "r");
+
+	if (fd == NULL) {
+
+		fprintf(stderr, "fopen(\"%s\"): failed\n", file);
+		return 0;
+	}
+
+	while (fgets(text, sizeof(text), fd) != NULL) {
+
+		replay_reg_t	*reg = NULL;
+
+		tok = strtok(text, " \t\r\n");
+
+		if (tok == NULL || *tok == '#')
+			continue;
+
+		if (strcmp(tok, "reg") == 0 && sw->reg_N < SWEEP_REG_MAX) {
+
+			reg = &sw->reg[sw->reg_N++];
+		}
+		else if (strcmp(tok, "ref") == 0 && sw->ref_N < SWEEP_REG_MAX) {
+
+			reg = &sw->ref[sw->ref_N++];
+		}
+		else if (strcmp(tok, "grid") == 0 && sw->axis_N < SWEEP_AXIS_MAX) {
+
+			sweep_axis_t	*axis = &sw->axis[sw->axis_N++];
+
+			tok = strtok(NULL, " \t\r\n");
+
+			if (tok == NULL)
+				continue;
+
+			snprintf(axis->sym, sizeof(axis->sym), "%s", tok);
+
+			while (		(tok = strtok(NULL, " \t\r\n")) != NULL
+					&& axis->val_N < SWEEP_VALUE_MAX) {
+
+				snprintf(axis->val[axis->val_N++], 40, "%s", tok);
+			}
+
+			continue;
+		}
+		else {
+			fprintf(stderr, "%s: unknown line \"%s\"\n", file, tok);
+			continue;
+		}
+
+		tok = strtok(NULL, " \t\r\n");
+		snprintf(reg->sym, sizeof(reg->sym), "%s", (tok != NULL) ? tok : "");
+
+		tok = strtok(NULL, " \t\r\n");
+		snprintf(reg->val, sizeof(reg->val), "%s", (tok != NULL) ? tok : "");
+	}
+
+	fclose(fd);
+
+	sw->point_N = 1;
+
+	for (N = 0; N < sw->axis_N; ++N) {
+
+		if (sw->axis[N].val_N < 1) {
+
+			fprintf(stderr, "%s: no values for %s\n", file, sw->axis[N].sym);
+			return 0;
+		}
+
+		sw->point_N *= sw->axis[N].val_N;
+	}
+
+	return 1;
+}
+
+static const char *
+sweep_value(const sweep_t *sw, int index, int A)
+{
+	int		N;
+
+	for (N = 0; N < A; ++N) {
+
+		index /= sw->axis[N].val_N;
+	}
+
+	return sw->axis[A].val[index % sw->axis[A].val_N];
+}
+
+static void
+sweep_config(const sweep_t *sw, pmc_t *pm, int index)
+{
+	int		N;
+
+	replay_config(sw->rp, pm);
+
+	for (N = 0; N < sw->reg_N; ++N) {
+
+		replay_reg_set(pm, sw->reg[N].sym, sw->reg[N].val);
+	}
+
+	if (index < 0) {
+
+		for (N = 0; N < sw->ref_N; ++N) {
+
+			replay_reg_set(pm, sw->ref[N].sym, sw->ref[N].val);
+		}
+	}
+	else {
+		for (N = 0; N < sw->axis_N; ++N) {
+
+			replay_reg_set(pm, sw->axis[N].sym, sweep_value(sw, index, N));
+		}
+	}
+}
+
+static void
+sweep_drive_get(sweep_drive_t *dr, const pmc_t *pm)
+{
+	dr->vsi_X = pm->vsi_X;
+	dr->vsi_Y = pm->vsi_Y;
+
+	dr->vsi_AF = pm->vsi_AF;
+	dr->vsi_BF = pm->vsi_BF;
+	dr->vsi_CF = pm->vsi_CF;
+	dr->vsi_IF = pm->vsi_IF;
+	dr->vsi_UF = pm->vsi_UF;
+}
+
+static void
+sweep_drive_set(const sweep_drive_t *dr, pmc_t *pm)
+{
+	pm->vsi_X = dr->vsi_X;
+	pm->vsi_Y = dr->vsi_Y;
+
+	pm->vsi_AF = dr->vsi_AF;
+	pm->vsi_BF = dr->vsi_BF;
+	pm->vsi_CF = dr->vsi_CF;
+	pm->vsi_IF = dr->vsi_IF;
+	pm->vsi_UF = dr->vsi_UF;
+}
+
+static void
+sweep_step(const sweep_t *sw, pmc_t *pm, int N)
+{
+	const replay_line_t	*line = sw->rp->line + N;
+	pmfb_t			fb;
+
+	if (line->fsm_req != PM_STATE_IDLE) {
+
+		pm->fsm_req = line->fsm_req;
+	}
+
+	fb = line->fb;
+
+	pm_feedback(pm, &fb);
+
+	/* Recorded feedback does not respond to the voltage that we
+	 * produce. So we substitute the voltage that was actually applied
+	 * to keep estimate consistent with the feedback.
+	 * */
+	sweep_drive_set(&sw->drive[N], pm);
+}
+
+static void
+sweep_reference(sweep_t *sw)
+{
+	const replay_t		*rp = sw->rp;
+	pmc_t			*pm;
+	pmfb_t			fb;
+	int			N;
+
+	pm = malloc(sizeof(pmc_t));
+
+	sw->drive = malloc(rp->length * sizeof(sweep_drive_t));
+	sw->ref_F = malloc(rp->length * 2 * sizeof(float));
+	sw->ref_wS = malloc(rp->length * sizeof(float));
+
+	/* Replay the recorded configuration to get the applied voltage.
+	 * */
+	replay_config(rp, pm);
+
+	for (N = 0; N < rp->length; ++N) {
+
+		if (rp->line[N].fsm_req != PM_STATE_IDLE) {
+
+			pm->fsm_req = rp->line[N].fsm_req;
+		}
+
+		fb = rp->line[N].fb;
+
+		pm_feedback(pm, &fb);
+
+		sweep_drive_get(&sw->drive[N], pm);
+	}
+
+	sweep_config(sw, pm, -1);
+
+	for (N = 0; N < rp->length; ++N) {
+
+		sweep_step(sw, pm, N);
+
+		/* We mark the lines where reference is not valid.
+		 * */
+		sw->ref_F[N * 2 + 0] = (pm->lu_MODE != PM_LU_DISABLED) ? pm->lu_F[0] : 0.f;
+		sw->ref_F[N * 2 + 1] = (pm->lu_MODE != PM_LU_DISABLED) ? pm->lu_F[1] : 0.f;
+		sw->ref_wS[N] = pm->lu_wS;
+	}
+
+	if (pm->fsm_errno != PM_OK) {
+
+		fprintf(stderr, "reference fsm_errno = %s\n", pm_strerror(pm->fsm_errno));
+	}
+
+	free(pm);
+}
+
+static void
+sweep_point(const sweep_t *sw, sweep_point_t *pt, pmc_t *pm)
+{
+	const replay_t		*rp = sw->rp;
+	double			eA, eW, sA = 0., sW = 0.;
+	int			N;
+
+	sweep_config(sw, pm, pt->index);
+
+	pt->count = 0;
+
+	for (N = 0; N < rp->length; ++N) {
+
+		sweep_step(sw, pm, N);
+
+		if (pm->fsm_errno != PM_OK)
+			break;
+
+		if (		pm->lu_MODE == PM_LU_DISABLED
+				|| (sw->ref_F[N * 2 + 0] == 0.f
+				 && sw->ref_F[N * 2 + 1] == 0.f))
+			continue;
+
+		/* Observer error is the angle between position estimate and
+		 * reference position.
+		 * */
+		eA = atan2(sw->ref_F[N * 2 + 0] * pm->lu_F[1]
+				- sw->ref_F[N * 2 + 1] * pm->lu_F[0],
+				sw->ref_F[N * 2 + 0] * pm->lu_F[0]
+				+ sw->ref_F[N * 2 + 1] * pm->lu_F[1]);
+
+		eW = pm->lu_wS - sw->ref_wS[N];
+
+		sA += eA * eA;
+		sW += eW * eW;
+
+		pt->count += 1;
+	}
+
+	pt->fsm_errno = pm->fsm_errno;
+
+	pt->angle_RMS = (pt->count > 0) ? sqrt(sA / pt->count) * (180. / M_PI) : HUGE_VAL;
+	pt->speed_RMS = (pt->count > 0) ? sqrt(sW / pt->count) : HUGE_VAL;
+}
+
+static void *
+sweep_thread(void *arg)
+{
+	sweep_t		*sw = (sweep_t *) arg;
+	pmc_t		*pm;
+	int		N;
+
+	pm = malloc(sizeof(pmc_t));
+
+	do {
+		N = __sync_fetch_and_add(&sw->next, 1);
+
+		if (N >= sw->point_N)
+			break;
+
+		sw->point[N].index = N;
+
+		sweep_point(sw, &sw->point[N], pm);
+	}
+	while (1);
+
+	free(pm);
+
+	return NULL;
+}
+
+static int
+sweep_cmp(const void *a, const void *b)
+{
+	const sweep_point_t	*pa = (const sweep_point_t *) a;
+	const sweep_point_t	*pb = (const sweep_point_t *) b;
+
+	if (pa->fsm_errno != pb->fsm_errno) {
+
+		/* Failed points go to the end.
+		 * */
+		return (pa->fsm_errno == PM_OK) ? -1 : (pb->fsm_errno == PM_OK) ? 1 : 0;
+	}
+
+	return    (pa->angle_RMS < pb->angle_RMS) ? -1
+		: (pa->angle_RMS > pb->angle_RMS) ? 1
+		: (pa->speed_RMS < pb->speed_RMS) ? -1
+		: (pa->speed_RMS > pb->speed_RMS) ? 1 : 0;
+}
+
+static long long
+sweep_clock()
+{
+	struct timespec		ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+
+	return (long long) ts.tv_sec * 1000000000LL + (long long) ts.tv_nsec;
+}
+
+void sweep_script(int njobs, const char *grid, const char *file)
+{
+	static replay_t		rp;
+	static sweep_t		sw;
+
+	pthread_t		*thread;
+	long long		clock;
+	int			N, A;
+
+	if (replay_load(&rp, file) == 0) {
+
+		exit(1);
+	}
+
+	sw.rp = &rp;
+
+	if (sweep_load(&sw, grid) == 0) {
+
+		exit(1);
+	}
+
+	sw.point = calloc(sw.point_N, sizeof(sweep_point_t));
+
+	printf("sweep %s: %i lines %i points %i jobs\n",
+			file, rp.length, sw.point_N, njobs);
+
+	clock = sweep_clock();
+
+	sweep_reference(&sw);
+
+	if (njobs > 1) {
+
+		thread = calloc(njobs, sizeof(pthread_t));
+
+		for (N = 0; N < njobs; ++N) {
+
+			pthread_create(&thread[N], NULL, &sweep_thread, &sw);
+		}
+
+		for (N = 0; N < njobs; ++N) {
+
+			pthread_join(thread[N], NULL);
+		}
+
+		free(thread);
+	}
+	else {
+		sweep_thread(&sw);
+	}
+
+	clock = sweep_clock() - clock;
+
+	qsort(sw.point, sw.point_N, sizeof(sweep_point_t), &sweep_cmp);
+
+	printf("elapsed %.3f (s) %.1f (points/s)\n", (double) clock * 1.e-9,
+			(double) sw.point_N / ((double) clock * 1.e-9));
+
+	printf("rank;angle_RMS@deg;speed_RMS@rad/s;fsm_errno;");
+
+	for (A = 0; A < sw.axis_N; ++A) {
+
+		printf("%s;", sw.axis[A].sym);
+	}
+
+	puts("");
+
+	for (N = 0; N < sw.point_N; ++N) {
+
+		const sweep_point_t	*pt = &sw.point[N];
+
+		printf("%i;%.4f;%.4f;%s;", N + 1, pt->angle_RMS, pt->speed_RMS,
+				pm_strerror(pt->fsm_errno));
+
+		for (A = 0; A < sw.axis_N; ++A) {
+
+			printf("%s;", sweep_value(&sw, pt->index, A));
+		}
+
+		puts("");
+	}
+
+	free(sw.drive);
+	free(sw.ref_F);
+	free(sw.ref_wS);
+	free(sw.point);
+
+	replay_free(&rp);
+}
+
@@ -3,6 +3,8 @@
 #include <math.h>
 #include <string.h>
 #include <errno.h>
+#include <time.h>
+#include <pthread.h>
 
 #include "blm.h"
 #include "lfg.h"
@@ -13,24 +15,24 @@
 #define TS_TOL			0.2
 
 #define TS_printf(s)		fprintf(stderr, "%s in %s:%i\n", (s), __FILE__, __LINE__)
-#define TS_assert(x)		if ((x) == 0) { TS_printf(#x); exit(-1); }
+#define TS_assert(x)		if ((x) == 0) { TS_printf(#x); sim_fault(sim_local); exit(-1); }
 
 #define TS_assert_absolute(x, r, a)	TS_assert(fabs((x) - (r)) < fabs(a))
 #define TS_assert_relative(x, r)	TS_assert(fabs((x) - (r)) < TS_TOL * fabs(r))
 
-int ts_wait_IDLE()
+int ts_wait_IDLE(sim_t *S)
 {
 	int			xTIME = 0;
 
 	do {
-		sim_runtime(10 / (double) TS_TICK_RATE);
+		sim_runtime(S, 10 / (double) TS_TICK_RATE);
 
-		if (pm.fsm_state == PM_STATE_IDLE)
+		if (S->pm.fsm_state == PM_STATE_IDLE)
 			break;
 
 		if (xTIME > 10000) {
 
-			pm.fsm_errno = PM_ERROR_TIMEOUT;
+			S->pm.fsm_errno = PM_ERROR_TIMEOUT;
 			break;
 		}
 
@@ -38,26 +40,26 @@ int ts_wait_IDLE()
 	}
 	while (1);
 
-	return pm.fsm_errno;
+	return S->pm.fsm_errno;
 }
 
-int ts_wait_motion()
+int ts_wait_motion(sim_t *S)
 {
 	int			xTIME = 0;
 
 	do {
-		sim_runtime(50 / (double) TS_TICK_RATE);
+		sim_runtime(S, 50 / (double) TS_TICK_RATE);
 
-		if (pm.fsm_errno != PM_OK)
+		if (S->pm.fsm_errno != PM_OK)
 			break;
 
-		if (		m_fabsf(pm.zone_lpf_wS) > pm.zone_threshold
-				&& pm.detach_TIM > PM_TSMS(&pm, pm.tm_transient_slow))
+		if (		m_fabsf(S->pm.zone_lpf_wS) > S->pm.zone_threshold
+				&& S->pm.detach_TIM > PM_TSMS(&S->pm, S->pm.tm_transient_slow))
 			break;
 
 		if (xTIME > 10000) {
 
-			pm.fsm_errno = PM_ERROR_TIMEOUT;
+			S->pm.fsm_errno = PM_ERROR_TIMEOUT;
 			break;
 		}
 
@@ -65,29 +67,29 @@ int ts_wait_motion()
 	}
 	while (1);
 
-	return pm.fsm_errno;
+	return S->pm.fsm_errno;
 }
 
-int ts_wait_spinup()
+int ts_wait_spinup(sim_t *S)
 {
 	int			xTIME = 0;
 
 	do {
-		sim_runtime(50 / (double) TS_TICK_RATE);
+		sim_runtime(S, 50 / (double) TS_TICK_RATE);
 
-		if (pm.fsm_errno != PM_OK)
+		if (S->pm.fsm_errno != PM_OK)
 			break;
 
-		if (m_fabsf(pm.s_setpoint_speed - pm.lu_wS) < pm.probe_speed_tol)
+		if (m_fabsf(S->pm.s_setpoint_speed - S->pm.lu_wS) < S->pm.probe_speed_tol)
 			break;
 
-		if (		pm.lu_MODE == PM_LU_FORCED
-				&& pm.vsi_lpf_DC > pm.forced_stop_DC)
+		if (		S->pm.lu_MODE == PM_LU_FORCED
+				&& S->pm.vsi_lpf_DC > S->pm.forced_stop_DC)
 			break;
 
 		if (xTIME > 10000) {
 
-			pm.fsm_errno = PM_ERROR_TIMEOUT;
+			S->pm.fsm_errno = PM_ERROR_TIMEOUT;
 			break;
 		}
 
@@ -95,874 +97,1027 @@ int ts_wait_spinup()
 	}
 	while (1);
 
-	return pm.fsm_errno;
+	return S->pm.fsm_errno;
 }
 
-void ts_self_adjust()
+void ts_self_adjust(sim_t *S)
 {
 	double		usual_Mq;
 
 	do {
-		pm.fsm_req = PM_STATE_ZERO_DRIFT;
-		ts_wait_IDLE();
+		S->pm.fsm_req = PM_STATE_ZERO_DRIFT;
+		ts_wait_IDLE(S);
 
-		printf("const_fb_U = %.3f (V)\n", pm.const_fb_U);
+		fprintf(S->fd_log, "const_fb_U = %.3f (V)\n", S->pm.const_fb_U);
 
-		printf("self_STDi = %.3f %.3f %.3f (A)\n", pm.self_STDi[0],
-				pm.self_STDi[1], pm.self_STDi[2]);
+		fprintf(S->fd_log, "self_STDi = %.3f %.3f %.3f (A)\n", S->pm.self_STDi[0],
+				S->pm.self_STDi[1], S->pm.self_STDi[2]);
 
-		printf("scale_iABC0 = %.3f %.3f %.3f (A)\n", pm.scale_iA[0],
-				pm.scale_iB[0], pm.scale_iC[0]);
+		fprintf(S->fd_log, "scale_iABC0 = %.3f %.3f %.3f (A)\n", S->pm.scale_iA[0],
+				S->pm.scale_iB[0], S->pm.scale_iC[0]);
 
-		printf("probe_current_hold = %.3f (A)\n", pm.probe_current_hold);
+		fprintf(S->fd_log, "probe_current_hold = %.3f (A)\n", S->pm.probe_current_hold);
 
-		if (pm.fsm_errno != PM_OK)
+		if (S->pm.fsm_errno != PM_OK)
 			break;
 
-		if (PM_CONFIG_TVM(&pm) == PM_ENABLED) {
+		if (PM_CONFIG_TVM(&S->pm) == PM_ENABLED) {
 
-			pm.fsm_req = PM_STATE_ADJUST_ON_PCB_VOLTAGE;
-			ts_wait_IDLE();
+			S->pm.fsm_req = PM_STATE_ADJUST_ON_PCB_VOLTAGE;
+			ts_wait_IDLE(S);
 
-			printf("scale_uA = %.4e %.4f (V)\n", pm.scale_uA[1], pm.scale_uA[0]);
-			printf("scale_uB = %.4e %.4f (V)\n", pm.scale_uB[1], pm.scale_uB[0]);
-			printf("scale_uC = %.4e %.4f (V)\n", pm.scale_uC[1], pm.scale_uC[0]);
+			fprintf(S->fd_log, "scale_uA = %.4e %.4f (V)\n", S->pm.scale_uA[1], S->pm.scale_uA[0]);
+			fprintf(S->fd_log, "scale_uB = %.4e %.4f (V)\n", S->pm.scale_uB[1], S->pm.scale_uB[0]);
+			fprintf(S->fd_log, "scale_uC = %.4e %.4f (V)\n", S->pm.scale_uC[1], S->pm.scale_uC[0]);
 
-			printf("self_RMSu = %.4f (V)\n", pm.self_RMSu);
-			printf("self_RMSt = %.4f %.4f %.4f (V)\n", pm.self_RMSt[0],
-					pm.self_RMSt[1], pm.self_RMSt[2]);
+			fprintf(S->fd_log, "self_RMSu = %.4f (V)\n", S->pm.self_RMSu);
+			fprintf(S->fd_log, "self_RMSt = %.4f %.4f %.4f (V)\n", S->pm.self_RMSt[0],
+					S->pm.self_RMSt[1], S->pm.self_RMSt[2]);
 
-			if (pm.fsm_errno != PM_OK)
+			if (S->pm.fsm_errno != PM_OK)
 				break;
 		}
 
-		if (pm.config_DCU_VOLTAGE == PM_ENABLED) {
+		if (S->pm.config_DCU_VOLTAGE == PM_ENABLED) {
 
-			usual_Mq = m.Mq[3];
-			m.Mq[3] = 5.e-1;
+			usual_Mq = S->m.Mq[3];
+			S->m.Mq[3] = 5.e-1;
 
-			pm.fsm_req = PM_STATE_ADJUST_DCU_VOLTAGE;
-			ts_wait_IDLE();
+			S->pm.fsm_req = PM_STATE_ADJUST_DCU_VOLTAGE;
+			ts_wait_IDLE(S);
 
-			m.Mq[3] = usual_Mq;
+			S->m.Mq[3] = usual_Mq;
 
-			printf("const_im_Rz = %.4e (Ohm)\n", pm.const_im_Rz);
-			printf("dcu_deadband = %.1f (ns)\n", pm.dcu_deadband);
-			printf("self_DTu = %.4f (V)\n", pm.self_DTu);
+			fprintf(S->fd_log, "const_im_Rz = %.4e (Ohm)\n", S->pm.const_im_Rz);
+			fprintf(S->fd_log, "dcu_deadband = %.1f (ns)\n", S->pm.dcu_deadband);
+			fprintf(S->fd_log, "self_DTu = %.4f (V)\n", S->pm.self_DTu);
 		}
 	}
 	while (0);
 }
 
-void ts_probe_impedance()
+void ts_probe_impedance(sim_t *S)
 {
 	double		usual_Mq;
 
 	do {
-		usual_Mq = m.Mq[3];
-		m.Mq[3] = 5.e-1;
+		usual_Mq = S->m.Mq[3];
+		S->m.Mq[3] = 5.e-1;
 
-		pm.fsm_req = PM_STATE_PROBE_CONST_RESISTANCE;
+		S->pm.fsm_req = PM_STATE_PROBE_CONST_RESISTANCE;
 
-		printf("probe_current_hold = %.3f (A)\n", pm.probe_current_hold);
-		printf("probe_current_sine = %.3f (A)\n", pm.probe_current_sine);
-		printf("probe_current_bias = %.3f (A)\n", pm.probe_current_bias);
-		printf("probe_freq_sine = %.1f (Hz)\n", pm.probe_freq_sine);
-		printf("probe_loss_maximal = %.1f (W)\n", pm.probe_loss_maximal);
+		fprintf(S->fd_log, "probe_current_hold = %.3f (A)\n", S->pm.probe_current_hold);
+		fprintf(S->fd_log, "probe_current_sine = %.3f (A)\n", S->pm.probe_current_sine);
+		fprintf(S->fd_log, "probe_current_bias = %.3f (A)\n", S->pm.probe_current_bias);
+		fprintf(S->fd_log, "probe_freq_sine = %.1f (Hz)\n", S->pm.probe_freq_sine);
+		fprintf(S->fd_log, "probe_loss_maximal = %.1f (W)\n", S->pm.probe_loss_maximal);
 
-		if (ts_wait_IDLE() != PM_OK)
+		if (ts_wait_IDLE(S) != PM_OK)
 			break;
 
-		m.Mq[3] = usual_Mq;
+		S->m.Mq[3] = usual_Mq;
 
-		pm.const_Rs = pm.const_im_Rz;
+		S->pm.const_Rs = S->pm.const_im_Rz;
 
-		printf("const_Rs = %.4e (Ohm)\n", pm.const_Rs);
-		printf("self_DTu = %.4f (V)\n", pm.self_DTu);
+		fprintf(S->fd_log, "const_Rs = %.4e (Ohm)\n", S->pm.const_Rs);
+		fprintf(S->fd_log, "self_DTu = %.4f (V)\n", S->pm.self_DTu);
 
-		TS_assert_relative(pm.const_Rs, m.Rs);
+		TS_assert_relative(S->pm.const_Rs, S->m.Rs);
 
-		pm.fsm_req = PM_STATE_PROBE_CONST_INDUCTANCE;
+		S->pm.fsm_req = PM_STATE_PROBE_CONST_INDUCTANCE;
 
-		if (ts_wait_IDLE() != PM_OK)
+		if (ts_wait_IDLE(S) != PM_OK)
 			break;
 
-		printf("const_im_Ld = %.4e (H)\n", pm.const_im_Ld);
-		printf("const_im_Lq = %.4e (H)\n", pm.const_im_Lq);
-		printf("const_im_Ag = %.2f (deg)\n", pm.const_im_Ag);
-		printf("const_im_Rz = %.4e (Ohm)\n", pm.const_im_Rz);
+		fprintf(S->fd_log, "const_im_Ld = %.4e (H)\n", S->pm.const_im_Ld);
+		fprintf(S->fd_log, "const_im_Lq = %.4e (H)\n", S->pm.const_im_Lq);
+		fprintf(S->fd_log, "const_im_Ag = %.2f (deg)\n", S->pm.const_im_Ag);
+		fprintf(S->fd_log, "const_im_Rz = %.4e (Ohm)\n", S->pm.const_im_Rz);
 
-		TS_assert_relative(pm.const_im_Ld, m.Ld);
-		TS_assert_relative(pm.const_im_Lq, m.Lq);
+		TS_assert_relative(S->pm.const_im_Ld, S->m.Ld);
+		TS_assert_relative(S->pm.const_im_Lq, S->m.Lq);
 
-		pm_auto(&pm, PM_AUTO_MAXIMAL_CURRENT);
-		pm_auto(&pm, PM_AUTO_LOOP_CURRENT);
+		pm_auto(&S->pm, PM_AUTO_MAXIMAL_CURRENT);
+		pm_auto(&S->pm, PM_AUTO_LOOP_CURRENT);
 
-		printf("i_maixmal = %.3f (A) \n", pm.i_maximal);
-		printf("i_gain_P = %.2e \n", pm.i_gain_P);
-		printf("i_gain_I = %.2e \n", pm.i_gain_I);
-		printf("i_slew_rate = %.1f (A/s)\n", pm.i_slew_rate);
+		fprintf(S->fd_log, "i_maixmal = %.3f (A) \n", S->pm.i_maximal);
+		fprintf(S->fd_log, "i_gain_P = %.2e \n", S->pm.i_gain_P);
+		fprintf(S->fd_log, "i_gain_I = %.2e \n", S->pm.i_gain_I);
+		fprintf(S->fd_log, "i_slew_rate = %.1f (A/s)\n", S->pm.i_slew_rate);
 	}
 	while (0);
 }
 
-void ts_probe_spinup()
+void ts_probe_spinup(sim_t *S)
 {
 	int		backup_LU_DRIVE;
 	float		Kv;
 
-	backup_LU_DRIVE = pm.config_LU_DRIVE;
-	pm.config_LU_DRIVE = PM_DRIVE_SPEED;
+	backup_LU_DRIVE = S->pm.config_LU_DRIVE;
+	S->pm.config_LU_DRIVE = PM_DRIVE_SPEED;
 
 	do {
-		pm.fsm_req = PM_STATE_LU_STARTUP;
+		S->pm.fsm_req = PM_STATE_LU_STARTUP;
 
-		if (ts_wait_IDLE() != PM_OK)
+		if (ts_wait_IDLE(S) != PM_OK)
 			break;
 
-		if (		pm.flux_LINKAGE != PM_ENABLED
-				&& pm.config_EXCITATION == PM_MAGNET_PERMANENT) {
+		if (		S->pm.flux_LINKAGE != PM_ENABLED
+				&& S->pm.config_EXCITATION == PM_MAGNET_PERMANENT) {
 
-			pm.s_setpoint_speed = pm.probe_speed_hold;
+			S->pm.s_setpoint_speed = S->pm.probe_speed_hold;
 
-			printf("probe_speed_hold = %.2f (rad/s)\n", pm.probe_speed_hold);
+			fprintf(S->fd_log, "probe_speed_hold = %.2f (rad/s)\n", S->pm.probe_speed_hold);
 
-			if (ts_wait_spinup() != PM_OK)
+			if (ts_wait_spinup(S) != PM_OK)
 				break;
 
-			sim_runtime(200 / (double) TS_TICK_RATE);
+			sim_runtime(S, 200 / (double) TS_TICK_RATE);
 
-			pm.fsm_req = PM_STATE_PROBE_CONST_FLUX_LINKAGE;
+			S->pm.fsm_req = PM_STATE_PROBE_CONST_FLUX_LINKAGE;
 
-			if (ts_wait_IDLE() != PM_OK)
+			if (ts_wait_IDLE(S) != PM_OK)
 				break;
 
-			Kv = 60. / (2. * M_PI * sqrt(3.)) / (pm.const_lambda * pm.const_Zp);
+			Kv = 60. / (2. * M_PI * sqrt(3.)) / (S->pm.const_lambda * S->pm.const_Zp);
 
-			printf("lu_wS = %.2f (rad/s)\n", pm.lu_wS);
-			printf("const_lambda = %.4e (Wb) %.2f (rpm/v)\n", pm.const_lambda, Kv);
+			fprintf(S->fd_log, "lu_wS = %.2f (rad/s)\n", S->pm.lu_wS);
+			fprintf(S->fd_log, "const_lambda = %.4e (Wb) %.2f (rpm/v)\n", S->pm.const_lambda, Kv);
 		}
 
-		pm_auto(&pm, PM_AUTO_ZONE_THRESHOLD);
-		pm_auto(&pm, PM_AUTO_PROBE_SPEED_HOLD);
-		pm_auto(&pm, PM_AUTO_FORCED_MAXIMAL);
+		pm_auto(&S->pm, PM_AUTO_ZONE_THRESHOLD);
+		pm_auto(&S->pm, PM_AUTO_PROBE_SPEED_HOLD);
+		pm_auto(&S->pm, PM_AUTO_FORCED_MAXIMAL);
 
-		printf("probe_speed_hold = %.2f (rad/s)\n", pm.probe_speed_hold);
-		printf("forced_maximal = %.2f (rad/s)\n", pm.forced_maximal);
+		fprintf(S->fd_log, "probe_speed_hold = %.2f (rad/s)\n", S->pm.probe_speed_hold);
+		fprintf(S->fd_log, "forced_maximal = %.2f (rad/s)\n", S->pm.forced_maximal);
 
-		printf("zone_threshold = %.2f (rad/s) %.3f (V)\n",
-				pm.zone_threshold,
-				pm.zone_threshold * pm.const_lambda / pm.k_EMAX);
+		fprintf(S->fd_log, "zone_threshold = %.2f (rad/s) %.3f (V)\n",
+				S->pm.zone_threshold,
+				S->pm.zone_threshold * S->pm.const_lambda / S->pm.k_EMAX);
 
-		printf("zone_tol = %.2f (rad/s) %.3f (V)\n",
-				pm.zone_tol,
-				pm.zone_tol * pm.const_lambda / pm.k_EMAX);
+		fprintf(S->fd_log, "zone_tol = %.2f (rad/s) %.3f (V)\n",
+				S->pm.zone_tol,
+				S->pm.zone_tol * S->pm.const_lambda / S->pm.k_EMAX);
 
-		pm.s_setpoint_speed = pm.probe_speed_hold;
+		S->pm.s_setpoint_speed = S->pm.probe_speed_hold;
 
-		if (ts_wait_spinup() != PM_OK)
+		if (ts_wait_spinup(S) != PM_OK)
 			break;
 
-		if (pm.flux_ZONE != PM_ZONE_HIGH) {
+		if (S->pm.flux_ZONE != PM_ZONE_HIGH) {
 
-			pm.fsm_errno = PM_ERROR_NO_FLUX_CAUGHT;
+			S->pm.fsm_errno = PM_ERROR_NO_FLUX_CAUGHT;
 			break;
 		}
 
-		if (pm.config_EXCITATION == PM_MAGNET_PERMANENT) {
+		if (S->pm.config_EXCITATION == PM_MAGNET_PERMANENT) {
 
-			sim_runtime(200 / (double) TS_TICK_RATE);
+			sim_runtime(S, 200 / (double) TS_TICK_RATE);
 
-			pm.fsm_req = PM_STATE_PROBE_CONST_FLUX_LINKAGE;
+			S->pm.fsm_req = PM_STATE_PROBE_CONST_FLUX_LINKAGE;
 
-			if (ts_wait_IDLE() != PM_OK)
+			if (ts_wait_IDLE(S) != PM_OK)
 				break;
 
-			Kv = 60. / (2. * M_PI * sqrt(3.)) / (pm.const_lambda * pm.const_Zp);
+			Kv = 60. / (2. * M_PI * sqrt(3.)) / (S->pm.const_lambda * S->pm.const_Zp);
 
-			printf("lu_wS = %.2f (rad/s)\n", pm.lu_wS);
-			printf("const_lambda = %.4e (Wb) %.2f (rpm/v)\n", pm.const_lambda, Kv);
+			fprintf(S->fd_log, "lu_wS = %.2f (rad/s)\n", S->pm.lu_wS);
+			fprintf(S->fd_log, "const_lambda = %.4e (Wb) %.2f (rpm/v)\n", S->pm.const_lambda, Kv);
 
-			TS_assert_relative(pm.const_lambda, m.lambda);
+			TS_assert_relative(S->pm.const_lambda, S->m.lambda);
 		}
 
-		sim_runtime(200 / (double) TS_TICK_RATE);
+		sim_runtime(S, 200 / (double) TS_TICK_RATE);
 
-		pm.fsm_req = PM_STATE_PROBE_THRESHOLD_TOL;
+		S->pm.fsm_req = PM_STATE_PROBE_THRESHOLD_TOL;
 
-		if (ts_wait_IDLE() != PM_OK)
+		if (ts_wait_IDLE(S) != PM_OK)
 			break;
 
-		pm_auto(&pm, PM_AUTO_ZONE_THRESHOLD);
-		pm_auto(&pm, PM_AUTO_PROBE_SPEED_HOLD);
-		pm_auto(&pm, PM_AUTO_FORCED_MAXIMAL);
+		pm_auto(&S->pm, PM_AUTO_ZONE_THRESHOLD);
+		pm_auto(&S->pm, PM_AUTO_PROBE_SPEED_HOLD);
+		pm_auto(&S->pm, PM_AUTO_FORCED_MAXIMAL);
 
-		printf("probe_speed_hold = %.2f (rad/s)\n", pm.probe_speed_hold);
-		printf("forced_maximal = %.2f (rad/s)\n", pm.forced_maximal);
+		fprintf(S->fd_log, "probe_speed_hold = %.2f (rad/s)\n", S->pm.probe_speed_hold);
+		fprintf(S->fd_log, "forced_maximal = %.2f (rad/s)\n", S->pm.forced_maximal);
 
-		printf("zone_threshold = %.2f (rad/s) %.3f (V)\n",
-				pm.zone_threshold,
-				pm.zone_threshold * pm.const_lambda / pm.k_EMAX);
+		fprintf(S->fd_log, "zone_threshold = %.2f (rad/s) %.3f (V)\n",
+				S->pm.zone_threshold,
+				S->pm.zone_threshold * S->pm.const_lambda / S->pm.k_EMAX);
 
-		printf("zone_tol = %.2f (rad/s) %.3f (V)\n",
-				pm.zone_tol,
-				pm.zone_tol * pm.const_lambda / pm.k_EMAX);
+		fprintf(S->fd_log, "zone_tol = %.2f (rad/s) %.3f (V)\n",
+				S->pm.zone_tol,
+				S->pm.zone_tol * S->pm.const_lambda / S->pm.k_EMAX);
 
-		pm.fsm_req = PM_STATE_PROBE_CONST_INERTIA;
+		S->pm.fsm_req = PM_STATE_PROBE_CONST_INERTIA;
 
-		printf("lu_wS = %.2f (rad/s)\n", pm.lu_wS);
+		fprintf(S->fd_log, "lu_wS = %.2f (rad/s)\n", S->pm.lu_wS);
 
-		sim_runtime(100 / (double) TS_TICK_RATE);
+		sim_runtime(S, 100 / (double) TS_TICK_RATE);
 
-		pm.s_setpoint_speed = 110.f * pm.k_EMAX / 100.f
-				* pm.const_fb_U / pm.const_lambda;
+		S->pm.s_setpoint_speed = 110.f * S->pm.k_EMAX / 100.f
+				* S->pm.const_fb_U / S->pm.const_lambda;
 
-		sim_runtime(400 / (double) TS_TICK_RATE);
+		sim_runtime(S, 400 / (double) TS_TICK_RATE);
 
-		printf("lu_wS = %.2f (rad/s)\n", pm.lu_wS);
+		fprintf(S->fd_log, "lu_wS = %.2f (rad/s)\n", S->pm.lu_wS);
 
-		pm.s_setpoint_speed = pm.probe_speed_hold;
+		S->pm.s_setpoint_speed = S->pm.probe_speed_hold;
 
-		sim_runtime(400 / (double) TS_TICK_RATE);
+		sim_runtime(S, 400 / (double) TS_TICK_RATE);
 
-		if (ts_wait_IDLE() != PM_OK)
+		if (ts_wait_IDLE(S) != PM_OK)
 			break;
 
-		printf("lu_wS = %.2f (rad/s)\n", pm.lu_wS);
-		printf("const_Ja = %.4e (kgm2) \n", pm.const_Ja * pm.const_Zp * pm.const_Zp);
+		fprintf(S->fd_log, "lu_wS = %.2f (rad/s)\n", S->pm.lu_wS);
+		fprintf(S->fd_log, "const_Ja = %.4e (kgm2) \n", S->pm.const_Ja * S->pm.const_Zp * S->pm.const_Zp);
 
-		TS_assert_relative(pm.const_Ja * pm.const_Zp * pm.const_Zp, m.Jm);
+		TS_assert_relative(S->pm.const_Ja * S->pm.const_Zp * S->pm.const_Zp, S->m.Jm);
 
-		pm.fsm_req = PM_STATE_LU_SHUTDOWN;
+		S->pm.fsm_req = PM_STATE_LU_SHUTDOWN;
 
-		if (ts_wait_IDLE() != PM_OK)
+		if (ts_wait_IDLE(S) != PM_OK)
 			break;
 
-		pm_auto(&pm, PM_AUTO_FORCED_ACCEL);
-		pm_auto(&pm, PM_AUTO_LOOP_SPEED);
+		pm_auto(&S->pm, PM_AUTO_FORCED_ACCEL);
+		pm_auto(&S->pm, PM_AUTO_LOOP_SPEED);
 
-		printf("forced_accel = %.1f (rad/s2)\n", pm.forced_accel);
-		printf("lu_gain_mq_LP = %.2e\n", pm.lu_gain_mq_LP);
-		printf("s_gain_P = %.2e\n", pm.s_gain_P);
-		printf("s_gain_D = %.2e\n", pm.s_gain_D);
+		fprintf(S->fd_log, "forced_accel = %.1f (rad/s2)\n", S->pm.forced_accel);
+		fprintf(S->fd_log, "lu_gain_mq_LP = %.2e\n", S->pm.lu_gain_mq_LP);
+		fprintf(S->fd_log, "s_gain_P = %.2e\n", S->pm.s_gain_P);
+		fprintf(S->fd_log, "s_gain_D = %.2e\n", S->pm.s_gain_D);
 	}
 	while (0);
 
-	pm.config_LU_DRIVE = backup_LU_DRIVE;
+	S->pm.config_LU_DRIVE = backup_LU_DRIVE;
 }
 
-void ts_adjust_sensor_hall()
+void ts_adjust_sensor_hall(sim_t *S)
 {
 	int		backup_LU_SENSOR, backup_LU_DRIVE, N;
 
-	backup_LU_SENSOR = pm.config_LU_SENSOR;
-	backup_LU_DRIVE = pm.config_LU_DRIVE;
+	backup_LU_SENSOR = S->pm.config_LU_SENSOR;
+	backup_LU_DRIVE = S->pm.config_LU_DRIVE;
 
-	pm.config_LU_SENSOR = PM_SENSOR_NONE;
-	pm.config_LU_DRIVE = PM_DRIVE_SPEED;
+	S->pm.config_LU_SENSOR = PM_SENSOR_NONE;
+	S->pm.config_LU_DRIVE = PM_DRIVE_SPEED;
 
 	do {
-		pm.fsm_req = PM_STATE_LU_STARTUP;
+		S->pm.fsm_req = PM_STATE_LU_STARTUP;
 
-		printf("probe_speed_hold = %.2f (rad/s)\n", pm.probe_speed_hold);
+		fprintf(S->fd_log, "probe_speed_hold = %.2f (rad/s)\n", S->pm.probe_speed_hold);
 
-		if (ts_wait_IDLE() != PM_OK)
+		if (ts_wait_IDLE(S) != PM_OK)
 			break;
 
-		pm.s_setpoint_speed = pm.probe_speed_hold;
+		S->pm.s_setpoint_speed = S->pm.probe_speed_hold;
 
-		if (ts_wait_spinup() != PM_OK)
+		if (ts_wait_spinup(S) != PM_OK)
 			break;
 
-		pm.fsm_req = PM_STATE_ADJUST_SENSOR_HALL;
+		S->pm.fsm_req = PM_STATE_ADJUST_SENSOR_HALL;
 
-		if (ts_wait_IDLE() != PM_OK)
+		if (ts_wait_IDLE(S) != PM_OK)
 			break;
 
-		printf("lu_wS = %.2f (rad/s)\n", pm.lu_wS);
+		fprintf(S->fd_log, "lu_wS = %.2f (rad/s)\n", S->pm.lu_wS);
 
 		for (N = 1; N < 7; ++N) {
 
 			double		STg;
 
-			STg = atan2(pm.hall_ST[N].Y, pm.hall_ST[N].X) * (180. / M_PI);
+			STg = atan2(S->pm.hall_ST[N].Y, S->pm.hall_ST[N].X) * (180. / M_PI);
 
-			printf("hall_ST[%i] = %.1f (deg)\n", N, STg);
+			fprintf(S->fd_log, "hall_ST[%i] = %.1f (deg)\n", N, STg);
 		}
 
-		pm.fsm_req = PM_STATE_LU_SHUTDOWN;
+		S->pm.fsm_req = PM_STATE_LU_SHUTDOWN;
 
-		if (ts_wait_IDLE() != PM_OK)
+		if (ts_wait_IDLE(S) != PM_OK)
 			break;
 	}
 	while (0);
 
-	pm.config_LU_SENSOR = backup_LU_SENSOR;
-	pm.config_LU_DRIVE = backup_LU_DRIVE;
+	S->pm.config_LU_SENSOR = backup_LU_SENSOR;
+	S->pm.config_LU_DRIVE = backup_LU_DRIVE;
 }
 
-void ts_adjust_sensor_eabi()
+void ts_adjust_sensor_eabi(sim_t *S)
 {
 	int		backup_LU_SENSOR, backup_LU_DRIVE;
 
 	double		F0g;
 
-	backup_LU_SENSOR = pm.config_LU_SENSOR;
-	backup_LU_DRIVE = pm.config_LU_DRIVE;
+	backup_LU_SENSOR = S->pm.config_LU_SENSOR;
+	backup_LU_DRIVE = S->pm.config_LU_DRIVE;
 
-	pm.config_LU_SENSOR = PM_SENSOR_NONE;
-	pm.config_LU_DRIVE = PM_DRIVE_SPEED;
+	S->pm.config_LU_SENSOR = PM_SENSOR_NONE;
+	S->pm.config_LU_DRIVE = PM_DRIVE_SPEED;
 
 	do {
-		pm.fsm_req = PM_STATE_LU_STARTUP;
+		S->pm.fsm_req = PM_STATE_LU_STARTUP;
 
-		printf("zone_threshold = %.2f (rad/s)\n", pm.zone_threshold);
+		fprintf(S->fd_log, "zone_threshold = %.2f (rad/s)\n", S->pm.zone_threshold);
 
-		if (ts_wait_IDLE() != PM_OK)
+		if (ts_wait_IDLE(S) != PM_OK)
 			break;
 
-		pm.s_setpoint_speed = pm.zone_threshold;
+		S->pm.s_setpoint_speed = S->pm.zone_threshold;
 
-		if (ts_wait_spinup() != PM_OK)
+		if (ts_wait_spinup(S) != PM_OK)
 			break;
 
-		pm.fsm_req = PM_STATE_ADJUST_SENSOR_EABI;
+		S->pm.fsm_req = PM_STATE_ADJUST_SENSOR_EABI;
 
-		if (ts_wait_IDLE() != PM_OK)
+		if (ts_wait_IDLE(S) != PM_OK)
 			break;
 
-		F0g = atan2(pm.eabi_F0[1], pm.eabi_F0[0]) * (180. / M_PI);
+		F0g = atan2(S->pm.eabi_F0[1], S->pm.eabi_F0[0]) * (180. / M_PI);
 
-		printf("eabi_const_EP = %i\n", pm.eabi_const_EP);
-		printf("eabi_const_Zs = %i\n", pm.eabi_const_Zs);
-		printf("eabi_F0 = %.1f (deg)\n", F0g);
+		fprintf(S->fd_log, "eabi_const_EP = %i\n", S->pm.eabi_const_EP);
+		fprintf(S->fd_log, "eabi_const_Zs = %i\n", S->pm.eabi_const_Zs);
+		fprintf(S->fd_log, "eabi_F0 = %.1f (deg)\n", F0g);
 
-		pm.fsm_req = PM_STATE_LU_SHUTDOWN;
+		S->pm.fsm_req = PM_STATE_LU_SHUTDOWN;
 
-		if (ts_wait_IDLE() != PM_OK)
+		if (ts_wait_IDLE(S) != PM_OK)
 			break;
 	}
 	while (0);
 
-	pm.config_LU_SENSOR = backup_LU_SENSOR;
-	pm.config_LU_DRIVE = backup_LU_DRIVE;
+	S->pm.config_LU_SENSOR = backup_LU_SENSOR;
+	S->pm.config_LU_DRIVE = backup_LU_DRIVE;
 }
 
-void ts_adjust_sensor_sincos()
+void ts_adjust_sensor_sincos(sim_t *S)
 {
 	int		backup_LU_SENSOR, backup_LU_DRIVE;
 
 	int		N;
 
-	backup_LU_SENSOR = pm.config_LU_SENSOR;
-	backup_LU_DRIVE = pm.config_LU_DRIVE;
+	backup_LU_SENSOR = S->pm.config_LU_SENSOR;
+	backup_LU_DRIVE = S->pm.config_LU_DRIVE;
 
-	pm.config_LU_SENSOR = PM_SENSOR_NONE;
-	pm.config_LU_DRIVE = PM_DRIVE_SPEED;
+	S->pm.config_LU_SENSOR = PM_SENSOR_NONE;
+	S->pm.config_LU_DRIVE = PM_DRIVE_SPEED;
 
 	do {
-		pm.fsm_req = PM_STATE_LU_STARTUP;
+		S->pm.fsm_req = PM_STATE_LU_STARTUP;
 
-		printf("probe_speed_hold = %.2f (rad/s)\n", pm.probe_speed_hold);
+		fprintf(S->fd_log, "probe_speed_hold = %.2f (rad/s)\n", S->pm.probe_speed_hold);
 
-		if (ts_wait_IDLE() != PM_OK)
+		if (ts_wait_IDLE(S) != PM_OK)
 			break;
 
-		pm.s_setpoint_speed = pm.probe_speed_hold;
+		S->pm.s_setpoint_speed = S->pm.probe_speed_hold;
 
-		if (ts_wait_spinup() != PM_OK)
+		if (ts_wait_spinup(S) != PM_OK)
 			break;
 
-		pm.fsm_req = PM_STATE_ADJUST_SENSOR_SINCOS;
+		S->pm.fsm_req = PM_STATE_ADJUST_SENSOR_SINCOS;
 
-		printf("lu_wS = %.2f (rad/s)\n", pm.lu_wS);
+		fprintf(S->fd_log, "lu_wS = %.2f (rad/s)\n", S->pm.lu_wS);
 
-		sim_runtime(400 / (double) TS_TICK_RATE);
+		sim_runtime(S, 400 / (double) TS_TICK_RATE);
 
-		pm.s_setpoint_speed = 110.f * pm.k_EMAX / 100.f
-				* pm.const_fb_U / pm.const_lambda;
+		S->pm.s_setpoint_speed = 110.f * S->pm.k_EMAX / 100.f
+				* S->pm.const_fb_U / S->pm.const_lambda;
 
-		sim_runtime(400 / (double) TS_TICK_RATE);
+		sim_runtime(S, 400 / (double) TS_TICK_RATE);
 
-		printf("lu_wS = %.2f (rad/s)\n", pm.lu_wS);
+		fprintf(S->fd_log, "lu_wS = %.2f (rad/s)\n", S->pm.lu_wS);
 
-		pm.s_setpoint_speed = pm.probe_speed_hold;
+		S->pm.s_setpoint_speed = S->pm.probe_speed_hold;
 
-		sim_runtime(400 / (double) TS_TICK_RATE);
+		sim_runtime(S, 400 / (double) TS_TICK_RATE);
 
-		printf("lu_wS = %.2f (rad/s)\n", pm.lu_wS);
+		fprintf(S->fd_log, "lu_wS = %.2f (rad/s)\n", S->pm.lu_wS);
 
-		pm.s_setpoint_speed = 110.f * pm.k_EMAX / 100.f
-				* pm.const_fb_U / pm.const_lambda;
+		S->pm.s_setpoint_speed = 110.f * S->pm.k_EMAX / 100.f
+				* S->pm.const_fb_U / S->pm.const_lambda;
 
-		sim_runtime(400 / (double) TS_TICK_RATE);
+		sim_runtime(S, 400 / (double) TS_TICK_RATE);
 
-		printf("lu_wS = %.2f (rad/s)\n", pm.lu_wS);
+		fprintf(S->fd_log, "lu_wS = %.2f (rad/s)\n", S->pm.lu_wS);
 
-		pm.s_setpoint_speed = pm.probe_speed_hold;
+		S->pm.s_setpoint_speed = S->pm.probe_speed_hold;
 
-		sim_runtime(400 / (double) TS_TICK_RATE);
+		sim_runtime(S, 400 / (double) TS_TICK_RATE);
 
-		if (ts_wait_IDLE() != PM_OK)
+		if (ts_wait_IDLE(S) != PM_OK)
 			break;
 
-		printf("lu_wS = %.2f (rad/s)\n", pm.lu_wS);
+		fprintf(S->fd_log, "lu_wS = %.2f (rad/s)\n", S->pm.lu_wS);
 
 		for (N = 0; N < 16; ++N) {
 
-			printf("sincos_CONST[%i] = %.6f\n", N, pm.sincos_CONST[N]);
+			fprintf(S->fd_log, "sincos_CONST[%i] = %.6f\n", N, S->pm.sincos_CONST[N]);
 		}
 
-		pm.fsm_req = PM_STATE_LU_SHUTDOWN;
+		S->pm.fsm_req = PM_STATE_LU_SHUTDOWN;
 
-		if (ts_wait_IDLE() != PM_OK)
+		if (ts_wait_IDLE(S) != PM_OK)
 			break;
 	}
 	while (0);
 
-	pm.config_LU_SENSOR = backup_LU_SENSOR;
-	pm.config_LU_DRIVE = backup_LU_DRIVE;
+	S->pm.config_LU_SENSOR = backup_LU_SENSOR;
+	S->pm.config_LU_DRIVE = backup_LU_DRIVE;
 }
 
 static void
 blm_proc_DC(int A, int B, int C)
 {
-	m.pwm_A = A;
-	m.pwm_B = B;
-	m.pwm_C = C;
+	sim_t		*S = sim_local;
+
+	S->m.pwm_A = A;
+	S->m.pwm_B = B;
+	S->m.pwm_C = C;
 }
 
 static void
 blm_proc_Z(int Z)
 {
-	m.pwm_Z = (Z != PM_Z_ABC) ? BLM_Z_NONE : BLM_Z_DETACHED;
+	sim_t		*S = sim_local;
+
+	S->m.pwm_Z = (Z != PM_Z_ABC) ? BLM_Z_NONE : BLM_Z_DETACHED;
+}
+
+static void
+blm_proc_defer()
+{
+	/* Deferred job is done by sim_runtime() between PWM cycles as the
+	 * worker task does.
+	 * */
 }
 
-void ts_script_default()
+void ts_script_default(sim_t *S)
 {
-	pm.m_freq = (float) (1. / m.pwm_dT);
-	pm.m_dT = 1.f / pm.m_freq;
-	pm.dc_resolution = m.pwm_resolution;
-	pm.proc_set_DC = &blm_proc_DC;
-	pm.proc_set_Z = &blm_proc_Z;
-
-	pm_auto(&pm, PM_AUTO_BASIC_DEFAULT);
-	pm_auto(&pm, PM_AUTO_CONFIG_DEFAULT);
+	S->pm.m_freq = (float) (1. / S->m.pwm_dT);
+	S->pm.m_dT = 1.f / S->pm.m_freq;
+	S->pm.dc_resolution = S->m.pwm_resolution;
+	S->pm.proc_set_DC = &blm_proc_DC;
+	S->pm.proc_set_Z = &blm_proc_Z;
+	S->pm.proc_defer = &blm_proc_defer;
+
+	pm_auto(&S->pm, PM_AUTO_BASIC_DEFAULT);
+	pm_auto(&S->pm, PM_AUTO_CONFIG_DEFAULT);
 }
 
-void ts_script_base()
+void ts_script_base(sim_t *S)
 {
-	pm.const_Zp = m.Zp;
+	S->pm.const_Zp = S->m.Zp;
 
-	ts_self_adjust();
-	ts_probe_impedance();
-	ts_probe_spinup();
+	ts_self_adjust(S);
+	ts_probe_impedance(S);
+	ts_probe_spinup(S);
 }
 
 static void
-ts_script_speed()
+ts_script_speed(sim_t *S)
 {
-	pm.config_LU_DRIVE = PM_DRIVE_SPEED;
+	S->pm.config_LU_DRIVE = PM_DRIVE_SPEED;
 
-	pm.s_accel_forward = 300000.f;
-	pm.s_accel_reverse = pm.s_accel_forward;
+	S->pm.s_accel_forward = 300000.f;
+	S->pm.s_accel_reverse = S->pm.s_accel_forward;
 
-	pm.fsm_req = PM_STATE_LU_STARTUP;
-	ts_wait_IDLE();
+	S->pm.fsm_req = PM_STATE_LU_STARTUP;
+	ts_wait_IDLE(S);
 
-	m.unsync_flag = 1;
+	S->m.unsync_flag = 1;
 
-	pm.s_setpoint_speed = 50.f * pm.k_EMAX / 100.f
-			* pm.const_fb_U / pm.const_lambda;
+	S->pm.s_setpoint_speed = 50.f * S->pm.k_EMAX / 100.f
+			* S->pm.const_fb_U / S->pm.const_lambda;
 
-	ts_wait_spinup();
-	sim_runtime(0.5);
+	ts_wait_spinup(S);
+	sim_runtime(S, 0.5);
 
-	TS_assert(pm.lu_MODE == PM_LU_ESTIMATE);
+	TS_assert(S->pm.lu_MODE == PM_LU_ESTIMATE);
 
-	m.Mq[0] = - 1.5 * m.Zp * m.lambda * 20.f;
-	sim_runtime(0.5);
+	S->m.Mq[0] = - 1.5 * S->m.Zp * S->m.lambda * 20.f;
+	sim_runtime(S, 0.5);
 
-	m.Mq[0] = 0.f;
-	sim_runtime(0.5);
+	S->m.Mq[0] = 0.f;
+	sim_runtime(S, 0.5);
 
-	TS_assert_absolute(pm.lu_wS, pm.s_setpoint_speed, 50.);
+	TS_assert_absolute(S->pm.lu_wS, S->pm.s_setpoint_speed, 50.);
 
-	pm.s_setpoint_speed = 10.f * pm.k_EMAX / 100.f
-		* pm.const_fb_U / pm.const_lambda;
+	S->pm.s_setpoint_speed = 10.f * S->pm.k_EMAX / 100.f
+		* S->pm.const_fb_U / S->pm.const_lambda;
 
-	ts_wait_spinup();
-	sim_runtime(0.5);
+	ts_wait_spinup(S);
+	sim_runtime(S, 0.5);
 
-	TS_assert_absolute(pm.lu_wS, pm.s_setpoint_speed, 50.);
+	TS_assert_absolute(S->pm.lu_wS, S->pm.s_setpoint_speed, 50.);
 
-	m.unsync_flag = 0;
+	S->m.unsync_flag = 0;
 
-	pm.fsm_req = PM_STATE_LU_SHUTDOWN;
-	ts_wait_IDLE();
+	S->pm.fsm_req = PM_STATE_LU_SHUTDOWN;
+	ts_wait_IDLE(S);
 }
 
 static void
-ts_script_hfi()
+ts_script_hfi(sim_t *S)
 {
-	pm.config_LU_ESTIMATE = PM_FLUX_KALMAN;
-	pm.config_LU_DRIVE = PM_DRIVE_SPEED;
-	pm.config_HFI_WAVETYPE = PM_HFI_SILENT;
+	S->pm.config_LU_ESTIMATE = PM_FLUX_KALMAN;
+	S->pm.config_LU_DRIVE = PM_DRIVE_SPEED;
+	S->pm.config_HFI_WAVETYPE = PM_HFI_SILENT;
 
-	pm.fsm_req = PM_STATE_LU_STARTUP;
-	ts_wait_IDLE();
+	S->pm.fsm_req = PM_STATE_LU_STARTUP;
+	ts_wait_IDLE(S);
 
-	m.unsync_flag = 1;
+	S->m.unsync_flag = 1;
 
-	pm.s_setpoint_speed = 1.f / m.lambda;
-	sim_runtime(1.);
+	S->pm.s_setpoint_speed = 1.f / S->m.lambda;
+	sim_runtime(S, 1.);
 
-	TS_assert_absolute(pm.lu_wS, pm.s_setpoint_speed, 50.);
+	TS_assert_absolute(S->pm.lu_wS, S->pm.s_setpoint_speed, 50.);
 
-	pm.s_setpoint_speed = 0;
-	sim_runtime(0.5);
+	S->pm.s_setpoint_speed = 0;
+	sim_runtime(S, 0.5);
 
-	TS_assert(pm.lu_MODE == PM_LU_ON_HFI);
+	TS_assert(S->pm.lu_MODE == PM_LU_ON_HFI);
 
-	pm.s_setpoint_speed = - 1.f / m.lambda;
-	sim_runtime(0.5);
+	S->pm.s_setpoint_speed = - 1.f / S->m.lambda;
+	sim_runtime(S, 0.5);
 
-	TS_assert_absolute(pm.lu_wS, pm.s_setpoint_speed, 50.);
+	TS_assert_absolute(S->pm.lu_wS, S->pm.s_setpoint_speed, 50.);
 
-	pm.s_setpoint_speed = 0;
-	sim_runtime(0.5);
+	S->pm.s_setpoint_speed = 0;
+	sim_runtime(S, 0.5);
 
-	m.unsync_flag = 0;
+	S->m.unsync_flag = 0;
 
-	pm.fsm_req = PM_STATE_LU_SHUTDOWN;
-	ts_wait_IDLE();
+	S->pm.fsm_req = PM_STATE_LU_SHUTDOWN;
+	ts_wait_IDLE(S);
 
-	pm.config_HFI_WAVETYPE = PM_HFI_NONE;
+	S->pm.config_HFI_WAVETYPE = PM_HFI_NONE;
 }
 
 static void
-ts_script_weakening()
+ts_script_weakening(sim_t *S)
 {
-	pm.config_WEAKENING = PM_ENABLED;
-	pm.config_LU_DRIVE = PM_DRIVE_SPEED;
+	S->pm.config_WEAKENING = PM_ENABLED;
+	S->pm.config_LU_DRIVE = PM_DRIVE_SPEED;
 
-	pm.fsm_req = PM_STATE_LU_STARTUP;
-	ts_wait_IDLE();
+	S->pm.fsm_req = PM_STATE_LU_STARTUP;
+	ts_wait_IDLE(S);
 
-	m.unsync_flag = 1;
+	S->m.unsync_flag = 1;
 
-	pm.s_setpoint_speed = 200.f * pm.k_EMAX / 100.f
-			* pm.const_fb_U / pm.const_lambda;
+	S->pm.s_setpoint_speed = 200.f * S->pm.k_EMAX / 100.f
+			* S->pm.const_fb_U / S->pm.const_lambda;
 
-	ts_wait_spinup();
-	sim_runtime(.5);
+	ts_wait_spinup(S);
+	sim_runtime(S, .5);
 
-	TS_assert(pm.lu_MODE == PM_LU_ESTIMATE);
+	TS_assert(S->pm.lu_MODE == PM_LU_ESTIMATE);
 
-	m.Mq[0] = - 1.5 * m.Zp * m.lambda * 5.f;
-	sim_runtime(0.5);
+	S->m.Mq[0] = - 1.5 * S->m.Zp * S->m.lambda * 5.f;
+	sim_runtime(S, 0.5);
 
-	m.Mq[0] = 0.f;
-	sim_runtime(0.5);
+	S->m.Mq[0] = 0.f;
+	sim_runtime(S, 0.5);
 
-	TS_assert_absolute(pm.lu_wS, pm.s_setpoint_speed, 50.);
+	TS_assert_absolute(S->pm.lu_wS, S->pm.s_setpoint_speed, 50.);
 
-	pm.s_setpoint_speed = 10.f * pm.k_EMAX / 100.f
-		* pm.const_fb_U / pm.const_lambda;
+	S->pm.s_setpoint_speed = 10.f * S->pm.k_EMAX / 100.f
+		* S->pm.const_fb_U / S->pm.const_lambda;
 
-	ts_wait_spinup();
-	sim_runtime(0.5);
+	ts_wait_spinup(S);
+	sim_runtime(S, 0.5);
 
-	TS_assert_absolute(pm.lu_wS, pm.s_setpoint_speed, 50.);
+	TS_assert_absolute(S->pm.lu_wS, S->pm.s_setpoint_speed, 50.);
 
-	m.unsync_flag = 0;
+	S->m.unsync_flag = 0;
 
-	pm.fsm_req = PM_STATE_LU_SHUTDOWN;
-	ts_wait_IDLE();
+	S->pm.fsm_req = PM_STATE_LU_SHUTDOWN;
+	ts_wait_IDLE(S);
 }
 
 static void
-ts_script_hall()
+ts_script_hall(sim_t *S)
 {
 	int		backup_LU_ESTIMATE;
 
-	ts_adjust_sensor_hall();
-	blm_restart(&m);
+	ts_adjust_sensor_hall(S);
+	blm_restart(&S->m);
 
-	backup_LU_ESTIMATE = pm.config_LU_ESTIMATE;
+	backup_LU_ESTIMATE = S->pm.config_LU_ESTIMATE;
 
-	pm.config_LU_ESTIMATE = PM_FLUX_NONE;
-	pm.config_LU_SENSOR = PM_SENSOR_HALL;
+	S->pm.config_LU_ESTIMATE = PM_FLUX_NONE;
+	S->pm.config_LU_SENSOR = PM_SENSOR_HALL;
 
-	pm.s_damping = 0.5f;
+	S->pm.s_damping = 0.5f;
 
-	pm_auto(&pm, PM_AUTO_LOOP_SPEED);
+	pm_auto(&S->pm, PM_AUTO_LOOP_SPEED);
 
-	pm.fsm_req = PM_STATE_LU_STARTUP;
-	ts_wait_IDLE();
+	S->pm.fsm_req = PM_STATE_LU_STARTUP;
+	ts_wait_IDLE(S);
 
-	m.unsync_flag = 1;
+	S->m.unsync_flag = 1;
 
-	pm.s_setpoint_speed = 50.f * pm.k_EMAX / 100.f
-			* pm.const_fb_U / pm.const_lambda;
+	S->pm.s_setpoint_speed = 50.f * S->pm.k_EMAX / 100.f
+			* S->pm.const_fb_U / S->pm.const_lambda;
 
-	ts_wait_spinup();
-	sim_runtime(0.5);
+	ts_wait_spinup(S);
+	sim_runtime(S, 0.5);
 
-	TS_assert(pm.lu_MODE == PM_LU_SENSOR_HALL);
+	TS_assert(S->pm.lu_MODE == PM_LU_SENSOR_HALL);
 
-	m.Mq[0] = - 1.5 * m.Zp * m.lambda * 20.f;
-	sim_runtime(0.5);
+	S->m.Mq[0] = - 1.5 * S->m.Zp * S->m.lambda * 20.f;
+	sim_runtime(S, 0.5);
 
-	m.Mq[0] = 0.f;
-	sim_runtime(0.5);
+	S->m.Mq[0] = 0.f;
+	sim_runtime(S, 0.5);
 
-	TS_assert_absolute(pm.lu_wS, pm.s_setpoint_speed, 50.);
+	TS_assert_absolute(S->pm.lu_wS, S->pm.s_setpoint_speed, 50.);
 
-	pm.s_setpoint_speed = 10.f * pm.k_EMAX / 100.f
-		* pm.const_fb_U / pm.const_lambda;
+	S->pm.s_setpoint_speed = 10.f * S->pm.k_EMAX / 100.f
+		* S->pm.const_fb_U / S->pm.const_lambda;
 
-	ts_wait_spinup();
-	sim_runtime(0.5);
+	ts_wait_spinup(S);
+	sim_runtime(S, 0.5);
 
-	TS_assert_absolute(pm.lu_wS, pm.s_setpoint_speed, 50.);
+	TS_assert_absolute(S->pm.lu_wS, S->pm.s_setpoint_speed, 50.);
 
-	m.unsync_flag = 0;
+	S->m.unsync_flag = 0;
 
-	pm.fsm_req = PM_STATE_LU_SHUTDOWN;
-	ts_wait_IDLE();
+	S->pm.fsm_req = PM_STATE_LU_SHUTDOWN;
+	ts_wait_IDLE(S);
 
-	pm.config_LU_ESTIMATE = backup_LU_ESTIMATE;
-	pm.config_LU_SENSOR = PM_SENSOR_NONE;
+	S->pm.config_LU_ESTIMATE = backup_LU_ESTIMATE;
+	S->pm.config_LU_SENSOR = PM_SENSOR_NONE;
 }
 
 static void
-ts_script_eabi(int knob_EABI)
+ts_script_eabi(sim_t *S, int knob_EABI)
 {
 	int		backup_LU_ESTIMATE;
 
 	if (knob_EABI == PM_EABI_INCREMENTAL) {
 
-		m.eabi_ERES = 2400;
-		m.eabi_WRAP = 65536;
+		S->m.eabi_ERES = 2400;
+		S->m.eabi_WRAP = 65536;
 
-		pm.config_EABI_FRONTEND = PM_EABI_INCREMENTAL;
+		S->pm.config_EABI_FRONTEND = PM_EABI_INCREMENTAL;
 	}
 	else if (knob_EABI == PM_EABI_ABSOLUTE) {
 
-		m.eabi_ERES = 16384;
-		m.eabi_WRAP = 16384;
+		S->m.eabi_ERES = 16384;
+		S->m.eabi_WRAP = 16384;
 
-		pm.config_EABI_FRONTEND = PM_EABI_ABSOLUTE;
+		S->pm.config_EABI_FRONTEND = PM_EABI_ABSOLUTE;
 	}
 
-	pm.eabi_ADJUST = PM_DISABLED;
+	S->pm.eabi_ADJUST = PM_DISABLED;
 
-	ts_adjust_sensor_eabi();
-	blm_restart(&m);
+	ts_adjust_sensor_eabi(S);
+	blm_restart(&S->m);
 
-	backup_LU_ESTIMATE = pm.config_LU_ESTIMATE;
+	backup_LU_ESTIMATE = S->pm.config_LU_ESTIMATE;
 
-	pm.config_LU_ESTIMATE = PM_FLUX_NONE;
-	pm.config_LU_SENSOR = PM_SENSOR_EABI;
+	S->pm.config_LU_ESTIMATE = PM_FLUX_NONE;
+	S->pm.config_LU_SENSOR = PM_SENSOR_EABI;
 
-	pm.fsm_req = PM_STATE_LU_STARTUP;
-	ts_wait_IDLE();
+	S->pm.fsm_req = PM_STATE_LU_STARTUP;
+	ts_wait_IDLE(S);
 
-	m.unsync_flag = 1;
+	S->m.unsync_flag = 1;
 
-	pm.s_setpoint_speed = 50.f * pm.k_EMAX / 100.f
-			* pm.const_fb_U / pm.const_lambda;
+	S->pm.s_setpoint_speed = 50.f * S->pm.k_EMAX / 100.f
+			* S->pm.const_fb_U / S->pm.const_lambda;
 
-	ts_wait_spinup();
-	sim_runtime(0.5);
+	ts_wait_spinup(S);
+	sim_runtime(S, 0.5);
 
-	m.Mq[0] = - 1.5 * m.Zp * m.lambda * 20.f;
-	sim_runtime(0.5);
+	S->m.Mq[0] = - 1.5 * S->m.Zp * S->m.lambda * 20.f;
+	sim_runtime(S, 0.5);
 
-	m.Mq[0] = 0.f;
-	sim_runtime(0.5);
+	S->m.Mq[0] = 0.f;
+	sim_runtime(S, 0.5);
 
-	TS_assert(pm.lu_MODE == PM_LU_SENSOR_EABI);
-	TS_assert_absolute(pm.lu_wS, pm.s_setpoint_speed, 50.);
+	TS_assert(S->pm.lu_MODE == PM_LU_SENSOR_EABI);
+	TS_assert_absolute(S->pm.lu_wS, S->pm.s_setpoint_speed, 50.);
 
-	pm.s_setpoint_speed = 10.f * pm.k_EMAX / 100.f
-		* pm.const_fb_U / pm.const_lambda;
+	S->pm.s_setpoint_speed = 10.f * S->pm.k_EMAX / 100.f
+		* S->pm.const_fb_U / S->pm.const_lambda;
 
-	ts_wait_spinup();
-	sim_runtime(0.5);
+	ts_wait_spinup(S);
+	sim_runtime(S, 0.5);
 
-	TS_assert_absolute(pm.lu_wS, pm.s_setpoint_speed, 50.);
+	TS_assert_absolute(S->pm.lu_wS, S->pm.s_setpoint_speed, 50.);
 
-	m.unsync_flag = 0;
+	S->m.unsync_flag = 0;
 
-	pm.fsm_req = PM_STATE_LU_SHUTDOWN;
-	ts_wait_IDLE();
+	S->pm.fsm_req = PM_STATE_LU_SHUTDOWN;
+	ts_wait_IDLE(S);
 
-	pm.config_LU_ESTIMATE = backup_LU_ESTIMATE;
-	pm.config_LU_SENSOR = PM_SENSOR_NONE;
+	S->pm.config_LU_ESTIMATE = backup_LU_ESTIMATE;
+	S->pm.config_LU_SENSOR = PM_SENSOR_NONE;
 }
 
 static void
-ts_script_sincos()
+ts_script_sincos(sim_t *S)
 {
 	int		backup_LU_ESTIMATE;
 
-	ts_adjust_sensor_sincos();
-	blm_restart(&m);
+	ts_adjust_sensor_sincos(S);
+	blm_restart(&S->m);
 
-	backup_LU_ESTIMATE = pm.config_LU_ESTIMATE;
+	backup_LU_ESTIMATE = S->pm.config_LU_ESTIMATE;
 
-	pm.config_LU_ESTIMATE = PM_FLUX_NONE;
-	pm.config_LU_SENSOR = PM_SENSOR_SINCOS;
+	S->pm.config_LU_ESTIMATE = PM_FLUX_NONE;
+	S->pm.config_LU_SENSOR = PM_SENSOR_SINCOS;
 
-	pm.fsm_req = PM_STATE_LU_STARTUP;
-	ts_wait_IDLE();
+	S->pm.fsm_req = PM_STATE_LU_STARTUP;
+	ts_wait_IDLE(S);
 
-	m.unsync_flag = 1;
+	S->m.unsync_flag = 1;
 
-	pm.s_setpoint_speed = 50.f * pm.k_EMAX / 100.f
-			* pm.const_fb_U / pm.const_lambda;
+	S->pm.s_setpoint_speed = 50.f * S->pm.k_EMAX / 100.f
+			* S->pm.const_fb_U / S->pm.const_lambda;
 
-	ts_wait_spinup();
-	sim_runtime(0.5);
+	ts_wait_spinup(S);
+	sim_runtime(S, 0.5);
 
-	m.Mq[0] = - 1.5 * m.Zp * m.lambda * 20.f;
-	sim_runtime(0.5);
+	S->m.Mq[0] = - 1.5 * S->m.Zp * S->m.lambda * 20.f;
+	sim_runtime(S, 0.5);
 
-	m.Mq[0] = 0.f;
-	sim_runtime(0.5);
+	S->m.Mq[0] = 0.f;
+	sim_runtime(S, 0.5);
 
-	TS_assert(pm.lu_MODE == PM_LU_SENSOR_SINCOS);
-	TS_assert_absolute(pm.lu_wS, pm.s_setpoint_speed, 50.);
+	TS_assert(S->pm.lu_MODE == PM_LU_SENSOR_SINCOS);
+	TS_assert_absolute(S->pm.lu_wS, S->pm.s_setpoint_speed, 50.);
 
-	pm.s_setpoint_speed = 10.f * pm.k_EMAX / 100.f
-		* pm.const_fb_U / pm.const_lambda;
+	S->pm.s_setpoint_speed = 10.f * S->pm.k_EMAX / 100.f
+		* S->pm.const_fb_U / S->pm.const_lambda;
 
-	ts_wait_spinup();
-	sim_runtime(0.5);
+	ts_wait_spinup(S);
+	sim_runtime(S, 0.5);
 
-	TS_assert_absolute(pm.lu_wS, pm.s_setpoint_speed, 50.);
+	TS_assert_absolute(S->pm.lu_wS, S->pm.s_setpoint_speed, 50.);
 
-	m.unsync_flag = 0;
+	S->m.unsync_flag = 0;
 
-	pm.fsm_req = PM_STATE_LU_SHUTDOWN;
-	ts_wait_IDLE();
+	S->pm.fsm_req = PM_STATE_LU_SHUTDOWN;
+	ts_wait_IDLE(S);
 
-	pm.config_LU_ESTIMATE = backup_LU_ESTIMATE;
-	pm.config_LU_SENSOR = PM_SENSOR_NONE;
+	S->pm.config_LU_ESTIMATE = backup_LU_ESTIMATE;
+	S->pm.config_LU_SENSOR = PM_SENSOR_NONE;
 }
 
-void ts_script_test()
+static void
+ts_motor_XNOVA(sim_t *S)
 {
-	blm_enable(&m);
-	blm_restart(&m);
+	fprintf(S->fd_log, "\n---- XNOVA Lightning 4530 ----\n");
 
-	printf("\n---- XNOVA Lightning 4530 ----\n");
+	tlm_restart(S);
 
-	tlm_restart();
+	S->m.Rs = 8.e-3;
+	S->m.Ld = 3.e-6;
+	S->m.Lq = 5.e-6;
+	S->m.Udc = 48.;
+	S->m.Rdc = 0.1;
+	S->m.Zp = 5;
+	S->m.lambda = blm_Kv_lambda(&S->m, 525.);
+	S->m.Jm = 2.e-4;
 
-	m.Rs = 8.e-3;
-	m.Ld = 3.e-6;
-	m.Lq = 5.e-6;
-	m.Udc = 48.;
-	m.Rdc = 0.1;
-	m.Zp = 5;
-	m.lambda = blm_Kv_lambda(&m, 525.);
-	m.Jm = 2.e-4;
+	ts_script_default(S);
+	ts_script_base(S);
+	blm_restart(&S->m);
 
-	ts_script_default();
-	ts_script_base();
-	blm_restart(&m);
+	ts_script_speed(S);
+	blm_restart(&S->m);
 
-	ts_script_speed();
-	blm_restart(&m);
+	/*ts_script_hfi(S);
+	  blm_restart(&S->m);*/
+}
 
-	/*ts_script_hfi();
-	  blm_restart(&m);*/
+static void
+ts_motor_RotoMax(sim_t *S)
+{
+	fprintf(S->fd_log, "\n---- Turnigy RotoMax 1.20 ----\n");
 
-	printf("\n---- Turnigy RotoMax 1.20 ----\n");
+	tlm_restart(S);
 
-	tlm_restart();
+	S->m.Rs = 14.e-3;
+	S->m.Ld = 10.e-6;
+	S->m.Lq = 15.e-6;
+	S->m.Udc = 22.;
+	S->m.Rdc = 0.1;
+	S->m.Zp = 14;
+	S->m.lambda = blm_Kv_lambda(&S->m, 270.);
+	S->m.Jm = 4.e-4;
+
+	ts_script_default(S);
+	ts_script_base(S);
+	blm_restart(&S->m);
+
+	ts_script_speed(S);
+	blm_restart(&S->m);
+
+	ts_script_hfi(S);
+	blm_restart(&S->m);
+
+	ts_script_eabi(S, PM_EABI_INCREMENTAL);
+	blm_restart(&S->m);
+
+	ts_script_eabi(S, PM_EABI_ABSOLUTE);
+	blm_restart(&S->m);
+}
+
+static void
+ts_motor_Hub(sim_t *S)
+{
+	fprintf(S->fd_log, "\n---- Hub Motor (250W) ----\n");
 
-	m.Rs = 14.e-3;
-	m.Ld = 10.e-6;
-	m.Lq = 15.e-6;
-	m.Udc = 22.;
-	m.Rdc = 0.1;
-	m.Zp = 14;
-	m.lambda = blm_Kv_lambda(&m, 270.);
-	m.Jm = 4.e-4;
+	tlm_restart(S);
 
-	ts_script_default();
-	ts_script_base();
-	blm_restart(&m);
+	S->m.Rs = 0.24;
+	S->m.Ld = 520.e-6;
+	S->m.Lq = 650.e-6;
+	S->m.Udc = 48.;
+	S->m.Rdc = 0.5;
+	S->m.Zp = 15;
+	S->m.lambda = blm_Kv_lambda(&S->m, 15.);
+	S->m.Jm = 6.e-3;
 
-	ts_script_speed();
-	blm_restart(&m);
+	ts_script_default(S);
+	ts_script_base(S);
+	blm_restart(&S->m);
 
-	ts_script_hfi();
-	blm_restart(&m);
+	ts_script_speed(S);
+	blm_restart(&S->m);
 
-	ts_script_eabi(PM_EABI_INCREMENTAL);
-	blm_restart(&m);
+	ts_script_weakening(S);
+	blm_restart(&S->m);
 
-	ts_script_eabi(PM_EABI_ABSOLUTE);
-	blm_restart(&m);
+	ts_script_hall(S);
+	blm_restart(&S->m);
+}
 
-	printf("\n---- Hub Motor (250W) ----\n");
+static void
+ts_motor_QS138(sim_t *S)
+{
+	fprintf(S->fd_log, "\n---- QS 138 (3000W) ----\n");
 
-	tlm_restart();
+	tlm_restart(S);
 
-	m.Rs = 0.24;
-	m.Ld = 520.e-6;
-	m.Lq = 650.e-6;
-	m.Udc = 48.;
-	m.Rdc = 0.5;
-	m.Zp = 15;
-	m.lambda = blm_Kv_lambda(&m, 15.);
-	m.Jm = 6.e-3;
+	S->m.Rs = 4.e-3;
+	S->m.Ld = 31.e-6;
+	S->m.Lq = 44.e-6;
+	S->m.Udc = 48.;
+	S->m.Rdc = 0.1;
+	S->m.Zp = 5;
+	S->m.lambda = blm_Kv_lambda(&S->m, 58.);
+	S->m.Jm = 15.e-3;
 
-	ts_script_default();
-	ts_script_base();
-	blm_restart(&m);
+	ts_script_default(S);
+	ts_script_base(S);
+	blm_restart(&S->m);
 
-	ts_script_speed();
-	blm_restart(&m);
+	ts_script_speed(S);
+	blm_restart(&S->m);
 
-	ts_script_weakening();
-	blm_restart(&m);
+	/*ts_script_weakening(S);
+	  blm_restart(&S->m);*/
 
-	ts_script_hall();
-	blm_restart(&m);
+	ts_script_hall(S);
+	blm_restart(&S->m);
 
-	printf("\n---- QS 138 (3000W) ----\n");
+	ts_script_sincos(S);
+	blm_restart(&S->m);
+}
 
-	tlm_restart();
+static void (* const ts_motor_list[]) (sim_t *) = {
 
-	m.Rs = 4.e-3;
-	m.Ld = 31.e-6;
-	m.Lq = 44.e-6;
-	m.Udc = 48.;
-	m.Rdc = 0.1;
-	m.Zp = 5;
-	m.lambda = blm_Kv_lambda(&m, 58.);
-	m.Jm = 15.e-3;
+	&ts_motor_XNOVA,
+	&ts_motor_RotoMax,
+	&ts_motor_Hub,
+	&ts_motor_QS138
+};
 
-	ts_script_default();
-	ts_script_base();
-	blm_restart(&m);
+#define TS_MOTOR_MAX		(sizeof(ts_motor_list) / sizeof(ts_motor_list[0]))
 
-	ts_script_speed();
-	blm_restart(&m);
+typedef struct {
 
-	/*ts_script_weakening();
-	  blm_restart(&m);*/
+	sim_t		*sim[TS_MOTOR_MAX];
 
-	ts_script_hall();
-	blm_restart(&m);
+	char		*log_buf[TS_MOTOR_MAX];
+	size_t		log_len[TS_MOTOR_MAX];
 
-	ts_script_sincos();
-	blm_restart(&m);
+	int		njobs;
+	int		solver;
+	int		next;
+	int		seed;
 }
+ts_pool_t;
+
+static void
+ts_pool_run(ts_pool_t *pool, int N)
+{
+	sim_t		*S = pool->sim[N];
+
+	/* Each job owns a fresh context so the result does not
+	 * depend on which motor was run before on the same thread.
+	 * */
+	lfg_start(pool->seed + N);
 
+	if (pool->njobs > 1) {
+
+		S->unit = N + 1;
+		S->fd_log = open_memstream(&pool->log_buf[N], &pool->log_len[N]);
+	}
+	else {
+		S->unit = 0;
+		S->fd_log = stdout;
+	}
+
+	S->m.solver = pool->solver;
+
+	blm_enable(&S->m);
+	blm_restart(&S->m);
+
+	ts_motor_list[N](S);
+
+	fprintf(S->fd_log, "sol_nstep = %li (%li rejected) emax = %.3f\n",
+			S->m.sol_nstep, S->m.sol_nfail, S->m.sol_emax);
+
+	tlm_stop(S);
+
+	if (S->fd_log != stdout) {
+
+		fclose(S->fd_log);
+	}
+}
+
+static void *
+ts_pool_thread(void *arg)
+{
+	ts_pool_t	*pool = (ts_pool_t *) arg;
+	int		N;
+
+	while ((N = __sync_fetch_and_add(&pool->next, 1)) < (int) TS_MOTOR_MAX) {
+
+		ts_pool_run(pool, N);
+	}
+
+	return NULL;
+}
+
+void ts_script_test(int njobs, int solver)
+{
+	ts_pool_t	pool;
+	pthread_t	thread[TS_MOTOR_MAX];
+	int		N;
+
+	memset(&pool, 0, sizeof(pool));
+
+	njobs = (njobs > (int) TS_MOTOR_MAX) ? (int) TS_MOTOR_MAX : njobs;
+
+	pool.njobs = njobs;
+	pool.solver = solver;
+	pool.seed = (int) time(NULL);
+
+	for (N = 0; N < (int) TS_MOTOR_MAX; ++N) {
+
+		pool.sim[N] = calloc(1, sizeof(sim_t));
+
+		if (pool.sim[N] == NULL) {
+
+			fprintf(stderr, "calloc: %s\n", strerror(errno));
+			abort();
+		}
+	}
+
+	if (njobs > 1) {
+
+		for (N = 0; N < njobs; ++N) {
+
+			pthread_create(&thread[N], NULL, &ts_pool_thread, &pool);
+		}
+
+		for (N = 0; N < njobs; ++N) {
+
+			pthread_join(thread[N], NULL);
+		}
+
+		/* Print the logs in the same order as a serial run does.
+		 * */
+		for (N = 0; N < (int) TS_MOTOR_MAX; ++N) {
+
+			fwrite(pool.log_buf[N], 1, pool.log_len[N], stdout);
+			free(pool.log_buf[N]);
+		}
+	}
+	else {
+		ts_pool_thread(&pool);
+	}
+
+	for (N = 0; N < (int) TS_MOTOR_MAX; ++N) {
+
+		free(pool.sim[N]);
+	}
+}
@@ -1,22 +1,71 @@
 #ifndef _H_TSFUNC_
 #define _H_TSFUNC_
 
-extern blm_t			m;
-extern pmc_t			pm;
+#include <stdio.h>
+#include <setjmp.h>
 
-extern void tlm_restart();
-extern void sim_runtime(double dT);
+#include "mldata.h"
 
-int ts_wait_IDLE();
-int ts_wait_motion();
-int ts_wait_spinup();
+#define TLM_SIZE		100
 
-void ts_adjust_sensor_hall();
-void ts_adjust_sensor_eabi();
+typedef struct {
 
-void ts_script_default();
-void ts_script_base();
-void ts_script_test();
+	int		hatch;
+
+	float		y[TLM_SIZE];
+
+	FILE		*fd_tlm;
+	FILE		*fd_pwm;
+	mld_t		*mld;
+	FILE		*fd_gp;
+}
+tlm_t;
+
+typedef struct {
+
+	blm_t		m;
+	pmc_t		pm;
+	tlm_t		tlm;
+
+	/* Unit number is appended to the file names when several
+	 * simulation contexts run concurrently.
+	 * */
+	int		unit;
+
+	/* Fault handler of the scenario runner. If it is not set the
+	 * process is terminated on fault.
+	 * */
+	jmp_buf		*fault;
+
+	FILE		*fd_log;
+}
+sim_t;
+
+extern __thread sim_t		*sim_local;
+
+void tlm_restart(sim_t *S);
+void tlm_stop(sim_t *S);
+
+void sim_fault(sim_t *S);
+void sim_feedback(sim_t *S, pmfb_t *fb);
+void sim_runtime(sim_t *S, double dT);
+
+int ts_wait_IDLE(sim_t *S);
+int ts_wait_motion(sim_t *S);
+int ts_wait_spinup(sim_t *S);
+
+void ts_adjust_sensor_hall(sim_t *S);
+void ts_adjust_sensor_eabi(sim_t *S);
+void ts_adjust_sensor_sincos(sim_t *S);
+
+void ts_script_default(sim_t *S);
+void ts_script_base(sim_t *S);
+void ts_script_test(int njobs, int solver);
+
+void perf_script();
+void batch_script();
+void step_script();
+int scene_script(int njobs, int solver, int nfiles, char *files[]);
 
 #endif /* _H_TSFUNC_ */
 
@@ -829,7 +829,16 @@ readCSVGetRow(read_t *rd, int dN, int label_N)
 
 				m = 1;
 
-				if (hint[N] == DATA_HINT_FLOAT) {
+				if (		*s == '-'
+						&& (	   *(s + 1) == 0
+							|| strchr(rd->mk_text.space, *(s + 1)) != NULL
+							|| strchr(rd->mk_text.lend, *(s + 1)) != NULL)) {
+
+					/* Sparse column holds the previous value.
+					 * */
+					row++;
+				}
+				else if (hint[N] == DATA_HINT_FLOAT) {
 
 					r = stod(&rd->mk_text, &val, s);
 
@@ -1001,6 +1010,13 @@ readCSVGetLabel(read_t *rd, int dN)
 		*label = 0;
 	}
 
+	for (m = 0; m < READ_COLUMN_MAX; ++m) {
+
+		/* Sparse columns are undefined until the first value.
+		 * */
+		rd->data[dN].row[m] = (fval_t) FP_NAN;
+	}
+
 	return N;
 }
 
@@ -1,6 +1,7 @@
 #include <stdlib.h>
 #include <stdio.h>
 #include <string.h>
+#include <math.h>
 #include <time.h>
 
 #include <SDL2/SDL.h>
@@ -17,11 +18,37 @@
 #define LINK_ALLOC_MAX			92160U
 #define LINK_CACHE_MAX			4096U
 
+/* Binary telemetry frames are the same as in src/tlm.h.
+ * */
+#define LINK_FRAME_INPUT_MAX		20
+#define LINK_FRAME_MAX			(12 + LINK_FRAME_INPUT_MAX * 4)
+#define LINK_BULK_MAX			1024
+
+#define LINK_SLIP_END			0xC0
+#define LINK_SLIP_ESC			0xDB
+#define LINK_SLIP_ESC_END		0xDC
+#define LINK_SLIP_ESC_ESC		0xDD
+
+enum {
+	LINK_FRAME_HEADER		= 'H',
+	LINK_FRAME_DATA			= 'D',
+	LINK_FRAME_BULK			= 'B',
+	LINK_FRAME_END			= 'E'
+};
+
+enum {
+	LINK_BULK_NONE			= 0,
+	LINK_BULK_HEAD,
+	LINK_BULK_BLOCK
+};
+
 enum {
 	LINK_MODE_IDLE			= 0,
 	LINK_MODE_HWINFO,
 	LINK_MODE_GETTICK,
 	LINK_MODE_DATA_GRAB,
+	LINK_MODE_DATA_LABEL,
+	LINK_MODE_DATA_BINARY,
 	LINK_MODE_EPCAN_MAP,
 	LINK_MODE_FLASH_MAP,
 	LINK_MODE_COMMAND,
@@ -43,6 +70,35 @@ struct link_priv {
 	char			*mbflow;
 
 	int			cache[LINK_CACHE_MAX];
+
+	struct {
+
+		int		started;
+		int		escaped;
+		int		seq;
+
+		unsigned char	frame[LINK_FRAME_MAX];
+		int		frame_N;
+
+		int		layout_N;
+		char		layout_kind[LINK_FRAME_INPUT_MAX];
+		int		layout_div[LINK_FRAME_INPUT_MAX];
+
+		double		dT;
+		int		precision;
+
+		int		bulk;
+		int		bulk_line;
+		int		bulk_clock;
+		int		bulk_origin;
+		int		bulk_size;
+		int		bulk_lines;
+		unsigned int	bulk_crc;
+
+		unsigned char	block[LINK_BULK_MAX];
+		int		block_N;
+	}
+	binary;
 };
 
 const char *lk_stoi(int *x, const char *s)
@@ -281,6 +337,403 @@ link_fetch_network(struct link_pmc *lp)
 	return 0;
 }
 
+static unsigned int
+link_crc32u(const unsigned char *raw, int len)
+{
+	unsigned int		crcsum = 0xFFFFFFFFU;
+	int			N, K;
+
+	for (N = 0; N < len; ++N) {
+
+		crcsum ^= (unsigned int) raw[N];
+
+		for (K = 0; K < 8; ++K) {
+
+			crcsum = (crcsum >> 1) ^ (0xEDB88320U & - (crcsum & 1U));
+		}
+	}
+
+	return crcsum ^ 0xFFFFFFFFU;
+}
+
+static unsigned int
+link_frame_u32(const unsigned char *raw)
+{
+	return	  (unsigned int) raw[0]
+		| ((unsigned int) raw[1] << 8)
+		| ((unsigned int) raw[2] << 16)
+		| ((unsigned int) raw[3] << 24);
+}
+
+static void
+link_frame_layout(struct link_pmc *lp, const unsigned char *frame, int len)
+{
+	struct link_priv	*priv = lp->priv;
+	unsigned int		u32;
+	float			dT;
+	int			N, layout_N, width;
+
+	layout_N = frame[3];
+
+	if (layout_N > LINK_FRAME_INPUT_MAX)
+		return ;
+
+	/* Channel is described by three bytes in older firmware that has
+	 * no decimated channels.
+	 * */
+	if (len == 8 + layout_N * 4) {
+
+		width = 4;
+	}
+	else if (len == 8 + layout_N * 3) {
+
+		width = 3;
+	}
+	else {
+		return ;
+	}
+
+	u32 = link_frame_u32(frame + 4);
+	memcpy(&dT, &u32, sizeof(float));
+
+	for (N = 0; N < layout_N; ++N) {
+
+		priv->binary.layout_kind[N] = (char) frame[8 + N * width + 2];
+		priv->binary.layout_div[N] = (width == 4) ? frame[8 + N * width + 3] : 1;
+
+		if (priv->binary.layout_div[N] < 1) {
+
+			priv->binary.layout_div[N] = 1;
+		}
+	}
+
+	priv->binary.layout_N = layout_N;
+	priv->binary.dT = (double) dT;
+
+	priv->binary.precision = (int) (2.9 - log10(priv->binary.dT));
+	priv->binary.precision = (priv->binary.precision < 2) ? 2
+		: (priv->binary.precision > 7) ? 7 : priv->binary.precision;
+}
+
+static int
+link_frame_size(struct link_pmc *lp, int line)
+{
+	struct link_priv	*priv = lp->priv;
+	int			N, size = 0;
+
+	/* Decimated channels are present on a fraction of lines.
+	 * */
+	for (N = 0; N < priv->binary.layout_N; ++N) {
+
+		size += (line % priv->binary.layout_div[N] == 0) ? 4 : 0;
+	}
+
+	return size;
+}
+
+static void
+link_frame_print(struct link_pmc *lp, double time, int line,
+		const unsigned char *data)
+{
+	struct link_priv	*priv = lp->priv;
+	unsigned int		u32;
+	float			fval;
+	int			N, size;
+
+	fprintf(priv->fd_grab, "%.*f;", priv->binary.precision, time);
+
+	size = 0;
+
+	for (N = 0; N < priv->binary.layout_N; ++N) {
+
+		if (line % priv->binary.layout_div[N] != 0) {
+
+			fprintf(priv->fd_grab, "-;");
+			continue;
+		}
+
+		u32 = link_frame_u32(data + size);
+		size += 4;
+
+		if (priv->binary.layout_kind[N] == 'i') {
+
+			fprintf(priv->fd_grab, "%i;", (int) u32);
+		}
+		else {
+			memcpy(&fval, &u32, sizeof(float));
+
+			fprintf(priv->fd_grab, "%.7g;", (double) fval);
+		}
+	}
+
+	fprintf(priv->fd_grab, "\n");
+
+	lp->locked = lp->clock;
+	lp->grab_N++;
+}
+
+static void
+link_frame_line(struct link_pmc *lp, const unsigned char *frame, int len)
+{
+	struct link_priv	*priv = lp->priv;
+	int			clock;
+
+	if (		   priv->fd_grab == NULL
+			|| priv->binary.layout_N == 0)
+		return ;
+
+	clock = (int) link_frame_u32(frame + 3);
+
+	if (len != 7 + link_frame_size(lp, clock))
+		return ;
+
+	link_frame_print(lp, (double) clock * priv->binary.dT, clock, frame + 7);
+}
+
+static void
+link_frame_bulk(struct link_pmc *lp, const unsigned char *frame, int len)
+{
+	struct link_priv	*priv = lp->priv;
+
+	if (len != 11)
+		return ;
+
+	/* Raw blocks of lines follow the frame. We need the first line
+	 * number to know which values are present and the trigger line
+	 * to place the time origin.
+	 * */
+	priv->binary.bulk = LINK_BULK_HEAD;
+	priv->binary.bulk_line = (int) link_frame_u32(frame + 3);
+	priv->binary.bulk_origin = (int) link_frame_u32(frame + 7);
+	priv->binary.bulk_clock = 0;
+
+	priv->binary.block_N = 0;
+}
+
+static void
+link_frame_block(struct link_pmc *lp)
+{
+	struct link_priv	*priv = lp->priv;
+	int			N, size, offset, valid;
+
+	valid = (link_crc32u(priv->binary.block, priv->binary.bulk_size)
+			== priv->binary.bulk_crc) ? 1 : 0;
+
+	offset = 0;
+
+	for (N = 0; N < priv->binary.bulk_lines; ++N) {
+
+		size = link_frame_size(lp, priv->binary.bulk_line);
+
+		if (offset + size > priv->binary.bulk_size) {
+
+			valid = 0;
+		}
+
+		if (valid != 0 && priv->fd_grab != NULL) {
+
+			link_frame_print(lp, (double) (priv->binary.bulk_clock
+					- priv->binary.bulk_origin) * priv->binary.dT,
+					priv->binary.bulk_line,
+					priv->binary.block + offset);
+		}
+
+		offset += size;
+
+		priv->binary.bulk_line++;
+		priv->binary.bulk_clock++;
+	}
+
+	if (valid == 0) {
+
+		lp->grab_lost += priv->binary.bulk_lines;
+	}
+}
+
+static int
+link_fetch_bulk(struct link_pmc *lp)
+{
+	struct link_priv	*priv = lp->priv;
+	unsigned char		*block = priv->binary.block;
+	int			len, size;
+
+	size = (priv->binary.bulk == LINK_BULK_HEAD) ? 12 : priv->binary.bulk_size;
+
+	len = serial_fread(priv->fd, (char *) block + priv->binary.block_N,
+			size - priv->binary.block_N);
+
+	if (len <= 0)
+		return 0;
+
+	lp->active = lp->clock;
+
+	priv->binary.block_N += len;
+
+	if (priv->binary.block_N == size) {
+
+		priv->binary.block_N = 0;
+
+		if (priv->binary.bulk == LINK_BULK_HEAD) {
+
+			priv->binary.bulk_size = (int) link_frame_u32(block);
+			priv->binary.bulk_lines = (int) link_frame_u32(block + 4);
+			priv->binary.bulk_crc = link_frame_u32(block + 8);
+
+			if (priv->binary.bulk_size == 0) {
+
+				/* Empty block marks the end of bulk data.
+				 * */
+				priv->binary.bulk = LINK_BULK_NONE;
+			}
+			else if (	   priv->binary.bulk_size < 0
+					|| priv->binary.bulk_size > LINK_BULK_MAX) {
+
+				/* We are out of sync so go back to frames.
+				 * */
+				lp->grab_lost++;
+
+				priv->binary.bulk = LINK_BULK_NONE;
+			}
+			else {
+				priv->binary.bulk = LINK_BULK_BLOCK;
+			}
+		}
+		else {
+			link_frame_block(lp);
+
+			priv->binary.bulk = LINK_BULK_HEAD;
+		}
+	}
+
+	return len;
+}
+
+static void
+link_frame_decode(struct link_pmc *lp)
+{
+	struct link_priv	*priv = lp->priv;
+	unsigned char		*frame = priv->binary.frame;
+	int			len, seq;
+
+	len = priv->binary.frame_N - 4;
+
+	if (len < 3)
+		return ;
+
+	if (link_crc32u(frame, len) != link_frame_u32(frame + len)) {
+
+		lp->grab_lost++;
+		return ;
+	}
+
+	seq = frame[1] | (frame[2] << 8);
+
+	if (priv->binary.started != 0) {
+
+		/* Count the frames that we have missed.
+		 * */
+		lp->grab_lost += (seq - priv->binary.seq - 1) & 0xFFFF;
+	}
+
+	priv->binary.started = 1;
+	priv->binary.seq = seq;
+
+	switch (frame[0]) {
+
+		case LINK_FRAME_HEADER:
+			link_frame_layout(lp, frame, len);
+			break;
+
+		case LINK_FRAME_DATA:
+			link_frame_line(lp, frame, len);
+			break;
+
+		case LINK_FRAME_BULK:
+			link_frame_bulk(lp, frame, len);
+			break;
+
+		case LINK_FRAME_END:
+
+			if (priv->fd_grab != NULL) {
+
+				fflush(priv->fd_grab);
+			}
+
+			priv->link_mode = LINK_MODE_DATA_GRAB;
+			break;
+	}
+}
+
+static int
+link_fetch_binary(struct link_pmc *lp)
+{
+	struct link_priv	*priv = lp->priv;
+	char			cq;
+	int			len, N = 0;
+
+	/* We read bytes one by one to stop exactly at the end of the
+	 * binary stream as text lines follow it.
+	 * */
+	while (priv->link_mode == LINK_MODE_DATA_BINARY) {
+
+		int		c;
+
+		if (priv->binary.bulk != LINK_BULK_NONE) {
+
+			/* Raw blocks have known size so we read them
+			 * in one go.
+			 * */
+			len = link_fetch_bulk(lp);
+
+			if (len == 0)
+				break;
+
+			N += len;
+			continue;
+		}
+
+		if (serial_fread(priv->fd, &cq, 1) != 1)
+			break;
+
+		c = (unsigned char) cq;
+
+		lp->active = lp->clock;
+
+		if (c == LINK_SLIP_END) {
+
+			if (priv->binary.frame_N > 0) {
+
+				link_frame_decode(lp);
+			}
+
+			priv->binary.frame_N = 0;
+			priv->binary.escaped = 0;
+		}
+		else if (c == LINK_SLIP_ESC) {
+
+			priv->binary.escaped = 1;
+		}
+		else {
+			if (priv->binary.escaped != 0) {
+
+				c = (c == LINK_SLIP_ESC_END) ? LINK_SLIP_END
+				  : (c == LINK_SLIP_ESC_ESC) ? LINK_SLIP_ESC : c;
+
+				priv->binary.escaped = 0;
+			}
+
+			if (priv->binary.frame_N < LINK_FRAME_MAX) {
+
+				priv->binary.frame[priv->binary.frame_N++] = (unsigned char) c;
+			}
+		}
+
+		N++;
+	}
+
+	return N;
+}
+
 static void
 link_reg_postproc(struct link_pmc *lp, struct link_reg *reg)
 {
@@ -699,6 +1152,7 @@ void link_remote(struct link_pmc *lp)
 	lp->keep = lp->clock;
 
 	lp->grab_N = 0;
+	lp->grab_lost = 0;
 
 	memset(lp->reg, 0, sizeof(lp->reg));
 
@@ -745,6 +1199,8 @@ int link_fetch(struct link_pmc *lp, int clock)
 		{ "pm_adjust",		LINK_MODE_COMMAND },
 		{ "tlm_flush_sync",	LINK_MODE_DATA_GRAB },
 		{ "tlm_stream_sync",	LINK_MODE_DATA_GRAB },
+		{ "tlm_stream_binary",	LINK_MODE_DATA_LABEL },
+		{ "tlm_flush_bulk",	LINK_MODE_DATA_LABEL },
 		{ "net_survey",		LINK_MODE_EPCAN_MAP },
 		{ "net_assign",		LINK_MODE_COMMAND },
 		{ "net_revoke",		LINK_MODE_COMMAND },
@@ -758,7 +1214,13 @@ int link_fetch(struct link_pmc *lp, int clock)
 	if (lp->linked == 0)
 		return 0;
 
-	while (serial_fgets(priv->fd, priv->lbuf, sizeof(priv->lbuf)) == SERIAL_OK) {
+	if (priv->link_mode == LINK_MODE_DATA_BINARY) {
+
+		N += link_fetch_binary(lp);
+	}
+
+	while (		   priv->link_mode != LINK_MODE_DATA_BINARY
+			&& serial_fgets(priv->fd, priv->lbuf, sizeof(priv->lbuf)) == SERIAL_OK) {
 
 		lp->active = lp->clock;
 
@@ -778,7 +1240,8 @@ int link_fetch(struct link_pmc *lp, int clock)
 				lp->command_state = LINK_COMMAND_NONE;
 			}
 
-			if (priv->link_mode == LINK_MODE_DATA_GRAB) {
+			if (		   priv->link_mode == LINK_MODE_DATA_GRAB
+					|| priv->link_mode == LINK_MODE_DATA_LABEL) {
 
 				link_grab_file_close(lp);
 			}
@@ -848,6 +1311,23 @@ int link_fetch(struct link_pmc *lp, int clock)
 				lp->grab_N++;
 				break;
 
+			case LINK_MODE_DATA_LABEL:
+
+				if (priv->fd_grab != NULL) {
+
+					fprintf(priv->fd_grab, "%s\n", priv->lbuf);
+					fflush(priv->fd_grab);
+				}
+
+				/* Label line is followed by binary frames.
+				 * */
+				memset(&priv->binary, 0, sizeof(priv->binary));
+
+				priv->link_mode = LINK_MODE_DATA_BINARY;
+
+				lp->grab_lost = 0;
+				break;
+
 			case LINK_MODE_EPCAN_MAP:
 				link_fetch_epcan_map(lp);
 				break;
@@ -864,7 +1344,9 @@ int link_fetch(struct link_pmc *lp, int clock)
 		N++;
 	}
 
-	if (priv->link_mode == LINK_MODE_DATA_GRAB) {
+	if (		   priv->link_mode == LINK_MODE_DATA_GRAB
+			|| priv->link_mode == LINK_MODE_DATA_LABEL
+			|| priv->link_mode == LINK_MODE_DATA_BINARY) {
 
 		if (lp->active + 1000 < lp->clock) {
 
@@ -937,7 +1419,11 @@ void link_push(struct link_pmc *lp)
 	if (lp->locked > lp->clock)
 		return ;
 
-	if (priv->link_mode == LINK_MODE_DATA_GRAB)
+	/* Any byte sent while data is flowing stops it on the remote side.
+	 * */
+	if (		   priv->link_mode == LINK_MODE_DATA_GRAB
+			|| priv->link_mode == LINK_MODE_DATA_LABEL
+			|| priv->link_mode == LINK_MODE_DATA_BINARY)
 		return ;
 
 	queued_N = link_reg_all_queued(lp);
@@ -1331,7 +1817,9 @@ void link_grab_file_close(struct link_pmc *lp)
 		priv->fd_grab = NULL;
 	}
 
-	if (priv->link_mode == LINK_MODE_DATA_GRAB) {
+	if (		   priv->link_mode == LINK_MODE_DATA_GRAB
+			|| priv->link_mode == LINK_MODE_DATA_LABEL
+			|| priv->link_mode == LINK_MODE_DATA_BINARY) {
 
 		priv->link_mode = LINK_MODE_IDLE;
 
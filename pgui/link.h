@@ -122,6 +122,7 @@ struct link_pmc {
 
 	int			line_N;
 	int			grab_N;
+	int			grab_lost;
 
 	struct link_reg		reg[LINK_REGS_MAX];
 
@@ -1124,7 +1124,7 @@ pub_popup_telemetry_plot(struct public *pub, int popup)
 
 				if (link_grab_file_open(lp, pub->telemetry.file_snap) != 0) {
 
-					if (link_command(lp, "tlm_flush_sync") != 0) {
+					if (link_command(lp, "tlm_flush_bulk") != 0) {
 
 						pub->telemetry.wait_GP = 1;
 					}
@@ -1159,7 +1159,7 @@ pub_popup_telemetry_plot(struct public *pub, int popup)
 
 				if (link_grab_file_open(lp, pub->telemetry.file_snap) != 0) {
 
-					if (link_command(lp, "tlm_stream_sync") != 0) {
+					if (link_command(lp, "tlm_stream_binary") != 0) {
 
 						pub->telemetry.wait_GP = 1;
 					}
@@ -1168,7 +1168,7 @@ pub_popup_telemetry_plot(struct public *pub, int popup)
 
 					if (reg != NULL) {
 
-						reg->lval = 3;
+						reg->lval = 5;
 						reg->onefetch = 1;
 					}
 
@@ -1248,7 +1248,14 @@ pub_popup_telemetry_plot(struct public *pub, int popup)
 
 		nk_spacer(ctx);
 
-		sprintf(pub->lbuf, "Grab # %i", lp->grab_N);
+		if (lp->grab_lost != 0) {
+
+			sprintf(pub->lbuf, "Grab # %i (lost %i)", lp->grab_N, lp->grab_lost);
+		}
+		else {
+			sprintf(pub->lbuf, "Grab # %i", lp->grab_N);
+		}
+
 		nk_label(ctx, pub->lbuf, NK_TEXT_LEFT);
 
 		nk_spacer(ctx);
@@ -4837,6 +4844,7 @@ page_config(struct public *pub)
 		reg_enum_combo(pub, "pm.config_EXCITATION", "Machine EXCITATION", 0);
 		reg_enum_combo(pub, "pm.config_SALIENCY", "Machine SALIENCY", 0);
 		reg_enum_toggle(pub, "pm.config_RELUCTANCE", "Reluctance MTPA control");
+		reg_enum_toggle(pub, "pm.config_MTPA_TABLE", "MTPA lookup table");
 		reg_enum_toggle(pub, "pm.config_WEAKENING", "Flux WEAKENING control");
 
 		reg_enum_combo(pub, "pm.config_CC_BRAKE_STOP", "DRIVE brake function", 1);
@@ -4861,6 +4869,7 @@ page_config(struct public *pub)
 		reg_float(pub, "pm.tm_pause_startup", "Startup pause");
 		reg_float(pub, "pm.tm_pause_forced", "FORCED pause");
 		reg_float(pub, "pm.tm_pause_on_halt", "Halt (fault) pause");
+		reg_float(pub, "pm.tm_schedule_build", "Gain schedule build");
 
 		nk_layout_row_dynamic(ctx, 0, 1);
 		nk_spacer(ctx);
@@ -5857,6 +5866,7 @@ page_lp_current(struct public *pub)
 
 	reg_enum_combo(pub, "pm.config_CC_BRAKE_STOP", "DRIVE brake function", 1);
 	reg_enum_toggle(pub, "pm.config_CC_SPEED_TRACK", "DRIVE speed tracking");
+	reg_enum_toggle(pub, "pm.config_CC_DEADBEAT", "Deadbeat current loop");
 
 	nk_layout_row_dynamic(ctx, 0, 1);
 	nk_spacer(ctx);
@@ -5876,6 +5886,7 @@ page_lp_current(struct public *pub)
 	reg_float(pub, "pm.i_damping", "Damping percentage");
 	reg_float(pub, "pm.i_gain_P", "Proportional GAIN");
 	reg_float(pub, "pm.i_gain_I", "Integral GAIN");
+	reg_float(pub, "pm.i_gain_DB", "Deadbeat GAIN");
 
 	reg = link_reg_lookup(lp, "pm.i_maximal");
 
@@ -6279,6 +6290,27 @@ page_telemetry(struct public *pub)
 			}
 		}
 
+		if (nk_menu_item_label(ctx, "TLM arm trigger", NK_TEXT_LEFT)) {
+
+			if (link_command(lp, "tlm_trigger") != 0) {
+
+				reg = link_reg_lookup(lp, "tlm.mode");
+
+				if (reg != NULL) {
+
+					reg->lval = 6;
+					reg->onefetch = 1;
+				}
+
+				reg  = link_reg_lookup(lp, "tlm.length_MAX");
+
+				if (reg != NULL) {
+
+					reg->onefetch = 1;
+				}
+			}
+		}
+
 		if (nk_menu_item_label(ctx, "TLM stream through CAN", NK_TEXT_LEFT)) {
 
 			if (link_command(lp, "tlm_stream_async") != 0) {
@@ -6374,6 +6406,26 @@ page_telemetry(struct public *pub)
 		nk_layout_row_dynamic(ctx, 0, 1);
 		nk_spacer(ctx);
 
+		reg_linked(pub, "tlm.trig_ID", "Trigger register ID");
+		reg_enum_combo(pub, "tlm.trig_TYPE", "Trigger condition", 0);
+		reg_float(pub, "tlm.trig_level", "Trigger level");
+		reg_float(pub, "tlm.trig_range", "Trigger window range");
+		reg_float(pub, "tlm.trig_pre", "Pre-trigger depth");
+		reg_enum_combo(pub, "tlm.trig_ARM", "Trigger re-arm mode", 0);
+		reg_enum_errno(pub, "tlm.trig_state", "Trigger state", 1);
+		reg_float(pub, "tlm.trig_N", "Trigger count");
+
+		reg = link_reg_lookup(lp, "tlm.trig_state");
+
+		if (reg != NULL) {
+
+			reg->update = (reg->lval == 1 || reg->lval == 2) ? 100 : 1000;
+			reg->shown = lp->clock;
+		}
+
+		nk_layout_row_dynamic(ctx, 0, 1);
+		nk_spacer(ctx);
+
 		for (N = 0; N < 20; ++N) {
 
 			sprintf(pub->lbuf, "tlm.reg_ID%d", N);
@@ -6386,6 +6438,26 @@ page_telemetry(struct public *pub)
 
 			reg_float_prog_by_ID(pub, reg_ID);
 
+			sprintf(pub->lbuf + 160, "tlm.reg_FMT%d", N);
+			sprintf(pub->lbuf + 240, "Storage format %d", N);
+
+			reg_enum_combo(pub, pub->lbuf + 160, pub->lbuf + 240, 0);
+
+			reg = link_reg_lookup(lp, pub->lbuf + 160);
+
+			if (reg != NULL && reg->lval != 0) {
+
+				sprintf(pub->lbuf + 160, "tlm.reg_scale%d", N);
+				sprintf(pub->lbuf + 240, "Storage scale %d", N);
+
+				reg_float(pub, pub->lbuf + 160, pub->lbuf + 240);
+			}
+
+			sprintf(pub->lbuf + 160, "tlm.reg_DIV%d", N);
+			sprintf(pub->lbuf + 240, "Rate divider %d", N);
+
+			reg_float(pub, pub->lbuf + 160, pub->lbuf + 240);
+
 			if (reg_ID > 0 && reg_ID < lp->reg_MAX_N) {
 
 				reg = &lp->reg[reg_ID];
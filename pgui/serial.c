@@ -49,7 +49,7 @@ struct async_priv {
 };
 
 static struct async_priv *
-async_open(int length)
+async_open(int length, int chunk)
 {
 	struct async_priv	*ap;
 
@@ -58,7 +58,7 @@ async_open(int length)
 	ap->length = length;
 	ap->stream = (char *) malloc(ap->length);
 
-	ap->chunk = 80;
+	ap->chunk = chunk;
 	ap->ophunk = (char *) malloc(ap->chunk);
 
 	return ap;
@@ -175,6 +175,37 @@ async_fgets(struct async_priv *ap, char *sbuf, int n)
 	}
 }
 
+static int
+async_read(struct async_priv *ap, char *sbuf, int n)
+{
+	int		rp, wp, nq = 0;
+
+	rp = SDL_AtomicGet(&ap->rp);
+	wp = SDL_AtomicGet(&ap->wp);
+
+	while (rp != wp && nq < n) {
+
+		*sbuf++ = ap->stream[rp];
+		nq++;
+
+		rp = (rp < ap->length - 1) ? rp + 1 : 0;
+	}
+
+	if (nq > 0) {
+
+		/* Drop the line scan cache as we took the data away.
+		 * */
+		ap->cached = -1;
+
+		SDL_AtomicSet(&ap->rp, rp);
+
+		return nq;
+	}
+	else {
+		return SERIAL_ASYNC_WAIT;
+	}
+}
+
 static int
 async_space(struct async_priv *ap)
 {
@@ -655,7 +686,12 @@ async_thread_rx(struct serial_fd *fd)
 			while (1);
 		}
 
-		SDL_Delay(1);
+		if (n < ap->chunk) {
+
+			/* Do not sleep while bulk data is coming.
+			 * */
+			SDL_Delay(1);
+		}
 
 		if (SDL_AtomicGet(&ap->terminate) != 0)
 			break;
@@ -725,8 +761,11 @@ struct serial_fd *serial_open(const char *devname, int baudrate, const char *mod
 
 	if (fd != NULL) {
 
-		fd->rxq = async_open(4000);
-		fd->txq = async_open(200);
+		/* Receive queue is large enough to keep up with binary
+		 * telemetry stream.
+		 * */
+		fd->rxq = async_open(65536, 1024);
+		fd->txq = async_open(200, 80);
 
 		fd->thread_rxq = SDL_CreateThread((int (*) (void *)) &async_thread_rx,
 				"async_thread_rx", fd);
@@ -799,3 +838,8 @@ int serial_fgets(struct serial_fd *fd, char *s, int n)
 	return async_fgets(fd->rxq, s, n);
 }
 
+int serial_fread(struct serial_fd *fd, char *s, int n)
+{
+	return async_read(fd->rxq, s, n);
+}
+
@@ -29,6 +29,7 @@ void serial_close(struct serial_fd *fd);
 
 int serial_fputs(struct serial_fd *fd, const char *s);
 int serial_fgets(struct serial_fd *fd, char *s, int n);
+int serial_fread(struct serial_fd *fd, char *s, int n);
 
 #endif /* _H_SERIAL_ */
 
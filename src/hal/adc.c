@@ -13,7 +13,7 @@ priv_ADC_t;
 
 static priv_ADC_t		priv_ADC;
 
-void irq_ADC()
+LD_RAMCORE void irq_ADC()
 {
 	if (likely(ADC3->SR & ADC_SR_JEOC)) {
 
@@ -58,8 +58,10 @@ void irq_ADC()
 	}
 }
 
-void irq_EXTI0()
+LD_RAMCORE void irq_EXTI0()
 {
+	uint32_t		CYC;
+
 	EXTI->PR = EXTI_PR_PR0;
 
 	hal.CNT_raw[0] = TIM1->ARR - TIM1->CNT;
@@ -67,10 +69,18 @@ void irq_EXTI0()
 
 	hal.CNT_raw[2] = hal.CNT_raw[1];
 
+	CYC = DWT->CYCCNT;
+
 	ADC_IRQ();
 
+	CYC = DWT->CYCCNT - CYC;
+
 	hal.CNT_raw[3] = TIM7->CNT;
 
+	hal.CNT_cycle[0] = CYC;
+	hal.CNT_cycle[1] = (CYC < hal.CNT_cycle[1]) ? CYC : hal.CNT_cycle[1];
+	hal.CNT_cycle[2] = (CYC > hal.CNT_cycle[2]) ? CYC : hal.CNT_cycle[2];
+
 	hal.CNT_raw[2] = (hal.CNT_raw[2] - hal.CNT_raw[1]) & 0xFFFFU;
 	hal.CNT_raw[3] = (hal.CNT_raw[3] - hal.CNT_raw[1]) & 0xFFFFU;
 
@@ -79,6 +89,13 @@ void irq_EXTI0()
 	hal.CNT_diag[2] = hal.CNT_diag[0] + (float) hal.CNT_raw[3] * hal.const_CNT[1];
 }
 
+void irq_EXTI1()
+{
+	EXTI->PR = EXTI_PR_PR1;
+
+	ADC_IRQ_DEFER();
+}
+
 static void
 ADC_set_SMPR(ADC_TypeDef *pADC, int xCH, int xSMP)
 {
@@ -320,14 +337,24 @@ void ADC_startup()
 
 	/* Enable EXTI0.
 	 * */
-	EXTI->IMR = EXTI_IMR_MR0;
+	EXTI->IMR = EXTI_IMR_MR0 | EXTI_IMR_MR1;
 
 	/* Enable IRQs.
 	 * */
 	NVIC_SetPriority(ADC_IRQn, 0);
 	NVIC_SetPriority(EXTI0_IRQn, 1);
+	NVIC_SetPriority(EXTI1_IRQn, 11);
 	NVIC_EnableIRQ(ADC_IRQn);
 	NVIC_EnableIRQ(EXTI0_IRQn);
+	NVIC_EnableIRQ(EXTI1_IRQn);
+}
+
+void ADC_defer()
+{
+	/* EXTI0 is above the kernel priority so we cannot call FreeRTOS
+	 * from there. Low priority EXTI1 does it instead.
+	 * */
+	EXTI->SWIER = EXTI_SWIER_SWIER1;
 }
 
 float ADC_analog_sample(int xGPIO)
@@ -19,7 +19,10 @@ void ADC_startup();
 
 float ADC_analog_sample(int xGPIO);
 
+void ADC_defer();
+
 extern void ADC_IRQ();
+extern void ADC_IRQ_DEFER();
 
 #endif /* _H_ADC_ */
 
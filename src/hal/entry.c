@@ -10,6 +10,9 @@ extern uint32_t ld_text_end;
 extern uint32_t ld_ramfunc_load;
 extern uint32_t ld_ramfunc_begin;
 extern uint32_t ld_ramfunc_end;
+extern uint32_t ld_ramcore_load;
+extern uint32_t ld_ramcore_begin;
+extern uint32_t ld_ramcore_end;
 extern uint32_t ld_data_load;
 extern uint32_t ld_data_begin;
 extern uint32_t ld_data_end;
@@ -33,6 +36,7 @@ void irq_SysTick();
 void irq_Weak() { irq_Default(); };
 
 void irq_EXTI0() LD_IRQ_WEAK;
+void irq_EXTI1() LD_IRQ_WEAK;
 void irq_ADC() LD_IRQ_WEAK;
 void irq_CAN1_TX() LD_IRQ_WEAK;
 void irq_CAN1_RX0() LD_IRQ_WEAK;
@@ -83,7 +87,7 @@ LD_VTABLE void *vtab[] = {
 	irq_Default,
 	irq_Default,
 	irq_EXTI0,
-	irq_Default,
+	irq_EXTI1,
 	irq_Default,
 	irq_Default,
 	irq_Default,
@@ -177,6 +181,7 @@ LD_IRQ void irq_Reset()
 	hal_bootload();
 
 	init_data(&ld_ramfunc_load, &ld_ramfunc_begin, &ld_ramfunc_end);
+	init_data(&ld_ramcore_load, &ld_ramcore_begin, &ld_ramcore_end);
 	init_data(&ld_data_load, &ld_data_begin, &ld_data_end);
 
 	init_bss(&ld_bss_begin, &ld_bss_end);
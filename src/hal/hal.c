@@ -9,6 +9,7 @@
 #define HAL_LOG_INC(np)		(((np) < sizeof(log.text) - 1U) ? (np) + 1 : 0)
 
 uint32_t			clock_cpu_hz;
+const volatile uint32_t		*clock_CYCCNT;
 
 HAL_t				hal;
 LOG_t				log		LD_NOINIT;
@@ -311,6 +312,21 @@ periph_startup()
 	 * */
 	RCC->AHB1ENR |= RCC_AHB1ENR_DMA2EN;
 
+	/* Enable DWT cycle counter.
+	 * */
+	CoreDebug->DEMCR |= CoreDebug_DEMCR_TRCENA_Msk;
+
+#ifdef STM32F7
+	DWT->LAR = 0xC5ACCE55U;
+#endif /* STM32F7 */
+
+	DWT->CYCCNT = 0U;
+	DWT->CTRL |= DWT_CTRL_CYCCNTENA_Msk;
+
+	clock_CYCCNT = &DWT->CYCCNT;
+
+	hal.CNT_cycle[1] = 0xFFFFFFFFU;
+
 	/* Check for reset reason.
 	 * */
 #if defined(STM32F4)
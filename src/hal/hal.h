@@ -33,6 +33,12 @@
 #define LD_RAMFUNC			__attribute__ ((section(".ramfunc")))	\
 					__attribute__ ((noinline, used))
 
+#ifdef _HW_RAMFUNC
+#define LD_RAMCORE			__attribute__ ((section(".ramcore")))
+#else /* _HW_RAMFUNC */
+#define LD_RAMCORE
+#endif /* _HW_RAMFUNC */
+
 #define LD_CCRAM			__attribute__ ((section(".ccram")))
 #define LD_NOINIT			__attribute__ ((section(".noinit")))
 #define LD_DMA				__attribute__ ((aligned(32)))
@@ -181,6 +187,10 @@ typedef struct {
 	uint32_t	CNT_raw[4];
 	float		CNT_diag[3];
 
+	/* Last, minimal and maximal ISR duration in CPU cycles.
+	 * */
+	uint32_t	CNT_cycle[3];
+
 	struct {
 
 		float		GA;
@@ -213,6 +223,7 @@ extern const fw_info_t		fw;
 
 extern uint32_t			ld_text_begin;
 extern uint32_t			clock_cpu_hz;
+extern const volatile uint32_t	*clock_CYCCNT;
 
 extern HAL_t			hal;
 extern LOG_t			log;
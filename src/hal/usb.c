@@ -12,6 +12,12 @@
 #define CDC_OUT_EP		0x02U
 #define CDC_INT_EP		0x83U
 
+/* Number of bulk blocks that can be queued to IN endpoint. Each block is
+ * limited by 10-bit packet count of OTG endpoint.
+ * */
+#define CDC_BULK_MAX		4U
+#define CDC_BULK_SZ		(1023U * CDC_DATA_SZ)
+
 #define USBD_VID		0x0483	/* STMicroelectronics */
 #define USBD_PID		0x5740	/* Virtual COM Port */
 
@@ -29,7 +35,18 @@ typedef struct {
 	LD_DMA uint8_t		tx_buf[CDC_DATA_SZ];
 
 	int			rx_flag;
-	int			tx_flag;
+	volatile int		tx_flag;
+
+	/* Bulk blocks are sent directly from the caller memory after
+	 * the text queue is drained.
+	 * */
+	const uint8_t		*bulk_data[CDC_BULK_MAX];
+	int			bulk_len[CDC_BULK_MAX];
+
+	volatile int		bulk_flag;
+	volatile int		bulk_abort;
+	volatile uint32_t	bulk_head;
+	volatile uint32_t	bulk_tail;
 }
 priv_USB_t;
 
@@ -91,6 +108,17 @@ void usbd_event_handler(uint8_t event)
 			usbd_ep_start_read(CDC_OUT_EP, priv_USB.rx_buf, CDC_DATA_SZ);
 			break;
 
+		case USBD_EVENT_RESET:
+		case USBD_EVENT_DISCONNECTED:
+
+			/* Drop bulk blocks and tell the writer that host
+			 * is gone so it does not continue in new session.
+			 * */
+			priv_USB.bulk_flag = 0;
+			priv_USB.bulk_abort = 1;
+			priv_USB.bulk_tail = priv_USB.bulk_head;
+			break;
+
 		default:
 			break;
 	}
@@ -125,12 +153,30 @@ usbd_cdc_acm_bulk_out(uint8_t ep, uint32_t nbytes)
 	portYIELD_FROM_ISR(xWoken);
 }
 
+static void
+usbd_cdc_acm_bulk_start()
+{
+	int		N = priv_USB.bulk_tail % CDC_BULK_MAX;
+
+	priv_USB.bulk_flag = 1;
+
+	usbd_ep_start_write(CDC_IN_EP, priv_USB.bulk_data[N], priv_USB.bulk_len[N]);
+}
+
 static void
 usbd_cdc_acm_bulk_in(uint8_t ep, uint32_t nbytes)
 {
 	BaseType_t		xWoken = pdFALSE;
 	int			len = 0;
 
+	if (priv_USB.bulk_flag != 0) {
+
+		/* Bulk block is out so we release the caller memory.
+		 * */
+		priv_USB.bulk_flag = 0;
+		priv_USB.bulk_tail++;
+	}
+
 	while (		len < CDC_DATA_SZ
 			&& xQueueReceiveFromISR(priv_USB.tx_queue,
 				&priv_USB.tx_buf[len], &xWoken) == pdTRUE) {
@@ -141,7 +187,11 @@ usbd_cdc_acm_bulk_in(uint8_t ep, uint32_t nbytes)
 
 		usbd_ep_start_write(CDC_IN_EP, priv_USB.tx_buf, len);
 	}
-	else if (nbytes == CDC_DATA_SZ) {
+	else if (priv_USB.bulk_tail != priv_USB.bulk_head) {
+
+		usbd_cdc_acm_bulk_start();
+	}
+	else if (nbytes != 0 && nbytes % CDC_DATA_SZ == 0) {
 
 		usbd_ep_start_write(CDC_IN_EP, NULL, 0);
 	}
@@ -182,18 +232,31 @@ LD_TASK void task_USB_IN(void *pData)
 
 		if (priv_USB.tx_flag == 0) {
 
-			int	len = 0;
+			int	len = 0, claim;
 
-			while (		len < CDC_DATA_SZ
-					&& xQueueReceive(priv_USB.tx_queue,
-						&priv_USB.tx_buf[len],
-						(TickType_t) 10) == pdTRUE) {
-				len++;
-			}
+			/* Claim the endpoint before we take the text so
+			 * that bulk block cannot go ahead of it.
+			 * */
+			taskENTER_CRITICAL();
 
-			if (len > 0) {
+			claim = (	   priv_USB.tx_flag == 0
+					&& uxQueueMessagesWaiting(priv_USB.tx_queue) != 0) ? 1 : 0;
+
+			if (claim != 0) {
 
 				priv_USB.tx_flag = 1;
+			}
+
+			taskEXIT_CRITICAL();
+
+			if (claim != 0) {
+
+				while (		len < CDC_DATA_SZ
+						&& xQueueReceive(priv_USB.tx_queue,
+							&priv_USB.tx_buf[len],
+							(TickType_t) 10) == pdTRUE) {
+					len++;
+				}
 
 				usbd_ep_start_write(CDC_IN_EP, priv_USB.tx_buf, len);
 			}
@@ -274,3 +337,70 @@ void USB_putc(int c)
 	GPIO_set_LOW(GPIO_LED_ALERT);
 }
 
+void USB_bulk_open()
+{
+	taskENTER_CRITICAL();
+
+	priv_USB.bulk_abort = 0;
+	priv_USB.bulk_tail = priv_USB.bulk_head;
+
+	taskEXIT_CRITICAL();
+}
+
+int USB_bulk_write(const void *data, int len)
+{
+	int		N;
+
+	while (len > 0) {
+
+		if (USB_bulk_wait((int) CDC_BULK_MAX - 1) != HAL_OK)
+			return HAL_FAULT;
+
+		N = priv_USB.bulk_head % CDC_BULK_MAX;
+
+		priv_USB.bulk_data[N] = (const uint8_t *) data;
+		priv_USB.bulk_len[N] = (len < (int) CDC_BULK_SZ) ? len : (int) CDC_BULK_SZ;
+
+		hal_memory_fence();
+
+		taskENTER_CRITICAL();
+
+		if (priv_USB.bulk_abort == 0) {
+
+			priv_USB.bulk_head++;
+
+			if (		   priv_USB.tx_flag == 0
+					&& uxQueueMessagesWaiting(priv_USB.tx_queue) == 0) {
+
+				/* Endpoint is idle so we start at once instead
+				 * of waiting for USB_IN task.
+				 * */
+				priv_USB.tx_flag = 1;
+
+				usbd_cdc_acm_bulk_start();
+			}
+		}
+
+		taskEXIT_CRITICAL();
+
+		if (priv_USB.bulk_abort != 0)
+			return HAL_FAULT;
+
+		data = (const uint8_t *) data + priv_USB.bulk_len[N];
+		len -= priv_USB.bulk_len[N];
+	}
+
+	return HAL_OK;
+}
+
+int USB_bulk_wait(int depth)
+{
+	while (		   priv_USB.bulk_abort == 0
+			&& (int) (priv_USB.bulk_head - priv_USB.bulk_tail) > depth) {
+
+		vTaskDelay((TickType_t) 1);
+	}
+
+	return (priv_USB.bulk_abort == 0) ? HAL_OK : HAL_FAULT;
+}
+
@@ -4,5 +4,14 @@
 void USB_startup();
 void USB_putc(int c);
 
+/* Bulk block is sent after the text that is already queued. The caller
+ * memory must be kept until the block is out and no text is to be
+ * queued until USB_bulk_wait(0) returns. Both return HAL_FAULT after
+ * USB reset or disconnect until the next USB_bulk_open().
+ * */
+void USB_bulk_open();
+int USB_bulk_write(const void *data, int len);
+int USB_bulk_wait(int depth);
+
 #endif /* _H_USB_ */
 
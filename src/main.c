@@ -20,6 +20,8 @@ tlm_t				tlm;
 
 uint8_t				ucHeap[configTOTAL_HEAP_SIZE] LD_CCRAM;
 
+static SemaphoreHandle_t	xDEFER;
+
 void xvprintf(io_ops_t *_io, const char *fmt, va_list ap);
 
 void log_TRACE(const char *fmt, ...)
@@ -583,6 +585,28 @@ LD_TASK void task_ANG_KNOB(void *pData)
 }
 #endif /* HW_HAVE_ANALOG_KNOB */
 
+void ADC_IRQ_DEFER()
+{
+	BaseType_t		xWoken = pdFALSE;
+
+	xSemaphoreGiveFromISR(xDEFER, &xWoken);
+
+	portYIELD_FROM_ISR(xWoken);
+}
+
+LD_TASK void task_PM_DEFER(void *pData)
+{
+	do {
+		/* Do the heavy probe math that PMC has handed over from ISR.
+		 * */
+		if (xSemaphoreTake(xDEFER, portMAX_DELAY) == pdTRUE) {
+
+			pm_defer(&pm);
+		}
+	}
+	while (1);
+}
+
 static void
 default_flash_load()
 {
@@ -773,6 +797,8 @@ default_flash_load()
 	pm.dc_resolution = hal.PWM_resolution;
 	pm.proc_set_DC = &PWM_set_DC;
 	pm.proc_set_Z = &PWM_set_Z;
+	pm.proc_defer = &ADC_defer;
+	pm.prof_CYCCNT = clock_CYCCNT;
 
 	/* Default PMC configuration.
 	 * */
@@ -897,6 +923,14 @@ LD_TASK void task_INIT(void *pData)
 	GPIO_set_LOW(GPIO_FAN_EN);
 #endif /* HW_HAVE_FAN_CONTROL */
 
+	xDEFER = xSemaphoreCreateBinary();
+
+	/* Worker runs LSE solver, eigenvalue and Kalman schedule math so it
+	 * needs more stack than default. Check its free stack by ap_dbg_task
+	 * after impedance probe and schedule build.
+	 * */
+	xTaskCreate(task_PM_DEFER, "PM_DEFER", configHUGE_STACK_SIZE, NULL, 3, NULL);
+
 	hal_lock_irq();
 
 	/* Do CORE startup.
@@ -1137,10 +1171,12 @@ in_STEP_DIR()
 }
 #endif /* HW_HAVE_STEP_DIR_KNOB */
 
-void ADC_IRQ()
+LD_RAMCORE void ADC_IRQ()
 {
 	pmfb_t		fb;
 
+	pm_prof_start(&pm);
+
 	fb.current_A = hal.ADC_current_A;
 	fb.current_B = hal.ADC_current_B;
 	fb.current_C = hal.ADC_current_C;
@@ -1209,14 +1245,24 @@ void ADC_IRQ()
 	}
 #endif /* HW_HAVE_PWM_STOP */
 
+	pm_prof_enter(&pm, PM_PROF_TLM);
+
+	tlm_fb_record(&tlm, &fb);
+
 	pm_feedback(&pm, &fb);
 
 #ifdef HW_HAVE_NETWORK_EPCAN
+	pm_prof_enter(&pm, PM_PROF_EPCAN);
+
 	EPCAN_pipe_PERIODIC();
 #endif /* HW_HAVE_NETWORK_EPCAN */
 
+	pm_prof_enter(&pm, PM_PROF_TLM);
+
 	tlm_reg_grab(&tlm);
 
+	pm_prof_finish(&pm);
+
 	WD_kick();
 }
 
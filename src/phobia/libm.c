@@ -2,7 +2,7 @@
 
 #include "libm.h"
 
-int m_isfinitef(float x)
+LD_RAMCORE int m_isfinitef(float x)
 {
 	union {
 		float		f;
@@ -13,7 +13,7 @@ int m_isfinitef(float x)
 	return ((0xFFU & (u.i >> 23)) != 0xFFU) ? 1 : 0;
 }
 
-float m_fast_recipf(float x)
+LD_RAMCORE float m_fast_recipf(float x)
 {
 	union {
 		float		f;
@@ -26,7 +26,7 @@ float m_fast_recipf(float x)
 	return u.f;
 }
 
-float m_fast_rsqrtf(float x)
+LD_RAMCORE float m_fast_rsqrtf(float x)
 {
 	union {
 		float		f;
@@ -39,7 +39,7 @@ float m_fast_rsqrtf(float x)
 	return u.f;
 }
 
-float m_approx_rsqrtf(float x)
+LD_RAMCORE float m_approx_rsqrtf(float x)
 {
 	float		q;
 
@@ -52,12 +52,12 @@ float m_approx_rsqrtf(float x)
 	return q;
 }
 
-float m_hypotf(float x, float y)
+LD_RAMCORE float m_hypotf(float x, float y)
 {
 	return m_sqrtf(x * x + y * y);
 }
 
-void m_rotatef(float x[2], float r)
+LD_RAMCORE void m_rotatef(float x[2], float r)
 {
 	float           q, s, c;
 
@@ -73,7 +73,7 @@ void m_rotatef(float x[2], float r)
 	x[0] = q;
 }
 
-void m_normalizef(float x[2])
+LD_RAMCORE void m_normalizef(float x[2])
 {
 	float		l;
 
@@ -94,7 +94,7 @@ void m_normalizef(float x[2])
 	x[1] *= l;
 }
 
-void m_rsumf(float *sum, float *rem, float x)
+LD_RAMCORE void m_rsumf(float *sum, float *rem, float x)
 {
 	float		y, m;
 
@@ -111,7 +111,7 @@ void m_rsumf(float *sum, float *rem, float x)
 	*sum = m;
 }
 
-static float
+LD_RAMCORE static float
 m_atanf(float x)
 {
 	static const float	lt_atanf[] = {
@@ -140,7 +140,7 @@ m_atanf(float x)
 	return u * x;
 }
 
-float m_atan2f(float y, float x)
+LD_RAMCORE float m_atan2f(float y, float x)
 {
 	float		u;
 
@@ -157,7 +157,7 @@ float m_atan2f(float y, float x)
 	return u;
 }
 
-static float
+LD_RAMCORE static float
 m_sincosf(float x)
 {
 	static const float	lt_sincosf[] = {
@@ -182,7 +182,7 @@ m_sincosf(float x)
 	return u * x;
 }
 
-float m_sinf(float x)
+LD_RAMCORE float m_sinf(float x)
 {
 	float           y, u;
 
@@ -198,7 +198,7 @@ float m_sinf(float x)
 	return u;
 }
 
-float m_cosf(float x)
+LD_RAMCORE float m_cosf(float x)
 {
         float           u;
 
@@ -371,7 +371,7 @@ void m_la_eigf(const float a[3], float v[4], int m)
 	}
 }
 
-static uint32_t
+LD_RAMCORE static uint32_t
 m_lf_lcgu(uint32_t rseed)
 {
 	return rseed * 17317U + 1U;
@@ -391,7 +391,7 @@ void m_lf_randseed(lfseed_t *lf, int seed)
 	lf->nb = 0;
 }
 
-float m_lf_urandf(lfseed_t *lf)
+LD_RAMCORE float m_lf_urandf(lfseed_t *lf)
 {
 	float		y, a, b;
 	int		n, k;
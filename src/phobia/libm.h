@@ -15,6 +15,14 @@
 #define unlikely(x)		__builtin_expect(!!(x), 0)
 #endif
 
+#ifndef LD_RAMCORE
+#ifdef _HW_RAMFUNC
+#define LD_RAMCORE		__attribute__ ((section(".ramcore")))
+#else /* _HW_RAMFUNC */
+#define LD_RAMCORE
+#endif /* _HW_RAMFUNC */
+#endif
+
 static inline float m_fabsf(float x) { return __builtin_fabsf(x); }
 static inline float m_sqrtf(float x) { return __builtin_sqrtf(x); }
 
@@ -1,6 +1,19 @@
+#ifdef PM_SPEC
+/* We are compiled as specialized variant of pm_feedback(), so public symbols
+ * of the control code are renamed. Configuration that variant is
+ * specialized for is given by PM_CONFIG_* macros.
+ * */
+#define pm_prof_enter		PM_SPEC(pm_prof_enter)
+#define pm_prof_leave		PM_SPEC(pm_prof_leave)
+#define pm_clearance		PM_SPEC(pm_clearance)
+#define pm_voltage		PM_SPEC(pm_voltage)
+#define pm_feedback		PM_SPEC(pm_feedback)
+#endif /* PM_SPEC */
+
 #include "libm.h"
 #include "pm.h"
 
+#ifndef PM_SPEC
 void pm_lazy_build(pmc_t *pm)
 {
 	if (PM_CONFIG_NOP(pm) == PM_NOP_THREE_PHASE) {
@@ -25,6 +38,11 @@ void pm_lazy_build(pmc_t *pm)
 	pm->ts_threshold = (int) (pm->m_freq * pm->dc_threshold * 0.000001f + 0.5f);
 	pm->ts_inverted = 1.f / (float) pm->dc_resolution;
 
+	/* Slow tier runs at decimated rate so its gains are scaled.
+	 * */
+	pm->lazy_sK = (pm->m_decimate > 1) ? (float) pm->m_decimate : 1.f;
+	pm->lazy_sT = pm->m_dT * pm->lazy_sK;
+
 	if (pm->const_lambda > M_EPSILON) {
 
 		pm->lazy_Wb2 = pm->const_lambda * pm->const_lambda;
@@ -56,6 +74,15 @@ void pm_lazy_build(pmc_t *pm)
 		pm->lazy_TiLu[3] = pm->m_dT * (1.f - Lq * pm->lazy_iLd);
 	}
 
+	pm->mtpa_table_kQ = 0.f;
+
+	if (		pm->config_RELUCTANCE == PM_ENABLED
+			&& pm->config_MTPA_TABLE == PM_ENABLED
+			&& m_fabsf(pm->lazy_Lrel) > M_EPSILON) {
+
+		pm_mtpa_table(pm);
+	}
+
 	if (pm->config_HFI_WAVETYPE != PM_HFI_NONE) {
 
 		pm->lazy_HFwS = M_2_PI_F * pm->hfi_freq;
@@ -80,6 +107,44 @@ void pm_lazy_build(pmc_t *pm)
 
 		pm->lazy_ZiSQ = Zf / Zq;
 	}
+
+	/* Select the specialized variant of pm_feedback() if there is one
+	 * for the actual configuration.
+	 * */
+	pm->lazy_FEEDBACK = PM_FEEDBACK_GENERIC;
+
+#ifndef _HW_RAMFUNC
+	/* Variants are not built when the control code runs from RAM as
+	 * there is no room to keep them all.
+	 * */
+	if (		   pm->config_NOP == PM_NOP_THREE_PHASE
+			&& pm->config_LU_SENSOR == PM_SENSOR_NONE
+			&& pm->config_HFI_WAVETYPE == PM_HFI_NONE) {
+
+		if (pm->config_LU_ESTIMATE == PM_FLUX_ORTEGA) {
+
+			if (pm->config_LU_DRIVE == PM_DRIVE_SPEED) {
+
+				pm->lazy_FEEDBACK = PM_FEEDBACK_ORTEGA_SPEED;
+			}
+			else if (pm->config_LU_DRIVE == PM_DRIVE_CURRENT) {
+
+				pm->lazy_FEEDBACK = PM_FEEDBACK_ORTEGA_CURRENT;
+			}
+		}
+		else if (pm->config_LU_ESTIMATE == PM_FLUX_KALMAN) {
+
+			if (pm->config_LU_DRIVE == PM_DRIVE_SPEED) {
+
+				pm->lazy_FEEDBACK = PM_FEEDBACK_KALMAN_SPEED;
+			}
+			else if (pm->config_LU_DRIVE == PM_DRIVE_CURRENT) {
+
+				pm->lazy_FEEDBACK = PM_FEEDBACK_KALMAN_CURRENT;
+			}
+		}
+	}
+#endif /* _HW_RAMFUNC */
 }
 
 static void
@@ -91,6 +156,8 @@ pm_auto_basic_default(pmc_t *pm)
 	pm->dc_bootstrap = 100.f;		/* (ms) */
 	pm->dc_threshold = 200.f;		/* (us) */
 
+	pm->m_decimate = 1;
+
 	pm->config_NOP = PM_NOP_THREE_PHASE;
 	pm->config_IFB = PM_IFB_ABC_INLINE;
 	pm->config_TVM = PM_ENABLED;
@@ -138,9 +205,11 @@ pm_auto_config_default(pmc_t *pm)
 	pm->config_EXCITATION = PM_MAGNET_PERMANENT;
 	pm->config_SALIENCY = PM_SALIENCY_NEGATIVE;
 	pm->config_RELUCTANCE = PM_DISABLED;
+	pm->config_MTPA_TABLE = PM_DISABLED;
 	pm->config_WEAKENING = PM_DISABLED;
 	pm->config_CC_BRAKE_STOP = PM_BRAKE_ON_REVERSE;
 	pm->config_CC_SPEED_TRACK = PM_ENABLED;
+	pm->config_CC_DEADBEAT = PM_DISABLED;
 	pm->config_EABI_FRONTEND = PM_EABI_INCREMENTAL;
 	pm->config_SINCOS_FRONTEND = PM_SINCOS_ANALOG;
 
@@ -157,6 +226,7 @@ pm_auto_config_default(pmc_t *pm)
 	pm->tm_pause_startup = 100.f;		/* (ms) */
 	pm->tm_pause_forced = 1000.f;		/* (ms) */
 	pm->tm_pause_on_halt = 2000.f;		/* (ms) */
+	pm->tm_schedule_build = 5000.f;		/* (ms) */
 
 	pm->scale_iA[0] = 0.f;
 	pm->scale_iA[1] = 1.f;
@@ -285,6 +355,7 @@ pm_auto_config_default(pmc_t *pm)
 	pm->i_damping = 1.f;
 	pm->i_gain_P = 2.e-1f;
 	pm->i_gain_I = 5.e-3f;
+	pm->i_gain_DB = 4.e-1f;
 
 	pm->mtpa_revstep = 50.f;		/* (A) */
 	pm->mtpa_gain_LP = 5.e-2f;
@@ -337,6 +408,8 @@ pm_auto_machine_default(pmc_t *pm)
 	pm->const_im_Ag = 0.f;
 	pm->const_im_Rz = 0.f;
 
+	pm->kalman_sched_wS = 0.f;
+
 	pm->i_slew_rate = 10000.f;
 	pm->i_gain_P = 2.e-1f;
 	pm->i_gain_I = 5.e-3f;
@@ -642,6 +715,21 @@ pm_auto_loop_speed(pmc_t *pm)
 	}
 }
 
+static void
+pm_auto_kalman_schedule(pmc_t *pm)
+{
+	/* We use observer state as scratch so the machine must be
+	 * stopped. Valid schedule is kept until machine constants are
+	 * changed.
+	 * */
+	if (		   pm->lu_MODE == PM_LU_DISABLED
+			&& pm->config_LU_ESTIMATE == PM_FLUX_KALMAN_SCHEDULED
+			&& pm->kalman_sched_wS < M_EPSILON) {
+
+		pm_kalman_schedule(pm);
+	}
+}
+
 void pm_auto(pmc_t *pm, int req)
 {
 	switch (req) {
@@ -690,12 +778,16 @@ void pm_auto(pmc_t *pm, int req)
 			pm_auto_loop_speed(pm);
 			break;
 
+		case PM_AUTO_KALMAN_SCHEDULE:
+			pm_auto_kalman_schedule(pm);
+			break;
+
 		default:
 			break;
 	}
 }
 
-float pm_torque_equation(pmc_t *pm, float iD, float iQ)
+LD_RAMCORE float pm_torque_equation(pmc_t *pm, float iD, float iQ)
 {
 	float		mQ, rel;
 
@@ -712,26 +804,59 @@ float pm_torque_equation(pmc_t *pm, float iD, float iQ)
 	return mQ;
 }
 
-float pm_torque_MTPA(pmc_t *pm, float iQ)
+LD_RAMCORE static float
+pm_mtpa_lookup(pmc_t *pm, const float *table, float iQ)
+{
+	float		x, u;
+	int		N;
+
+	x = m_fabsf(iQ) * pm->mtpa_table_kQ;
+
+	/* We extrapolate by the last segment beyond the grid.
+	 * */
+	N = (int) x;
+	N = (N < PM_MTPA_TABLE - 2) ? N : PM_MTPA_TABLE - 2;
+
+	u = x - (float) N;
+
+	return table[N] + (table[N + 1] - table[N]) * u;
+}
+
+LD_RAMCORE float pm_torque_MTPA(pmc_t *pm, float iQ)
 {
 	float		iD, bQ, bW;
 
-	bQ = pm->lazy_Lreq * (iQ * iQ);
-	bW = pm->lazy_Wb2;
+	if (pm->mtpa_table_kQ > M_EPSILON) {
 
-	iD = (m_sqrtf(16.f * bQ - 4.f * pm->const_lambda * m_sqrtf(4.f * bQ + bW)
-				+ 5.f * bW) - pm->const_lambda) * pm->lazy_iL4rel;
+		iD = pm_mtpa_lookup(pm, pm->mtpa_table_D, iQ);
+	}
+	else {
+		bQ = pm->lazy_Lreq * (iQ * iQ);
+		bW = pm->lazy_Wb2;
+
+		iD = (m_sqrtf(16.f * bQ - 4.f * pm->const_lambda * m_sqrtf(4.f * bQ + bW)
+					+ 5.f * bW) - pm->const_lambda) * pm->lazy_iL4rel;
+	}
 
 	return iD;
 }
 
-float pm_torque_maximal(pmc_t *pm, float iQ)
+LD_RAMCORE float pm_torque_maximal(pmc_t *pm, float iQ)
 {
 	float		mQ;
 
 	if (pm->config_RELUCTANCE == PM_ENABLED) {
 
-		mQ = pm_torque_equation(pm, pm_torque_MTPA(pm, iQ), iQ);
+		if (pm->mtpa_table_kQ > M_EPSILON) {
+
+			/* MTPA torque is odd against Q current.
+			 * */
+			mQ = pm_mtpa_lookup(pm, pm->mtpa_table_mQ, iQ);
+			mQ = (iQ < 0.f) ? - mQ : mQ;
+		}
+		else {
+			mQ = pm_torque_equation(pm, pm_torque_MTPA(pm, iQ), iQ);
+		}
 	}
 	else {
 		mQ = pm_torque_equation(pm, 0.f, iQ);
@@ -740,7 +865,110 @@ float pm_torque_maximal(pmc_t *pm, float iQ)
 	return mQ;
 }
 
-static float
+void pm_mtpa_table(pmc_t *pm)
+{
+	float		iMAX, iQ;
+	int		N;
+
+	/* MTPA solution is even against Q current so we tabulate the
+	 * positive half of the range.
+	 * */
+	iMAX = (pm->i_maximal > pm->i_reverse) ? pm->i_maximal : pm->i_reverse;
+
+	pm->mtpa_table_kQ = 0.f;
+
+	if (iMAX < M_EPSILON)
+		return ;
+
+	for (N = 0; N < PM_MTPA_TABLE; ++N) {
+
+		iQ = iMAX * (float) N / (float) (PM_MTPA_TABLE - 1);
+
+		pm->mtpa_table_D[N] = pm_torque_MTPA(pm, iQ);
+		pm->mtpa_table_mQ[N] = pm_torque_equation(pm, pm->mtpa_table_D[N], iQ);
+	}
+
+	pm->mtpa_table_kQ = (float) (PM_MTPA_TABLE - 1) / iMAX;
+}
+#endif /* PM_SPEC */
+
+LD_RAMCORE int pm_prof_enter(pmc_t *pm, int stage)
+{
+	int		prev = pm->prof_STAGE;
+
+	if (pm->prof_CYCCNT != NULL) {
+
+		uint32_t		clock = *pm->prof_CYCCNT;
+
+		/* We account exclusive time so the nested stage is not
+		 * counted twice.
+		 * */
+		pm->prof_acc[prev] += clock - pm->prof_mark;
+		pm->prof_mark = clock;
+	}
+
+	pm->prof_STAGE = stage;
+
+	return prev;
+}
+
+LD_RAMCORE void pm_prof_leave(pmc_t *pm, int stage)
+{
+	pm_prof_enter(pm, stage);
+}
+
+#ifndef PM_SPEC
+LD_RAMCORE void pm_prof_start(pmc_t *pm)
+{
+	if (pm->prof_CYCCNT != NULL) {
+
+		pm->prof_mark = *pm->prof_CYCCNT;
+	}
+
+	/* Window opens at ISR entry so the code around pm_feedback() is
+	 * counted in its own stages.
+	 * */
+	pm->prof_STAGE = PM_PROF_HAL;
+}
+
+LD_RAMCORE void pm_prof_finish(pmc_t *pm)
+{
+	uint32_t	cycles;
+	int		N, K;
+
+	pm_prof_enter(pm, PM_PROF_MAX);
+
+	if (pm->prof_CYCCNT == NULL)
+		return ;
+
+	for (N = 0; N < PM_PROF_MAX; ++N) {
+
+		cycles = pm->prof_acc[N];
+		pm->prof_acc[N] = 0U;
+
+		pm->prof_last[N] = (int) cycles;
+
+		if (cycles == 0U)
+			continue;
+
+		if (pm->prof_max[N] < (int) cycles) {
+
+			pm->prof_max[N] = (int) cycles;
+		}
+
+		/* Logarithmic histogram bin.
+		 * */
+		K = (31 - __builtin_clz(cycles)) - (PM_PROF_SHIFT - 1);
+		K = (K < 0) ? 0 : (K > PM_PROF_HIST - 1) ? PM_PROF_HIST - 1 : K;
+
+		pm->prof_hist[N][K] += 1;
+	}
+
+	pm->prof_acc[PM_PROF_MAX] = 0U;
+}
+#endif /* PM_SPEC */
+
+LD_RAMCORE static float
 pm_lu_current(pmc_t *pm, float mSP, float *Q)
 {
 	float		iQ, mQ, iQd, mQd;
@@ -748,10 +976,10 @@ pm_lu_current(pmc_t *pm, float mSP, float *Q)
 	if (pm->config_RELUCTANCE == PM_ENABLED) {
 
 		iQ = *Q;
-		mQ = pm_torque_equation(pm, pm_torque_MTPA(pm, iQ), iQ);
+		mQ = pm_torque_maximal(pm, iQ);
 
 		iQd = (mSP < mQ) ? iQ - pm->mtpa_revstep : iQ + pm->mtpa_revstep;
-		mQd = pm_torque_equation(pm, pm_torque_MTPA(pm, iQd), iQd);
+		mQd = pm_torque_maximal(pm, iQd);
 
 		iQ += (mSP - mQ) * (iQd - iQ) * m_fast_recipf(mQd - mQ);
 
@@ -773,7 +1001,7 @@ pm_lu_current(pmc_t *pm, float mSP, float *Q)
 	return iQ;
 }
 
-static float
+LD_RAMCORE static float
 pm_lu_accel(pmc_t *pm)
 {
 	float			mQ, tA = 0.f;
@@ -787,7 +1015,7 @@ pm_lu_accel(pmc_t *pm)
 	return tA;
 }
 
-static void
+LD_RAMCORE static void
 pm_forced(pmc_t *pm)
 {
 	float		wSP, dSA, xRF;
@@ -822,7 +1050,7 @@ pm_forced(pmc_t *pm)
 	m_normalizef(pm->forced_F);
 }
 
-static void
+LD_RAMCORE static void
 pm_flux_detached(pmc_t *pm)
 {
 	float		uA, uB, uC, uX, uY, U, A, B, blend;
@@ -902,7 +1130,7 @@ pm_flux_detached(pmc_t *pm)
 	}
 }
 
-static void
+LD_RAMCORE static void
 pm_flux_ortega(pmc_t *pm)
 {
 	float		uX, uY, lX, lY, fX, fY, E, A, B, blend;
@@ -1006,7 +1234,7 @@ pm_flux_ortega(pmc_t *pm)
 	}
 }
 
-static void
+LD_RAMCORE static void
 pm_kalman_equation(pmc_t *pm, float D[2])
 {
 	float		uD, uQ, R1, E1, fD, fQ;
@@ -1026,7 +1254,7 @@ pm_kalman_equation(pmc_t *pm, float D[2])
 	D[1] = (uQ - R1 * pm->flux_X[1] - fD * pm->flux_wS) * pm->lazy_iLq;
 }
 
-static void
+LD_RAMCORE static void
 pm_kalman_solve(pmc_t *pm)
 {
 	float		D0[2], D1[2];
@@ -1048,7 +1276,7 @@ pm_kalman_solve(pmc_t *pm)
 	pm->flux_X[1] += (D1[1] - D0[1]) * pm->m_dT * 0.5f;
 }
 
-static void
+LD_RAMCORE static void
 pm_kalman_forecast(pmc_t *pm)
 {
 	float		*P = pm->kalman_P;
@@ -1173,7 +1401,7 @@ pm_kalman_forecast(pmc_t *pm)
 	P[14] += Q[3] * pm->m_dT;
 }
 
-static void
+LD_RAMCORE static void
 pm_kalman_update(pmc_t *pm)
 {
 	float		*P = pm->kalman_P;
@@ -1263,7 +1491,151 @@ pm_kalman_update(pmc_t *pm)
 	K[8] += K[9] * u;
 }
 
-static void
+LD_RAMCORE static void
+pm_kalman_rotate(float Kr[10], const float K[10], float fC, float fS)
+{
+	float		u[4];
+
+	/* Transform the gains to the axes rotated by angle.
+	 *
+	 * Kr(0:3) = R(-th) * K(0:3) * R(th),
+	 * Kr(4:9) = K(4:9) * R(th).
+	 *
+	 * */
+	u[0] = K[0] * fC + K[1] * fS;
+	u[1] = K[1] * fC - K[0] * fS;
+	u[2] = K[2] * fC + K[3] * fS;
+	u[3] = K[3] * fC - K[2] * fS;
+
+	Kr[0] = fC * u[0] + fS * u[2];
+	Kr[1] = fC * u[1] + fS * u[3];
+	Kr[2] = fC * u[2] - fS * u[0];
+	Kr[3] = fC * u[3] - fS * u[1];
+
+	Kr[4] = K[4] * fC + K[5] * fS;
+	Kr[5] = K[5] * fC - K[4] * fS;
+	Kr[6] = K[6] * fC + K[7] * fS;
+	Kr[7] = K[7] * fC - K[6] * fS;
+	Kr[8] = K[8] * fC + K[9] * fS;
+	Kr[9] = K[9] * fC - K[8] * fS;
+}
+
+#ifndef PM_SPEC
+void pm_kalman_schedule(pmc_t *pm)
+{
+	float		*P = pm->kalman_P;
+	float		*A = pm->kalman_A;
+
+	float		F[2], wMAX, wS, uQ;
+	int		N, i;
+
+	if (pm->const_lambda > M_EPSILON) {
+
+		/* We take the speed range reachable with flux weakening.
+		 * */
+		wMAX = 2.f * pm->k_EMAX * pm->const_fb_U / pm->const_lambda;
+		wMAX = (wMAX < pm->m_freq) ? wMAX : pm->m_freq;
+	}
+	else {
+		wMAX = 0.1f * pm->m_freq;
+	}
+
+	for (N = 0; N < PM_KALMAN_SCHED; ++N) {
+
+		wS = wMAX * (float) (2 * N - (PM_KALMAN_SCHED - 1))
+			/ (float) (PM_KALMAN_SCHED - 1);
+
+		/* Machine rotates at constant speed with no load so the
+		 * covariance converges to steady state on DQ-axes.
+		 * */
+		uQ = wS * pm->const_lambda;
+
+		P[0] = 0.f;
+		P[1] = 0.f;
+		P[2] = 0.f;
+		P[3] = 0.f;
+		P[4] = 0.f;
+		P[5] = 1.f;
+		P[6] = 0.f;
+		P[7] = 0.f;
+		P[8] = 0.f;
+		P[9] = 1.f;
+		P[10] = 0.f;
+		P[11] = 0.f;
+		P[12] = 0.f;
+		P[13] = 0.f;
+		P[14] = 0.f;
+
+		F[0] = 1.f;
+		F[1] = 0.f;
+
+		for (i = 0; i < PM_KALMAN_ITER; ++i) {
+
+			A[0] = 0.f;
+			A[1] = 0.f;
+			A[2] = - F[1] * uQ;
+			A[3] = F[0] * uQ;
+			A[4] = F[0];
+			A[5] = F[1];
+			A[6] = wS;
+			A[7] = 0.f;
+
+			pm_kalman_forecast(pm);
+			pm_kalman_update(pm);
+
+			m_rotatef(F, wS * pm->m_dT);
+			m_normalizef(F);
+		}
+
+		pm_kalman_rotate(pm->kalman_sched_K[N], pm->kalman_K, F[0], F[1]);
+	}
+
+	/* Schedule is ready to use.
+	 * */
+	pm->kalman_sched_wS = wMAX;
+}
+#endif /* PM_SPEC */
+
+LD_RAMCORE static void
+pm_kalman_scheduled(pmc_t *pm, float K[10])
+{
+	const float	*K0, *K1;
+	float		Ku[10], x, u;
+	int		N;
+
+	/* Interpolate steady-state gains over the speed grid.
+	 * */
+	x = (pm->flux_wS / pm->kalman_sched_wS + 1.f)
+		* (float) (PM_KALMAN_SCHED - 1) * 0.5f;
+
+	x = (x < 0.f) ? 0.f : (x > (float) (PM_KALMAN_SCHED - 1))
+		? (float) (PM_KALMAN_SCHED - 1) : x;
+
+	N = (int) x;
+	N = (N < PM_KALMAN_SCHED - 2) ? N : PM_KALMAN_SCHED - 2;
+
+	u = x - (float) N;
+
+	K0 = pm->kalman_sched_K[N];
+	K1 = pm->kalman_sched_K[N + 1];
+
+	Ku[0] = K0[0] + (K1[0] - K0[0]) * u;
+	Ku[1] = K0[1] + (K1[1] - K0[1]) * u;
+	Ku[2] = K0[2] + (K1[2] - K0[2]) * u;
+	Ku[3] = K0[3] + (K1[3] - K0[3]) * u;
+	Ku[4] = K0[4] + (K1[4] - K0[4]) * u;
+	Ku[5] = K0[5] + (K1[5] - K0[5]) * u;
+	Ku[6] = K0[6] + (K1[6] - K0[6]) * u;
+	Ku[7] = K0[7] + (K1[7] - K0[7]) * u;
+	Ku[8] = K0[8] + (K1[8] - K0[8]) * u;
+	Ku[9] = K0[9] + (K1[9] - K0[9]) * u;
+
+	/* Get back to XY-axes.
+	 * */
+	pm_kalman_rotate(K, Ku, pm->flux_F[0], - pm->flux_F[1]);
+}
+
+LD_RAMCORE static void
 pm_kalman_lockout_guard(pmc_t *pm, float dA)
 {
 	/* Get speed LPF of actual DQ-axes.
@@ -1289,13 +1661,23 @@ pm_kalman_lockout_guard(pmc_t *pm, float dA)
 	}
 }
 
-static void
+LD_RAMCORE static void
 pm_flux_kalman(pmc_t *pm)
 {
 	const float		*K = pm->kalman_K;
 	float			*A = pm->kalman_A;
 
-	float			E[2], tA, dA = 0.f;
+	float			Ks[10], E[2], tA, dA = 0.f;
+	int			scheduled = PM_DISABLED;
+
+	if (		   PM_CONFIG_LU_ESTIMATE(pm) == PM_FLUX_KALMAN_SCHEDULED
+			&& pm->kalman_sched_wS > M_EPSILON) {
+
+		pm_kalman_scheduled(pm, Ks);
+
+		K = Ks;
+		scheduled = PM_ENABLED;
+	}
 
 	/* Get the current estimate in XY-axes.
 	 * */
@@ -1367,16 +1749,21 @@ pm_flux_kalman(pmc_t *pm)
 		pm->flux_wS += tA * pm->flux_gain_IF;
 	}
 
-	/* Set aside the variables to calculate covariance at the end of cycle.
-	 * */
-	A[2] = pm->vsi_X;
-	A[3] = pm->vsi_Y;
-	A[4] = pm->flux_F[0];
-	A[5] = pm->flux_F[1];
-	A[6] = pm->flux_wS;
-	A[7] = pm->kalman_bias_Q;
+	if (scheduled == PM_DISABLED) {
+
+		/* Set aside the variables to calculate covariance at the end
+		 * of cycle. We also get here in SCHEDULED mode until the
+		 * schedule is built as it was switched on the fly.
+		 * */
+		A[2] = pm->vsi_X;
+		A[3] = pm->vsi_Y;
+		A[4] = pm->flux_F[0];
+		A[5] = pm->flux_F[1];
+		A[6] = pm->flux_wS;
+		A[7] = pm->kalman_bias_Q;
 
-	pm->kalman_POSTPONED = PM_ENABLED;
+		pm->kalman_POSTPONED = PM_ENABLED;
+	}
 
 	/* We propagate the state estimates to the next cycle.
 	 * */
@@ -1387,14 +1774,22 @@ pm_flux_kalman(pmc_t *pm)
 	pm_kalman_lockout_guard(pm, dA);
 }
 
-static void
+LD_RAMCORE static void
 pm_flux_zone(pmc_t *pm)
 {
 	float			thld_wS;
 
+	if (pm->m_tick != 0) {
+
+		/* ZONE logic belongs to the slow tier.
+		 * */
+		return ;
+	}
+
 	/* Get speed LPF to detect operation ZONE.
 	 * */
-	pm->zone_lpf_wS += (pm->flux_wS - pm->zone_lpf_wS) * pm->zone_gain_LP;
+	pm->zone_lpf_wS += (pm->flux_wS - pm->zone_lpf_wS)
+		* pm->zone_gain_LP * pm->lazy_sK;
 
 	if (		   pm->flux_ZONE == PM_ZONE_NONE
 			|| pm->flux_ZONE == PM_ZONE_UNCERTAIN) {
@@ -1445,10 +1840,14 @@ pm_flux_zone(pmc_t *pm)
 	}
 }
 
-static void
+LD_RAMCORE static void
 pm_estimate(pmc_t *pm)
 {
-	if (pm->config_LU_ESTIMATE == PM_FLUX_ORTEGA) {
+	int		prof;
+
+	prof = pm_prof_enter(pm, PM_PROF_ESTIMATE);
+
+	if (PM_CONFIG_LU_ESTIMATE(pm) == PM_FLUX_ORTEGA) {
 
 		if (pm->flux_TYPE != PM_FLUX_ORTEGA) {
 
@@ -1466,7 +1865,8 @@ pm_estimate(pmc_t *pm)
 		pm_flux_ortega(pm);
 		pm_flux_zone(pm);
 	}
-	else if (pm->config_LU_ESTIMATE == PM_FLUX_KALMAN) {
+	else if (	   PM_CONFIG_LU_ESTIMATE(pm) == PM_FLUX_KALMAN
+			|| PM_CONFIG_LU_ESTIMATE(pm) == PM_FLUX_KALMAN_SCHEDULED) {
 
 		if (pm->flux_TYPE != PM_FLUX_KALMAN) {
 
@@ -1522,14 +1922,16 @@ pm_estimate(pmc_t *pm)
 			pm->flux_ZONE = PM_ZONE_NONE;
 		}
 	}
+
+	pm_prof_leave(pm, prof);
 }
 
-static float
+LD_RAMCORE static float
 pm_hfi_wave(pmc_t *pm)
 {
 	float		uHF, hCOS, hSIN;
 
-	if (pm->config_HFI_WAVETYPE == PM_HFI_SINE) {
+	if (PM_CONFIG_HFI_WAVETYPE(pm) == PM_HFI_SINE) {
 
 		const float	*HF = pm->lazy_HF;
 
@@ -1546,7 +1948,7 @@ pm_hfi_wave(pmc_t *pm)
 		uHF = pm->hfi_wave[0] * pm->hfi_amplitude
 			* pm->lazy_HFwS * pm->const_im_Ld;
 	}
-	else if (pm->config_HFI_WAVETYPE == PM_HFI_SILENT) {
+	else if (PM_CONFIG_HFI_WAVETYPE(pm) == PM_HFI_SILENT) {
 
 		/* HF non-audible wavetype.
 		 * */
@@ -1555,7 +1957,7 @@ pm_hfi_wave(pmc_t *pm)
 		uHF = pm->hfi_wave[0] * pm->hfi_amplitude
 			* pm->m_freq * pm->const_im_Ld;
 	}
-	else if (pm->config_HFI_WAVETYPE == PM_HFI_RANDOM) {
+	else if (PM_CONFIG_HFI_WAVETYPE(pm) == PM_HFI_RANDOM) {
 
 		/* HF random sequence.
 		 * */
@@ -1575,19 +1977,23 @@ pm_hfi_wave(pmc_t *pm)
 		 * */
 		pm->hfi_wave[0] = 0.f;
 		pm->hfi_wave[1] = 1.f;
+
+		uHF = 0.f;
 	}
 
 	return uHF;
 }
 
-static void
+LD_RAMCORE static void
 pm_sensor_hall(pmc_t *pm)
 {
 	float		F[2], A, B, blend, rel;
-	int		HS;
+	int		HS, prof;
 
 	const float	tol = 0.6f;		/* ~34 degrees */
 
+	prof = pm_prof_enter(pm, PM_PROF_SENSOR);
+
 	HS = pm->fb_HS;
 
 	if (likely(HS >= 1 && HS <= 6)) {
@@ -1636,16 +2042,20 @@ pm_sensor_hall(pmc_t *pm)
 			pm->fsm_req = PM_STATE_HALT;
 		}
 	}
+
+	pm_prof_leave(pm, prof);
 }
 
-static void
+LD_RAMCORE static void
 pm_sensor_eabi(pmc_t *pm)
 {
 	float		F[2], A, blend, ANG, rel;
-	int		relEP, WRAP;
+	int		relEP, WRAP, prof;
 
 	const float	tol = m_fabsf(pm->lazy_ZiEP) * 0.6f;
 
+	prof = pm_prof_enter(pm, PM_PROF_SENSOR);
+
 	if (pm->eabi_RECENT != PM_ENABLED) {
 
 		pm->eabi_bEP = pm->fb_EP;
@@ -1661,7 +2071,7 @@ pm_sensor_eabi(pmc_t *pm)
 			pm->eabi_lEP = pm->fb_EP;
 		}
 
-		if (pm->config_LU_SENSOR == PM_SENSOR_EABI) {
+		if (PM_CONFIG_LU_SENSOR(pm) == PM_SENSOR_EABI) {
 
 			pm->eabi_F[0] = pm->lu_F[0];
 			pm->eabi_F[1] = pm->lu_F[1];
@@ -1738,7 +2148,7 @@ pm_sensor_eabi(pmc_t *pm)
 
 	pm->eabi_interp += pm->eabi_wS * pm->m_dT;
 
-	if (pm->config_LU_SENSOR == PM_SENSOR_EABI) {
+	if (PM_CONFIG_LU_SENSOR(pm) == PM_SENSOR_EABI) {
 
 		/* Take the electrical position DQ-axes.
 		 * */
@@ -1767,15 +2177,19 @@ pm_sensor_eabi(pmc_t *pm)
 
 		pm->eabi_location = ANG * pm->lazy_ZiEP + pm->eabi_interp;
 	}
+
+	pm_prof_leave(pm, prof);
 }
 
-static void
+LD_RAMCORE static void
 pm_sensor_sincos(pmc_t *pm)
 {
 	float		*CONST = pm->sincos_CONST;
 
 	float		F[2], A, B, ANG, locAN;
-	int		WRAP;
+	int		WRAP, prof;
+
+	prof = pm_prof_enter(pm, PM_PROF_SENSOR);
 
 	if (pm->sincos_RECENT != PM_ENABLED) {
 
@@ -1784,7 +2198,7 @@ pm_sensor_sincos(pmc_t *pm)
 		pm->sincos_revol = 0;
 		pm->sincos_unwrap = 0;
 
-		if (pm->config_LU_SENSOR == PM_SENSOR_SINCOS) {
+		if (PM_CONFIG_LU_SENSOR(pm) == PM_SENSOR_SINCOS) {
 
 			pm->sincos_F[0] = pm->lu_F[0];
 			pm->sincos_F[1] = pm->lu_F[1];
@@ -1891,9 +2305,11 @@ pm_sensor_sincos(pmc_t *pm)
 		 * */
 		pm->sincos_location = locAN * pm->lazy_ZiSQ;
 	}
+
+	pm_prof_leave(pm, prof);
 }
 
-static void
+LD_RAMCORE static void
 pm_lu_FSM(pmc_t *pm)
 {
 	float			lu_F[2], hS, A, B;
@@ -1938,12 +2354,12 @@ pm_lu_FSM(pmc_t *pm)
 	}
 
 	if (		pm->config_LU_FORCED == PM_ENABLED
-			&& (	   pm->config_LU_DRIVE == PM_DRIVE_CURRENT
-				|| pm->config_LU_DRIVE == PM_DRIVE_TORQUE)) {
+			&& (	   PM_CONFIG_LU_DRIVE(pm) == PM_DRIVE_CURRENT
+				|| PM_CONFIG_LU_DRIVE(pm) == PM_DRIVE_TORQUE)) {
 
 		float		wSP, iQ;
 
-		iQ = (pm->config_LU_DRIVE == PM_DRIVE_CURRENT)
+		iQ = (PM_CONFIG_LU_DRIVE(pm) == PM_DRIVE_CURRENT)
 			? pm->i_setpoint_current : pm->i_setpoint_torque;
 
 		/* Derive the speed SETPOINT in case of current control.
@@ -2003,14 +2419,14 @@ pm_lu_FSM(pmc_t *pm)
 			 * */
 			pm->base_TIM++;
 		}
-		else if (	pm->config_LU_ESTIMATE != PM_FLUX_NONE
+		else if (	PM_CONFIG_LU_ESTIMATE(pm) != PM_FLUX_NONE
 				&& pm->flux_ZONE == PM_ZONE_HIGH) {
 
 			pm->lu_MODE = PM_LU_ESTIMATE;
 
 			pm->proc_set_Z(PM_Z_NONE);
 		}
-		else if (pm->config_LU_SENSOR == PM_SENSOR_HALL) {
+		else if (PM_CONFIG_LU_SENSOR(pm) == PM_SENSOR_HALL) {
 
 			pm->lu_MODE = PM_LU_SENSOR_HALL;
 
@@ -2021,7 +2437,7 @@ pm_lu_FSM(pmc_t *pm)
 
 			pm->proc_set_Z(PM_Z_NONE);
 		}
-		else if (	pm->config_LU_SENSOR == PM_SENSOR_EABI
+		else if (	PM_CONFIG_LU_SENSOR(pm) == PM_SENSOR_EABI
 				&& (	pm->eabi_ADJUST  == PM_ENABLED
 					|| pm->flux_ZONE == PM_ZONE_HIGH)) {
 
@@ -2029,7 +2445,7 @@ pm_lu_FSM(pmc_t *pm)
 
 			pm->proc_set_Z(PM_Z_NONE);
 		}
-		else if (pm->config_LU_SENSOR == PM_SENSOR_SINCOS) {
+		else if (PM_CONFIG_LU_SENSOR(pm) == PM_SENSOR_SINCOS) {
 
 			pm->lu_MODE = PM_LU_SENSOR_SINCOS;
 
@@ -2055,8 +2471,8 @@ pm_lu_FSM(pmc_t *pm)
 				pm->proc_set_Z(PM_Z_NONE);
 			}
 		}
-		else if (       pm->config_LU_ESTIMATE == PM_FLUX_KALMAN
-				&& pm->config_HFI_WAVETYPE != PM_HFI_NONE) {
+		else if (       PM_CONFIG_LU_ESTIMATE(pm) == PM_FLUX_KALMAN
+				&& PM_CONFIG_HFI_WAVETYPE(pm) != PM_HFI_NONE) {
 
 			pm->lu_MODE = PM_LU_ON_HFI;
 
@@ -2090,12 +2506,12 @@ pm_lu_FSM(pmc_t *pm)
 
 				pm->hold_TIM++;
 			}
-			else if (pm->config_LU_SENSOR == PM_SENSOR_EABI) {
+			else if (PM_CONFIG_LU_SENSOR(pm) == PM_SENSOR_EABI) {
 
 				pm->lu_MODE = PM_LU_SENSOR_EABI;
 			}
-			else if (	pm->config_LU_ESTIMATE == PM_FLUX_KALMAN
-					&& pm->config_HFI_WAVETYPE != PM_HFI_NONE) {
+			else if (	PM_CONFIG_LU_ESTIMATE(pm) == PM_FLUX_KALMAN
+					&& PM_CONFIG_HFI_WAVETYPE(pm) != PM_HFI_NONE) {
 
 				pm->lu_MODE = PM_LU_ON_HFI;
 			}
@@ -2132,7 +2548,7 @@ pm_lu_FSM(pmc_t *pm)
 		else if (	   pm->flux_ZONE == PM_ZONE_NONE
 				|| pm->flux_ZONE == PM_ZONE_UNCERTAIN) {
 
-			if (pm->config_LU_SENSOR == PM_SENSOR_HALL) {
+			if (PM_CONFIG_LU_SENSOR(pm) == PM_SENSOR_HALL) {
 
 				pm->lu_MODE = PM_LU_SENSOR_HALL;
 
@@ -2141,18 +2557,18 @@ pm_lu_FSM(pmc_t *pm)
 				pm->hall_F[1] = pm->lu_F[1];
 				pm->hall_wS = pm->lu_wS;
 			}
-			else if (	pm->config_LU_SENSOR == PM_SENSOR_EABI
+			else if (	PM_CONFIG_LU_SENSOR(pm) == PM_SENSOR_EABI
 					&& (	pm->eabi_ADJUST  == PM_ENABLED
 						|| pm->flux_ZONE == PM_ZONE_UNCERTAIN)) {
 
 				pm->lu_MODE = PM_LU_SENSOR_EABI;
 			}
-			else if (pm->config_LU_SENSOR == PM_SENSOR_SINCOS) {
+			else if (PM_CONFIG_LU_SENSOR(pm) == PM_SENSOR_SINCOS) {
 
 				pm->lu_MODE = PM_LU_SENSOR_SINCOS;
 			}
-			else if (	pm->config_LU_ESTIMATE == PM_FLUX_KALMAN
-					&& pm->config_HFI_WAVETYPE != PM_HFI_NONE) {
+			else if (	PM_CONFIG_LU_ESTIMATE(pm) == PM_FLUX_KALMAN
+					&& PM_CONFIG_HFI_WAVETYPE(pm) != PM_HFI_NONE) {
 
 				pm->lu_MODE = PM_LU_ON_HFI;
 
@@ -2204,7 +2620,7 @@ pm_lu_FSM(pmc_t *pm)
 		pm->lu_wS = pm->flux_wS;
 
 		if (		pm->flux_ZONE == PM_ZONE_HIGH
-				|| pm->config_HFI_WAVETYPE == PM_HFI_NONE) {
+				|| PM_CONFIG_HFI_WAVETYPE(pm) == PM_HFI_NONE) {
 
 			pm->lu_MODE = PM_LU_ESTIMATE;
 		}
@@ -2213,7 +2629,7 @@ pm_lu_FSM(pmc_t *pm)
 
 				pm->hold_TIM++;
 			}
-			else if (pm->config_LU_SENSOR == PM_SENSOR_EABI) {
+			else if (PM_CONFIG_LU_SENSOR(pm) == PM_SENSOR_EABI) {
 
 				pm->lu_MODE = PM_LU_SENSOR_EABI;
 			}
@@ -2397,7 +2813,7 @@ pm_lu_FSM(pmc_t *pm)
 	pm->lu_wS_prev = pm->lu_wS;
 }
 
-void pm_clearance(pmc_t *pm, int xA, int xB, int xC)
+LD_RAMCORE void pm_clearance(pmc_t *pm, int xA, int xB, int xC)
 {
 	int		xZONE, xSKIP, xTOP;
 
@@ -2461,10 +2877,12 @@ void pm_clearance(pmc_t *pm, int xA, int xB, int xC)
 	pm->vsi_C0 = xC;
 }
 
-void pm_voltage(pmc_t *pm, float uX, float uY)
+LD_RAMCORE void pm_voltage(pmc_t *pm, float uX, float uY)
 {
 	float		uA, uB, uC, uMIN, uMAX, uDC;
-	int		xA, xB, xC, xMIN, xMAX, nZONE;
+	int		xA, xB, xC, xMIN, xMAX, nZONE, prof;
+
+	prof = pm_prof_enter(pm, PM_PROF_VOLTAGE);
 
 	uX *= pm->lazy_iU;
 	uY *= pm->lazy_iU;
@@ -2801,10 +3219,12 @@ void pm_voltage(pmc_t *pm, float uX, float uY)
 	/* Update the clearance flags according to the new DC values.
 	 * */
 	pm_clearance(pm, xA, xB, xC);
+
+	pm_prof_leave(pm, prof);
 }
 
-static float
-pm_form_SP(pmc_t *pm, float eSP)
+LD_RAMCORE static float
+pm_form_SP(pmc_t *pm, float eSP, float sK)
 {
 	float		iSP;
 
@@ -2823,7 +3243,7 @@ pm_form_SP(pmc_t *pm, float eSP)
 	if (		(iSP < pm->i_maximal || eSP < 0.f)
 			&& (iSP > - pm->i_reverse || eSP > 0.f)) {
 
-		pm->s_integral += pm->s_gain_I * eSP;
+		pm->s_integral += pm->s_gain_I * sK * eSP;
 	}
 
 	/* Clamp the output in accordance with CURRENT constraints.
@@ -2834,7 +3254,7 @@ pm_form_SP(pmc_t *pm, float eSP)
 	return iSP;
 }
 
-static void
+LD_RAMCORE static void
 pm_wattage(pmc_t *pm)
 {
 	float		wP, TiH, Wh, Ah;
@@ -2843,7 +3263,7 @@ pm_wattage(pmc_t *pm)
 	 * */
 	wP = pm->k_KWAT * (pm->lu_iD * pm->lu_uD + pm->lu_iQ * pm->lu_uQ);
 
-	pm->watt_drain_wP += (wP - pm->watt_drain_wP) * pm->watt_gain_WF;
+	pm->watt_drain_wP += (wP - pm->watt_drain_wP) * pm->watt_gain_WF * pm->lazy_sK;
 	pm->watt_drain_wA = pm->watt_drain_wP * pm->lazy_iU;
 
 	/* Traveled distance.
@@ -2853,7 +3273,7 @@ pm_wattage(pmc_t *pm)
 
 	if (likely(m_isfinitef(pm->watt_drain_wA) != 0)) {
 
-		TiH = pm->m_dT * 0.00027777778f;
+		TiH = pm->lazy_sT * 0.00027777778f;
 
 		/* Get WATT per HOUR.
 		 * */
@@ -2885,11 +3305,14 @@ pm_wattage(pmc_t *pm)
 	}
 }
 
-static void
+LD_RAMCORE static void
 pm_loop_current(pmc_t *pm)
 {
 	float		track_D, track_Q, eD, eQ, uD, uQ, uX, uY, wP;
 	float		iMAX, iREV, uMAX, uREV, wMAX, wREV, dSA, dFA;
+	int		prof;
+
+	prof = pm_prof_enter(pm, PM_PROF_CURRENT);
 
 	if (pm->lu_MODE == PM_LU_FORCED) {
 
@@ -2929,8 +3352,8 @@ pm_loop_current(pmc_t *pm)
 	if (pm->lu_MODE == PM_LU_FORCED) {
 
 		if (		pm->config_CC_SPEED_TRACK == PM_ENABLED
-				&& (	   pm->config_LU_DRIVE == PM_DRIVE_CURRENT
-					|| pm->config_LU_DRIVE == PM_DRIVE_TORQUE)) {
+				&& (	   PM_CONFIG_LU_DRIVE(pm) == PM_DRIVE_CURRENT
+					|| PM_CONFIG_LU_DRIVE(pm) == PM_DRIVE_TORQUE)) {
 
 			pm->l_track = pm->lu_wS;
 		}
@@ -2938,10 +3361,10 @@ pm_loop_current(pmc_t *pm)
 	else {
 		track_Q = pm->i_setpoint_current;
 
-		if (		   pm->config_LU_DRIVE == PM_DRIVE_CURRENT
-				|| pm->config_LU_DRIVE == PM_DRIVE_TORQUE) {
+		if (		   PM_CONFIG_LU_DRIVE(pm) == PM_DRIVE_CURRENT
+				|| PM_CONFIG_LU_DRIVE(pm) == PM_DRIVE_TORQUE) {
 
-			if (pm->config_LU_DRIVE == PM_DRIVE_TORQUE) {
+			if (PM_CONFIG_LU_DRIVE(pm) == PM_DRIVE_TORQUE) {
 
 				/* Torque control.
 				 * */
@@ -2958,7 +3381,7 @@ pm_loop_current(pmc_t *pm)
 
 					/* Replace current setpoint by speed regulation.
 					 * */
-					track_Q = pm_form_SP(pm, 0.f - pm->lu_wS);
+					track_Q = pm_form_SP(pm, 0.f - pm->lu_wS, 1.f);
 					track_Q = (track_Q > iMAX) ? iMAX
 						: (track_Q < - iMAX) ? - iMAX : track_Q;
 				}
@@ -2969,7 +3392,7 @@ pm_loop_current(pmc_t *pm)
 
 					iMAX = m_fabsf(pm->i_setpoint_brake);
 
-					track_Q = pm_form_SP(pm, 0.f - pm->lu_wS);
+					track_Q = pm_form_SP(pm, 0.f - pm->lu_wS, 1.f);
 					track_Q = (track_Q > iMAX) ? iMAX
 						: (track_Q < - iMAX) ? - iMAX : track_Q;
 				}
@@ -2999,7 +3422,7 @@ pm_loop_current(pmc_t *pm)
 				/* Blend current setpoint with speed regulation.
 				 * */
 				pm->l_blend += (blend - pm->l_blend) * pm->l_gain_LP;
-				track_Q += (pm_form_SP(pm, eSP) - track_Q) * pm->l_blend;
+				track_Q += (pm_form_SP(pm, eSP, 1.f) - track_Q) * pm->l_blend;
 			}
 		}
 
@@ -3241,25 +3664,75 @@ pm_loop_current(pmc_t *pm)
 	pm->i_track_Q = (pm->i_track_Q < track_Q - dSA) ? pm->i_track_Q + dSA
 		: (pm->i_track_Q > track_Q + dSA) ? pm->i_track_Q - dSA : track_Q;
 
-	/* Obtain the discrepancy in DQ-axes.
-	 * */
-	eD = pm->i_track_D - pm->lu_iD;
-	eQ = pm->i_track_Q - pm->lu_iQ;
+	if (		pm->config_CC_DEADBEAT == PM_ENABLED
+			&& pm->const_im_Ld > M_EPSILON
+			&& pm->const_im_Lq > M_EPSILON) {
 
-	/* Basic proportional-integral regulator.
-	 * */
-	uD = pm->i_gain_P * eD + pm->i_integral_D;
-	uQ = pm->i_gain_P * eQ + pm->i_integral_Q;
+		float		iD, iQ, gD, gQ;
 
-	/* Feed forward compensation (R).
-	 * */
-	uD += pm->const_Rs * pm->i_track_D;
-	uQ += pm->const_Rs * pm->i_track_Q;
+		/* Predict the current at the end of cycle that is already
+		 * driven by the voltage from previous cycle.
+		 * */
+		iD = pm->lu_iD + pm->lazy_TiLd * (pm->lu_uD
+				- pm->const_Rs * pm->lu_iD
+				+ pm->lu_wS * pm->const_im_Lq * pm->lu_iQ);
 
-	/* Feed forward compensation (L).
-	 * */
-	uD += - pm->lu_wS * pm->const_im_Lq * pm->i_track_Q;
-	uQ += pm->lu_wS * (pm->const_im_Ld * pm->i_track_D + pm->const_lambda);
+		iQ = pm->lu_iQ + pm->lazy_TiLq * (pm->lu_uQ
+				- pm->const_Rs * pm->lu_iQ
+				- pm->lu_wS * (pm->const_im_Ld * pm->lu_iD
+					+ pm->const_lambda));
+
+		/* Obtain the predicted discrepancy in DQ-axes.
+		 * */
+		eD = pm->i_track_D - iD;
+		eQ = pm->i_track_Q - iQ;
+
+		gD = pm->i_gain_DB * pm->const_im_Ld * pm->m_freq;
+		gQ = pm->i_gain_DB * pm->const_im_Lq * pm->m_freq;
+
+		/* Deadbeat regulator places the voltage that brings the
+		 * current to the track point within one cycle.
+		 * */
+		uD = gD * eD + pm->i_integral_D;
+		uQ = gQ * eQ + pm->i_integral_Q;
+
+		/* Feed forward compensation (R).
+		 * */
+		uD += pm->const_Rs * (iD + eD * 0.5f);
+		uQ += pm->const_Rs * (iQ + eQ * 0.5f);
+
+		/* Feed forward compensation (L).
+		 * */
+		uD += - pm->lu_wS * pm->const_im_Lq * (iQ + eQ * 0.5f);
+		uQ += pm->lu_wS * (pm->const_im_Ld * (iD + eD * 0.5f)
+				+ pm->const_lambda);
+
+		/* Integral term only removes the model mismatch.
+		 * */
+		eD = pm->i_track_D - pm->lu_iD;
+		eQ = pm->i_track_Q - pm->lu_iQ;
+	}
+	else {
+		/* Obtain the discrepancy in DQ-axes.
+		 * */
+		eD = pm->i_track_D - pm->lu_iD;
+		eQ = pm->i_track_Q - pm->lu_iQ;
+
+		/* Basic proportional-integral regulator.
+		 * */
+		uD = pm->i_gain_P * eD + pm->i_integral_D;
+		uQ = pm->i_gain_P * eQ + pm->i_integral_Q;
+
+		/* Feed forward compensation (R).
+		 * */
+		uD += pm->const_Rs * pm->i_track_D;
+		uQ += pm->const_Rs * pm->i_track_Q;
+
+		/* Feed forward compensation (L).
+		 * */
+		uD += - pm->lu_wS * pm->const_im_Lq * pm->i_track_Q;
+		uQ += pm->lu_wS * (pm->const_im_Ld * pm->i_track_D + pm->const_lambda);
+	}
 
 	uMAX = pm->k_UMAX * pm->const_fb_U;
 
@@ -3301,9 +3774,11 @@ pm_loop_current(pmc_t *pm)
 	uY = pm->lu_F[1] * uD + pm->lu_F[0] * uQ;
 
 	pm_voltage(pm, uX, uY);
+
+	pm_prof_leave(pm, prof);
 }
 
-static void
+LD_RAMCORE static void
 pm_loop_speed(pmc_t *pm)
 {
 	float		wSP, eSP, dSA, dFA;
@@ -3320,10 +3795,10 @@ pm_loop_speed(pmc_t *pm)
 		pm->s_track = pm->forced_wS;
 	}
 	else {
-		if (pm->config_LU_DRIVE == PM_DRIVE_SPEED) {
+		if (PM_CONFIG_LU_DRIVE(pm) == PM_DRIVE_SPEED) {
 
-			dSA = pm->s_accel_forward * pm->m_dT;
-			dFA = pm->s_accel_reverse * pm->m_dT;
+			dSA = pm->s_accel_forward * pm->lazy_sT;
+			dFA = pm->s_accel_reverse * pm->lazy_sT;
 
 			/* Apply acceleration constraints.
 			 * */
@@ -3346,12 +3821,12 @@ pm_loop_speed(pmc_t *pm)
 
 			/* Update current loop SETPOINT.
 			 * */
-			pm->i_setpoint_current = pm_form_SP(pm, eSP);
+			pm->i_setpoint_current = pm_form_SP(pm, eSP, pm->lazy_sK);
 		}
 	}
 }
 
-static void
+LD_RAMCORE static void
 pm_loop_location(pmc_t *pm)
 {
 	float		xSP, wSP, eSP, eDS, weak, gain;
@@ -3361,7 +3836,7 @@ pm_loop_location(pmc_t *pm)
 
 	/* Move location setpoint in accordance with speed setpoint.
 	 * */
-	xSP += wSP * pm->m_dT;
+	xSP += wSP * pm->lazy_sT;
 
 	/* Allowed location range constraints.
 	 * */
@@ -3404,7 +3879,7 @@ pm_loop_location(pmc_t *pm)
 	pm->s_setpoint_speed = wSP;
 }
 
-static void
+LD_RAMCORE static void
 pm_dcu_voltage(pmc_t *pm)
 {
 	float		iA, iB, iC, uA, uB, uC, DTu;
@@ -3487,10 +3962,47 @@ pm_dcu_voltage(pmc_t *pm)
 	}
 }
 
-void pm_feedback(pmc_t *pm, pmfb_t *fb)
+#if !defined(PM_SPEC) && !defined(_HW_RAMFUNC)
+void pm_feedback_ortega_speed(pmc_t *pm, pmfb_t *fb);
+void pm_feedback_ortega_current(pmc_t *pm, pmfb_t *fb);
+void pm_feedback_kalman_speed(pmc_t *pm, pmfb_t *fb);
+void pm_feedback_kalman_current(pmc_t *pm, pmfb_t *fb);
+#endif /* PM_SPEC && _HW_RAMFUNC */
+
+LD_RAMCORE void pm_feedback(pmc_t *pm, pmfb_t *fb)
 {
 	float		iA, iB, Q;
 
+#if !defined(PM_SPEC) && !defined(_HW_RAMFUNC)
+	switch (pm->lazy_FEEDBACK) {
+
+		case PM_FEEDBACK_ORTEGA_SPEED:
+			pm_feedback_ortega_speed(pm, fb);
+			return ;
+
+		case PM_FEEDBACK_ORTEGA_CURRENT:
+			pm_feedback_ortega_current(pm, fb);
+			return ;
+
+		case PM_FEEDBACK_KALMAN_SPEED:
+			pm_feedback_kalman_speed(pm, fb);
+			return ;
+
+		case PM_FEEDBACK_KALMAN_CURRENT:
+			pm_feedback_kalman_current(pm, fb);
+			return ;
+
+		default:
+			break;
+	}
+#endif /* PM_SPEC && _HW_RAMFUNC */
+
+	pm_prof_enter(pm, PM_PROF_SCALE);
+
+	/* Slow tier is executed once per m_decimate cycles.
+	 * */
+	pm->m_tick = (pm->m_tick < pm->m_decimate - 1) ? pm->m_tick + 1 : 0;
+
 	if (likely(pm->vsi_AF == 0)) {
 
 		/* Get inline current A.
@@ -3662,6 +4174,8 @@ void pm_feedback(pmc_t *pm, pmfb_t *fb)
 
 	if (pm->lu_MODE != PM_LU_DISABLED) {
 
+		pm_prof_enter(pm, PM_PROF_OBSERVER);
+
 		/* The observer FSM.
 		 * */
 		pm_lu_FSM(pm);
@@ -3671,14 +4185,19 @@ void pm_feedback(pmc_t *pm, pmfb_t *fb)
 			pm_voltage(pm, pm->vsi_X, pm->vsi_Y);
 		}
 		else {
-			if (pm->config_LU_DRIVE == PM_DRIVE_SPEED) {
+			if (pm->m_tick == 0) {
 
-				pm_loop_speed(pm);
-			}
-			else if (pm->config_LU_DRIVE == PM_DRIVE_LOCATION) {
+				/* Slow tier of control loops.
+				 * */
+				if (PM_CONFIG_LU_DRIVE(pm) == PM_DRIVE_SPEED) {
+
+					pm_loop_speed(pm);
+				}
+				else if (PM_CONFIG_LU_DRIVE(pm) == PM_DRIVE_LOCATION) {
 
-				pm_loop_location(pm);
-				pm_loop_speed(pm);
+					pm_loop_location(pm);
+					pm_loop_speed(pm);
+				}
 			}
 
 			/* Current loop is always enabled.
@@ -3691,6 +4210,7 @@ void pm_feedback(pmc_t *pm, pmfb_t *fb)
 				 * values are output to the PWM. This allows
 				 * efficient use of CPU.
 				 * */
+				pm_prof_enter(pm, PM_PROF_ESTIMATE);
 				pm_kalman_forecast(pm);
 
 				if (likely(pm->vsi_IF == 0)) {
@@ -3699,11 +4219,16 @@ void pm_feedback(pmc_t *pm, pmfb_t *fb)
 				}
 
 				pm->kalman_POSTPONED = PM_DISABLED;
+
+				pm_prof_enter(pm, PM_PROF_OBSERVER);
 			}
 
-			/* Wattage information.
-			 * */
-			pm_wattage(pm);
+			if (pm->m_tick == 0) {
+
+				/* Wattage information.
+				 * */
+				pm_wattage(pm);
+			}
 		}
 
 		if (PM_CONFIG_DBG(pm) == PM_ENABLED) {
@@ -3717,6 +4242,8 @@ void pm_feedback(pmc_t *pm, pmfb_t *fb)
 		}
 	}
 
+	pm_prof_enter(pm, PM_PROF_FSM);
+
 	/* The FSM is used to execute assistive routines.
 	 * */
 	pm_FSM(pm);
@@ -1,13 +1,23 @@
 #ifndef _H_PM_
 #define _H_PM_
 
+#include <stddef.h>
+#include <stdint.h>
+
 #include "libm.h"
 #include "lse.h"
 
-#define PM_CONFIG_NOP(pm)	(pm)->config_NOP
-#define PM_CONFIG_IFB(pm)	(pm)->config_IFB
-#define PM_CONFIG_TVM(pm)	(pm)->config_TVM
-#define PM_CONFIG_DBG(pm)	(pm)->config_DBG
+#ifndef PM_SPEC
+#define PM_CONFIG_NOP(pm)		(pm)->config_NOP
+#define PM_CONFIG_LU_ESTIMATE(pm)	(pm)->config_LU_ESTIMATE
+#define PM_CONFIG_LU_SENSOR(pm)		(pm)->config_LU_SENSOR
+#define PM_CONFIG_LU_DRIVE(pm)		(pm)->config_LU_DRIVE
+#define PM_CONFIG_HFI_WAVETYPE(pm)	(pm)->config_HFI_WAVETYPE
+#endif /* PM_SPEC */
+
+#define PM_CONFIG_IFB(pm)		(pm)->config_IFB
+#define PM_CONFIG_TVM(pm)		(pm)->config_TVM
+#define PM_CONFIG_DBG(pm)		(pm)->config_DBG
 
 #define PM_TSMS(pm, ms)		(int) ((pm)->m_freq * (ms) * 0.001f)
 #define PM_DTNS(pm, ns)		((ns) * (pm)->m_freq * 0.000000001f)
@@ -15,6 +25,14 @@
 #define PM_MAX_F		1000000000000.f
 #define PM_SFI(s)		#s
 
+#define PM_PROF_HIST		8
+#define PM_PROF_SHIFT		7
+
+#define PM_KALMAN_SCHED		17
+#define PM_KALMAN_ITER		2000
+
+#define PM_MTPA_TABLE		17
+
 enum {
 	PM_Z_NONE				= 0,
 	PM_Z_A,
@@ -58,7 +76,8 @@ enum {
 enum {
 	PM_FLUX_NONE				= 0,
 	PM_FLUX_ORTEGA,
-	PM_FLUX_KALMAN
+	PM_FLUX_KALMAN,
+	PM_FLUX_KALMAN_SCHEDULED
 };
 
 enum {
@@ -163,7 +182,8 @@ enum {
 	PM_AUTO_FORCED_ACCEL,
 	PM_AUTO_ZONE_THRESHOLD,
 	PM_AUTO_LOOP_CURRENT,
-	PM_AUTO_LOOP_SPEED
+	PM_AUTO_LOOP_SPEED,
+	PM_AUTO_KALMAN_SCHEDULE
 };
 
 enum {
@@ -203,6 +223,35 @@ enum {
 	PM_ERROR_HW_EMERGENCY_STOP
 };
 
+enum {
+	PM_FEEDBACK_GENERIC			= 0,
+	PM_FEEDBACK_ORTEGA_SPEED,
+	PM_FEEDBACK_ORTEGA_CURRENT,
+	PM_FEEDBACK_KALMAN_SPEED,
+	PM_FEEDBACK_KALMAN_CURRENT
+};
+
+enum {
+	PM_PROF_SCALE				= 0,
+	PM_PROF_OBSERVER,
+	PM_PROF_ESTIMATE,
+	PM_PROF_SENSOR,
+	PM_PROF_CURRENT,
+	PM_PROF_VOLTAGE,
+	PM_PROF_FSM,
+	PM_PROF_TLM,
+	PM_PROF_EPCAN,
+	PM_PROF_HAL,
+	PM_PROF_MAX
+};
+
+enum {
+	PM_DEFER_NONE				= 0,
+	PM_DEFER_IMPEDANCE,
+	PM_DEFER_SOLVE,
+	PM_DEFER_KALMAN
+};
+
 typedef struct {
 
 	float		current_A;
@@ -223,9 +272,17 @@ pmfb_t;
 
 typedef struct {
 
+	/* Runtime state and configuration that pm_feedback() touches every
+	 * cycle go first. Commissioning data is kept at the end of the struct.
+	 * This order is for reading only, the whole struct is placed in one
+	 * memory by the caller (see LD_CCRAM in main.c).
+	 * */
 	float		m_freq;
 	float		m_dT;
 
+	int		m_decimate;
+	int		m_tick;
+
 	int		dc_resolution;
 	float		dc_minimal;
 	float		dc_clearance;
@@ -244,14 +301,6 @@ typedef struct {
 	int		ts_threshold;
 	float		ts_inverted;
 
-	float		self_BST[3];
-	int		self_IST[8];
-	float		self_STDi[3];
-	float		self_RMSi[3];
-	float		self_RMSu;
-	float		self_RMSt[3];
-	float		self_DTu;
-
 	int		config_NOP;
 	int		config_IFB;
 	int		config_TVM;
@@ -271,9 +320,11 @@ typedef struct {
 	int		config_EXCITATION;
 	int		config_SALIENCY;
 	int		config_RELUCTANCE;
+	int		config_MTPA_TABLE;
 	int		config_WEAKENING;
 	int		config_CC_BRAKE_STOP;
 	int		config_CC_SPEED_TRACK;
+	int		config_CC_DEADBEAT;
 	int		config_EABI_FRONTEND;
 	int		config_SINCOS_FRONTEND;
 
@@ -286,20 +337,6 @@ typedef struct {
 	int		tm_value;
 	int		tm_end;
 
-	float		tm_transient_slow;
-	float		tm_transient_fast;
-	float		tm_voltage_hold;
-	float		tm_current_hold;
-	float		tm_current_ramp;
-	float		tm_instant_probe;
-	float		tm_average_probe;
-	float		tm_average_drift;
-	float		tm_average_inertia;
-	float		tm_average_outside;
-	float		tm_pause_startup;
-	float		tm_pause_forced;
-	float		tm_pause_on_halt;
-
 	float		scale_iA[2];
 	float		scale_iB[2];
 	float		scale_iC[2];
@@ -319,26 +356,6 @@ typedef struct {
 	int		fb_HS;
 	int		fb_EP;
 
-	float		probe_current_hold;
-	float		probe_weak_level;
-	float		probe_hold_angle;
-	float		probe_current_sine;
-	float		probe_current_bias;
-	float		probe_freq_sine;
-	float		probe_speed_hold;
-	float		probe_speed_tol;
-	float		probe_location_tol;
-	float		probe_loss_maximal;
-	float		probe_gain_P;
-	float		probe_gain_I;
-
-	float		probe_DFT[8];
-	float		probe_REM[8];
-	float		probe_HF[2];
-	float		probe_gain_LP;
-	float		probe_HOLD[2];
-	float		probe_DATA[24];
-
 	float		fault_voltage_tol;
 	float		fault_current_tol;
 	float		fault_accuracy_tol;
@@ -446,6 +463,11 @@ typedef struct {
 	float		kalman_gain_Q[4];
 	float		kalman_gain_R;
 
+	/* Steady-state gains on DQ-axes over the speed grid.
+	 * */
+	float		kalman_sched_K[PM_KALMAN_SCHED][10];
+	float		kalman_sched_wS;
+
 	float		zone_threshold;
 	float		zone_tol;
 	float		zone_lpf_wS;
@@ -530,6 +552,9 @@ typedef struct {
 	float		lazy_HF[2];
 	float		lazy_ZiEP;
 	float		lazy_ZiSQ;
+	float		lazy_sK;
+	float		lazy_sT;
+	int		lazy_FEEDBACK;
 
 	int		watt_DC_MAX;
 	int		watt_DC_MIN;
@@ -573,6 +598,7 @@ typedef struct {
 	float		i_damping;
 	float		i_gain_P;
 	float		i_gain_I;
+	float		i_gain_DB;
 
 	float		mtpa_revstep;
 	float		mtpa_setpoint_Q;
@@ -580,6 +606,12 @@ typedef struct {
 	float		mtpa_track_D;
 	float		mtpa_gain_LP;
 
+	/* MTPA D current and torque over Q current grid.
+	 * */
+	float		mtpa_table_D[PM_MTPA_TABLE];
+	float		mtpa_table_mQ[PM_MTPA_TABLE];
+	float		mtpa_table_kQ;
+
 	float		weak_maximal;
 	float		weak_track_D;
 	float		weak_gain_EU;
@@ -618,6 +650,73 @@ typedef struct {
 	void 		(* proc_set_DC) (int, int, int);
 	void 		(* proc_set_Z) (int);
 
+	/* Cold data that is used by FSM and probes only.
+	 * */
+	float		self_BST[3];
+	int		self_IST[8];
+	float		self_STDi[3];
+	float		self_RMSi[3];
+	float		self_RMSu;
+	float		self_RMSt[3];
+	float		self_DTu;
+
+	float		tm_transient_slow;
+	float		tm_transient_fast;
+	float		tm_voltage_hold;
+	float		tm_current_hold;
+	float		tm_current_ramp;
+	float		tm_instant_probe;
+	float		tm_average_probe;
+	float		tm_average_drift;
+	float		tm_average_inertia;
+	float		tm_average_outside;
+	float		tm_pause_startup;
+	float		tm_pause_forced;
+	float		tm_pause_on_halt;
+	float		tm_schedule_build;
+
+	float		probe_current_hold;
+	float		probe_weak_level;
+	float		probe_hold_angle;
+	float		probe_current_sine;
+	float		probe_current_bias;
+	float		probe_freq_sine;
+	float		probe_speed_hold;
+	float		probe_speed_tol;
+	float		probe_location_tol;
+	float		probe_loss_maximal;
+	float		probe_gain_P;
+	float		probe_gain_I;
+
+	float		probe_DFT[8];
+	float		probe_REM[8];
+	float		probe_HF[2];
+	float		probe_gain_LP;
+	float		probe_HOLD[2];
+	float		probe_DATA[24];
+
+	/* Heavy probe math is handed over to the worker. ISR posts the job by
+	 * increment of TX and worker answers with RX equal to TX.
+	 * */
+	int		defer_JOB;
+	int		defer_TIM;
+	volatile int	defer_TX;
+	volatile int	defer_RX;
+	float		defer_la[5];
+
+	void 		(* proc_defer) ();
+
+	/* Cycle counter that profiler reads (NULL disables profiling).
+	 * */
+	const volatile uint32_t	*prof_CYCCNT;
+
+	int		prof_STAGE;
+	uint32_t	prof_mark;
+	uint32_t	prof_acc[PM_PROF_MAX + 1];
+	int		prof_last[PM_PROF_MAX];
+	int		prof_max[PM_PROF_MAX];
+	int		prof_hist[PM_PROF_MAX][PM_PROF_HIST];
+
 	lfseed_t	lfseed;
 	lse_t		lse[2];
 }
@@ -626,6 +725,9 @@ pmc_t;
 void pm_lazy_build(pmc_t *pm);
 void pm_auto(pmc_t *pm, int req);
 
+void pm_kalman_schedule(pmc_t *pm);
+void pm_mtpa_table(pmc_t *pm);
+
 float pm_torque_equation(pmc_t *pm, float iD, float iQ);
 float pm_torque_MTPA(pmc_t *pm, float iQ);
 float pm_torque_maximal(pmc_t *pm, float iQ);
@@ -634,8 +736,14 @@ void pm_clearance(pmc_t *pm, int xA, int xB, int xC);
 void pm_voltage(pmc_t *pm, float uX, float uY);
 
 void pm_FSM(pmc_t *pm);
+void pm_defer(pmc_t *pm);
 void pm_feedback(pmc_t *pm, pmfb_t *fb);
 
+int pm_prof_enter(pmc_t *pm, int stage);
+void pm_prof_leave(pmc_t *pm, int stage);
+void pm_prof_start(pmc_t *pm);
+void pm_prof_finish(pmc_t *pm);
+
 const char *pm_strerror(int fsm_errno);
 
 #endif /* _H_PM_ */
@@ -1067,6 +1067,81 @@ pm_fsm_probe_impedance_DFT(pmc_t *pm, float la[5])
 	}
 }
 
+static void
+pm_fsm_defer(pmc_t *pm, int job)
+{
+	pm->defer_JOB = job;
+	pm->defer_TIM = 0;
+
+	/* Job data must be in memory before the job is posted.
+	 * */
+	__asm__ volatile ("" ::: "memory");
+
+	pm->defer_TX += 1;
+
+	if (pm->proc_defer != NULL) {
+
+		pm->proc_defer();
+	}
+	else {
+		/* There is no worker so we do the job in place.
+		 * */
+		pm_defer(pm);
+	}
+}
+
+static int
+pm_fsm_defer_wait(pmc_t *pm, float tm)
+{
+	if (pm->defer_RX == pm->defer_TX)
+		return 1;
+
+	pm->defer_TIM++;
+
+	if (pm->defer_TIM >= PM_TSMS(pm, tm)) {
+
+		pm->fsm_errno = PM_ERROR_TIMEOUT;
+		pm->fsm_state = PM_STATE_HALT;
+		pm->fsm_phase = 0;
+	}
+
+	return 0;
+}
+
+void pm_defer(pmc_t *pm)
+{
+	int		TX = pm->defer_TX;
+
+	if (TX != pm->defer_RX) {
+
+		__asm__ volatile ("" ::: "memory");
+
+		switch (pm->defer_JOB) {
+
+			case PM_DEFER_IMPEDANCE:
+				pm_fsm_probe_impedance_DFT(pm, pm->defer_la);
+				break;
+
+			case PM_DEFER_SOLVE:
+				lse_solve(&pm->lse[0]);
+				break;
+
+			case PM_DEFER_KALMAN:
+				pm_kalman_schedule(pm);
+				break;
+
+			default:
+				break;
+		}
+
+		/* Results must be in memory before the answer.
+		 * */
+		__asm__ volatile ("" ::: "memory");
+
+		pm->defer_RX = TX;
+	}
+}
+
 static void
 pm_fsm_probe_loop_current(pmc_t *pm, float track_HF)
 {
@@ -1472,7 +1547,8 @@ pm_fsm_state_probe_const_resistance(pmc_t *pm)
 static void
 pm_fsm_state_probe_const_inductance(pmc_t *pm)
 {
-	float			la[5], iX, iY, uX, uY, hold_A;
+	const float		*la;
+	float			iX, iY, uX, uY, hold_A;
 
 	switch (pm->fsm_phase) {
 
@@ -1577,7 +1653,19 @@ pm_fsm_state_probe_const_inductance(pmc_t *pm)
 			break;
 
 		case 4:
-			pm_fsm_probe_impedance_DFT(pm, la);
+			pm_voltage(pm, 0.f, 0.f);
+			pm_fsm_defer(pm, PM_DEFER_IMPEDANCE);
+
+			pm->fsm_phase += 1;
+			break;
+
+		case 5:
+			pm_voltage(pm, 0.f, 0.f);
+
+			if (pm_fsm_defer_wait(pm, pm->tm_transient_slow) == 0)
+				break;
+
+			la = pm->defer_la;
 
 			if (		   m_isfinitef(la[2]) != 0 && la[2] > M_EPSILON
 					&& m_isfinitef(la[3]) != 0 && la[3] > M_EPSILON) {
@@ -1586,6 +1674,8 @@ pm_fsm_state_probe_const_inductance(pmc_t *pm)
 				pm->const_im_Lq = la[3];
 				pm->const_im_Ag = m_atan2f(la[1], la[0]) * (180.f / M_PI_F);
 				pm->const_im_Rz = la[4];
+
+				pm->kalman_sched_wS = 0.f;
 			}
 			else {
 				pm->fsm_errno = PM_ERROR_UNCERTAIN_RESULT;
@@ -1603,7 +1693,8 @@ pm_fsm_state_probe_const_saturation(pmc_t *pm)
 	lse_t			*ls = &pm->lse[0];
 	lse_float_t		v[3];
 
-	float			la[5], iX, iY, uX, uY;
+	const float		*la;
+	float			iX, iY, uX, uY;
 
 	switch (pm->fsm_phase) {
 
@@ -1779,7 +1870,21 @@ pm_fsm_state_probe_const_saturation(pmc_t *pm)
 			if (pm->fsm_errno != PM_OK)
 				break;
 
-			pm_fsm_probe_impedance_DFT(pm, la);
+			pm_fsm_defer(pm, PM_DEFER_IMPEDANCE);
+
+			pm->fsm_phase += 1;
+			break;
+
+		case 7:
+			pm_fsm_probe_loop_current(pm, pm->probe_current_sine);
+
+			if (pm->fsm_errno != PM_OK)
+				break;
+
+			if (pm_fsm_defer_wait(pm, pm->tm_transient_slow) == 0)
+				break;
+
+			la = pm->defer_la;
 
 			if (		   m_isfinitef(la[2]) != 0 && la[2] > M_EPSILON
 					&& m_isfinitef(la[3]) != 0 && la[3] > M_EPSILON) {
@@ -1789,6 +1894,8 @@ pm_fsm_state_probe_const_saturation(pmc_t *pm)
 				pm->const_im_Ag = m_atan2f(la[1], la[0]) * (180.f / M_PI_F);
 				pm->const_im_Rz = la[4];
 
+				pm->kalman_sched_wS = 0.f;
+
 				if (		   pm->fsm_subi >= 13
 						&& pm->fsm_subi <= 23) {
 
@@ -1822,7 +1929,7 @@ pm_fsm_state_probe_const_saturation(pmc_t *pm)
 			}
 			break;
 
-		case 7:
+		case 8:
 			pm_voltage(pm, 0.f, 0.f);
 
 			pm->tm_value++;
@@ -1833,14 +1940,26 @@ pm_fsm_state_probe_const_saturation(pmc_t *pm)
 			}
 			break;
 
-		case 8:
-			lse_solve(ls);
+		case 9:
+			pm_voltage(pm, 0.f, 0.f);
+			pm_fsm_defer(pm, PM_DEFER_SOLVE);
+
+			pm->fsm_phase += 1;
+			break;
+
+		case 10:
+			pm_voltage(pm, 0.f, 0.f);
+
+			if (pm_fsm_defer_wait(pm, pm->tm_transient_slow) == 0)
+				break;
 
 			if (		   m_isfinitef(ls->sol.m[0]) != 0
 					&& m_isfinitef(ls->sol.m[1]) != 0) {
 
 				pm->const_im_Ld = ls->sol.m[0];
 				pm->const_im_Lq = ls->sol.m[1];
+
+				pm->kalman_sched_wS = 0.f;
 			}
 			else {
 				pm->fsm_errno = PM_ERROR_UNCERTAIN_RESULT;
@@ -1858,6 +1977,23 @@ pm_fsm_state_lu_startup(pmc_t *pm, int in_ZONE)
 	switch (pm->fsm_phase) {
 
 		case 0:
+			if (		   pm->config_LU_ESTIMATE == PM_FLUX_KALMAN_SCHEDULED
+					&& pm->kalman_sched_wS < M_EPSILON) {
+
+				/* Gain schedule is not built yet or machine
+				 * constants were changed so we build it in
+				 * worker.
+				 * */
+				pm_fsm_defer(pm, PM_DEFER_KALMAN);
+			}
+
+			pm->fsm_phase = 1;
+			break;
+
+		case 1:
+			if (pm_fsm_defer_wait(pm, pm->tm_schedule_build) == 0)
+				break;
+
 			if (		   m_isfinitef(pm->const_im_Ld) != 0
 					&& m_isfinitef(pm->const_im_Lq) != 0
 					&& pm->const_im_Ld > M_EPSILON
@@ -2166,6 +2302,7 @@ pm_fsm_state_probe_const_flux_linkage(pmc_t *pm)
 
 					pm->const_lambda = ls->sol.m[0];
 					pm->kalman_bias_Q = 0.f;
+					pm->kalman_sched_wS = 0.f;
 
 					pm_lazy_build(pm);
 				}
@@ -2745,7 +2882,8 @@ pm_fsm_state_halt(pmc_t *pm)
 	}
 }
 
-void pm_FSM(pmc_t *pm)
+static void
+pm_fsm_request(pmc_t *pm)
 {
 	switch (pm->fsm_req) {
 
@@ -2806,6 +2944,18 @@ void pm_FSM(pmc_t *pm)
 	}
 
 	pm->fsm_req = PM_STATE_IDLE;
+}
+
+void pm_FSM(pmc_t *pm)
+{
+	if (		pm->defer_RX == pm->defer_TX
+			|| pm->fsm_req == PM_STATE_HALT) {
+
+		/* Hold the request until deferred job is done as the new
+		 * state may reuse its data.
+		 * */
+		pm_fsm_request(pm);
+	}
 
 	switch (pm->fsm_state) {
 
@@ -0,0 +1,13 @@
+/* Variant of pm_feedback() specialized for three-phase machine with Kalman
+ * observer, no position sensor and current control loop.
+ * */
+#define PM_SPEC(name)			name ## _kalman_current
+
+#define PM_CONFIG_NOP(pm)		PM_NOP_THREE_PHASE
+#define PM_CONFIG_LU_ESTIMATE(pm)	PM_FLUX_KALMAN
+#define PM_CONFIG_LU_SENSOR(pm)		PM_SENSOR_NONE
+#define PM_CONFIG_LU_DRIVE(pm)		PM_DRIVE_CURRENT
+#define PM_CONFIG_HFI_WAVETYPE(pm)	PM_HFI_NONE
+
+#include "pm.c"
+
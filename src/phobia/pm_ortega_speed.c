@@ -0,0 +1,13 @@
+/* Variant of pm_feedback() specialized for three-phase machine with Ortega
+ * observer, no position sensor and speed control loop.
+ * */
+#define PM_SPEC(name)			name ## _ortega_speed
+
+#define PM_CONFIG_NOP(pm)		PM_NOP_THREE_PHASE
+#define PM_CONFIG_LU_ESTIMATE(pm)	PM_FLUX_ORTEGA
+#define PM_CONFIG_LU_SENSOR(pm)		PM_SENSOR_NONE
+#define PM_CONFIG_LU_DRIVE(pm)		PM_DRIVE_SPEED
+#define PM_CONFIG_HFI_WAVETYPE(pm)	PM_HFI_NONE
+
+#include "pm.c"
+
@@ -458,6 +458,11 @@ SH_DEF(pm_probe_spinup)
 		pm_auto(&pm, PM_AUTO_FORCED_ACCEL);
 		pm_auto(&pm, PM_AUTO_LOOP_SPEED);
 
+		/* Machine constants are known now so we build the gain
+		 * schedule once instead of each startup.
+		 * */
+		pm_auto(&pm, PM_AUTO_KALMAN_SCHEDULE);
+
 		reg_OUTP(ID_PM_FORCED_ACCEL_RPM);
 		reg_OUTP(ID_PM_LU_GAIN_MQ_LP);
 		reg_OUTP(ID_PM_S_GAIN_P);
@@ -999,3 +1004,74 @@ SH_DEF(pm_default_scale)
 	pm_auto(&pm, PM_AUTO_SCALE_DEFAULT);
 }
 
+
+SH_DEF(pm_profile)
+{
+	const char	*name[PM_PROF_MAX] = { "scale", "observer", "estimate",
+		"sensor", "current", "voltage", "fsm", "tlm", "epcan", "hal" };
+
+	float		kUS, last, min, max, pc;
+	int		N, K, irq;
+
+	if (pm.prof_CYCCNT == NULL) {
+
+		printf("Unable when cycle counter is not available" EOL);
+		return ;
+	}
+
+	kUS = 1000000.f / (float) clock_cpu_hz;
+
+	printf("Bin@us  ");
+
+	for (K = 1; K < PM_PROF_HIST; ++K) {
+
+		last = (float) (1U << (PM_PROF_SHIFT + K - 1)) * kUS;
+
+		printf(" %2f", &last);
+	}
+
+	printf(EOL "Stage    Last@us Max@us Max@%% Histogram" EOL);
+
+	for (N = 0; N < PM_PROF_MAX; ++N) {
+
+		last = (float) pm.prof_last[N] * kUS;
+		max = (float) pm.prof_max[N] * kUS;
+		pc = max * pm.m_freq * 0.0001f;
+
+		printf("%8s %2f %2f %1f ", name[N], &last, &max, &pc);
+
+		for (K = 0; K < PM_PROF_HIST; ++K) {
+
+			printf(" %i", pm.prof_hist[N][K]);
+		}
+
+		printf(EOL);
+	}
+
+	last = (float) hal.CNT_cycle[0] * kUS;
+	min = (float) hal.CNT_cycle[1] * kUS;
+	max = (float) hal.CNT_cycle[2] * kUS;
+	pc = (max - min) * pm.m_freq * 0.0001f;
+
+	printf("ISR      Last@us Min@us Max@us Jitter@%%" EOL);
+	printf("%8s %2f %2f %2f %1f" EOL, "total", &last, &min, &max, &pc);
+
+	/* Start the next observation window.
+	 * */
+	irq = hal_lock_irq();
+
+	hal.CNT_cycle[1] = 0xFFFFFFFFU;
+	hal.CNT_cycle[2] = 0U;
+
+	for (N = 0; N < PM_PROF_MAX; ++N) {
+
+		pm.prof_max[N] = 0;
+
+		for (K = 0; K < PM_PROF_HIST; ++K) {
+
+			pm.prof_hist[N][K] = 0;
+		}
+	}
+
+	hal_unlock_irq(irq);
+}
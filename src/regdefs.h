@@ -248,6 +248,7 @@ ID_AP_TASK_MPU6050,
 ID_AP_AUTO_REG_DATA,
 ID_AP_AUTO_REG_ID,
 ID_AP_LOAD_HX711,
+ID_PM_M_DECIMATE,
 ID_PM_DC_RESOLUTION,
 ID_PM_DC_MINIMAL,
 ID_PM_DC_CLEARANCE,
@@ -279,9 +280,11 @@ ID_PM_CONFIG_HFI_PERMANENT,
 ID_PM_CONFIG_EXCITATION,
 ID_PM_CONFIG_SALIENCY,
 ID_PM_CONFIG_RELUCTANCE,
+ID_PM_CONFIG_MTPA_TABLE,
 ID_PM_CONFIG_WEAKENING,
 ID_PM_CONFIG_CC_BRAKE_STOP,
 ID_PM_CONFIG_CC_SPEED_TRACK,
+ID_PM_CONFIG_CC_DEADBEAT,
 ID_PM_CONFIG_EABI_FRONTEND,
 ID_PM_CONFIG_SINCOS_FRONTEND,
 ID_PM_FSM_REQ,
@@ -554,6 +557,7 @@ ID_PM_I_SLEW_RATE,
 ID_PM_I_DAMPING,
 ID_PM_I_GAIN_P,
 ID_PM_I_GAIN_I,
+ID_PM_I_GAIN_DB,
 ID_PM_MTPA_REVSTEP,
 ID_PM_MTPA_TRACK_D,
 ID_PM_MTPA_GAIN_LP,
@@ -614,13 +618,38 @@ ID_PM_X_GAIN_P_RADPS,
 ID_PM_X_GAIN_P_MMPS,
 ID_PM_X_GAIN_D,
 ID_PM_DBG_FLUX_RSU,
+ID_PM_PROF_LAST_SCALE,
+ID_PM_PROF_LAST_OBSERVER,
+ID_PM_PROF_LAST_ESTIMATE,
+ID_PM_PROF_LAST_SENSOR,
+ID_PM_PROF_LAST_CURRENT,
+ID_PM_PROF_LAST_VOLTAGE,
+ID_PM_PROF_LAST_FSM,
+ID_PM_PROF_LAST_TLM,
+ID_PM_PROF_MAX_SCALE,
+ID_PM_PROF_MAX_OBSERVER,
+ID_PM_PROF_MAX_ESTIMATE,
+ID_PM_PROF_MAX_SENSOR,
+ID_PM_PROF_MAX_CURRENT,
+ID_PM_PROF_MAX_VOLTAGE,
+ID_PM_PROF_MAX_FSM,
+ID_PM_PROF_MAX_TLM,
 ID_TLM_RATE_GRAB,
 ID_TLM_RATE_WATCH,
 ID_TLM_RATE_STREAM,
+ID_TLM_RATE_BINARY,
 ID_TLM_AUTO_STARTUP,
 ID_TLM_MODE,
 ID_TLM_LENGTH_MAX,
 ID_TLM_LINE,
+ID_TLM_TRIG_ID,
+ID_TLM_TRIG_TYPE,
+ID_TLM_TRIG_LEVEL,
+ID_TLM_TRIG_RANGE,
+ID_TLM_TRIG_PRE,
+ID_TLM_TRIG_ARM,
+ID_TLM_TRIG_STATE,
+ID_TLM_TRIG_N,
 ID_TLM_REG_ID0,
 ID_TLM_REG_ID1,
 ID_TLM_REG_ID2,
@@ -641,3 +670,63 @@ ID_TLM_REG_ID16,
 ID_TLM_REG_ID17,
 ID_TLM_REG_ID18,
 ID_TLM_REG_ID19,
+ID_TLM_REG_FMT0,
+ID_TLM_REG_FMT1,
+ID_TLM_REG_FMT2,
+ID_TLM_REG_FMT3,
+ID_TLM_REG_FMT4,
+ID_TLM_REG_FMT5,
+ID_TLM_REG_FMT6,
+ID_TLM_REG_FMT7,
+ID_TLM_REG_FMT8,
+ID_TLM_REG_FMT9,
+ID_TLM_REG_FMT10,
+ID_TLM_REG_FMT11,
+ID_TLM_REG_FMT12,
+ID_TLM_REG_FMT13,
+ID_TLM_REG_FMT14,
+ID_TLM_REG_FMT15,
+ID_TLM_REG_FMT16,
+ID_TLM_REG_FMT17,
+ID_TLM_REG_FMT18,
+ID_TLM_REG_FMT19,
+ID_TLM_REG_SCALE0,
+ID_TLM_REG_SCALE1,
+ID_TLM_REG_SCALE2,
+ID_TLM_REG_SCALE3,
+ID_TLM_REG_SCALE4,
+ID_TLM_REG_SCALE5,
+ID_TLM_REG_SCALE6,
+ID_TLM_REG_SCALE7,
+ID_TLM_REG_SCALE8,
+ID_TLM_REG_SCALE9,
+ID_TLM_REG_SCALE10,
+ID_TLM_REG_SCALE11,
+ID_TLM_REG_SCALE12,
+ID_TLM_REG_SCALE13,
+ID_TLM_REG_SCALE14,
+ID_TLM_REG_SCALE15,
+ID_TLM_REG_SCALE16,
+ID_TLM_REG_SCALE17,
+ID_TLM_REG_SCALE18,
+ID_TLM_REG_SCALE19,
+ID_TLM_REG_DIV0,
+ID_TLM_REG_DIV1,
+ID_TLM_REG_DIV2,
+ID_TLM_REG_DIV3,
+ID_TLM_REG_DIV4,
+ID_TLM_REG_DIV5,
+ID_TLM_REG_DIV6,
+ID_TLM_REG_DIV7,
+ID_TLM_REG_DIV8,
+ID_TLM_REG_DIV9,
+ID_TLM_REG_DIV10,
+ID_TLM_REG_DIV11,
+ID_TLM_REG_DIV12,
+ID_TLM_REG_DIV13,
+ID_TLM_REG_DIV14,
+ID_TLM_REG_DIV15,
+ID_TLM_REG_DIV16,
+ID_TLM_REG_DIV17,
+ID_TLM_REG_DIV18,
+ID_TLM_REG_DIV19,
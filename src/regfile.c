@@ -43,6 +43,8 @@ reg_proc_PWM(const reg_t *reg, rval_t *lval, const rval_t *rval)
 			pm.m_dT = 1.f / pm.m_freq;
 			pm.dc_resolution = hal.PWM_resolution;
 
+			pm.kalman_sched_wS = 0.f;
+
 			hal_unlock_irq(irq);
 		}
 	}
@@ -72,6 +74,44 @@ reg_proc_ADC(const reg_t *reg, rval_t *lval, const rval_t *rval)
 	}
 }
 
+static void
+reg_proc_config_lazy(const reg_t *reg, rval_t *lval, const rval_t *rval)
+{
+	int			irq;
+
+	if (lval != NULL) {
+
+		lval->i = reg->link->i;
+	}
+	else if (rval != NULL) {
+
+		if (pm.lu_MODE == PM_LU_DISABLED) {
+
+			reg->link->i = rval->i;
+
+			/* Reselect the pm_feedback() variant for new
+			 * configuration. We do not lock the control ISR as
+			 * machine is not running.
+			 * */
+			pm_lazy_build(&pm);
+		}
+		else {
+			irq = hal_lock_irq();
+
+			reg->link->i = rval->i;
+
+			/* Generic pm_feedback() and MTPA equation fit any
+			 * configuration so we fall back to them until the
+			 * next startup.
+			 * */
+			pm.lazy_FEEDBACK = PM_FEEDBACK_GENERIC;
+			pm.mtpa_table_kQ = 0.f;
+
+			hal_unlock_irq(irq);
+		}
+	}
+}
+
 #ifdef HW_HAVE_NETWORK_EPCAN
 static void
 reg_proc_CAN_bitfreq(const reg_t *reg, rval_t *lval, const rval_t *rval)
@@ -291,6 +331,15 @@ reg_proc_CNT_diag_pc(const reg_t *reg, rval_t *lval, const rval_t *rval)
 	}
 }
 
+static void
+reg_proc_prof_us(const reg_t *reg, rval_t *lval, const rval_t *rval)
+{
+	if (lval != NULL) {
+
+		lval->f = (float) reg->link->i * (1000000.f / (float) clock_cpu_hz);
+	}
+}
+
 #undef APP_DEF
 #define APP_DEF(name)		extern void app_ ## name(void *);
 #include "app/apdefs.h"
@@ -340,6 +389,24 @@ reg_proc_dc_threshold(const reg_t *reg, rval_t *lval, const rval_t *rval)
 	}
 }
 
+static void
+reg_proc_decimate(const reg_t *reg, rval_t *lval, const rval_t *rval)
+{
+	if (lval != NULL) {
+
+		lval->i = reg->link->i;
+	}
+	else if (rval != NULL) {
+
+		if (pm.lu_MODE == PM_LU_DISABLED) {
+
+			reg->link->i = (rval->i < 1) ? 1 : (rval->i > 10) ? 10 : rval->i;
+
+			pm_lazy_build(&pm);
+		}
+	}
+}
+
 static void
 reg_proc_ppm_freq(const reg_t *reg, rval_t *lval, const rval_t *rval)
 {
@@ -523,6 +590,60 @@ reg_proc_knob(const reg_t *reg, rval_t *lval, const rval_t *rval)
 	}
 }
 
+static void
+reg_proc_mtpa_const(const reg_t *reg, rval_t *lval, const rval_t *rval)
+{
+	if (lval != NULL) {
+
+		lval->f = reg->link->f;
+	}
+	else if (rval != NULL) {
+
+		reg->link->f = rval->f;
+
+		/* MTPA table is out of date so we drop it and use the
+		 * equation until the next startup rebuilds the table.
+		 * */
+		pm.mtpa_table_kQ = 0.f;
+	}
+}
+
+static void
+reg_proc_machine_const(const reg_t *reg, rval_t *lval, const rval_t *rval)
+{
+	if (lval != NULL) {
+
+		lval->f = reg->link->f;
+	}
+	else if (rval != NULL) {
+
+		reg->link->f = rval->f;
+
+		/* Both MTPA table and Kalman gain schedule are built from
+		 * machine constants so we drop them.
+		 * */
+		pm.mtpa_table_kQ = 0.f;
+		pm.kalman_sched_wS = 0.f;
+	}
+}
+
+static void
+reg_proc_kalman_gain(const reg_t *reg, rval_t *lval, const rval_t *rval)
+{
+	if (lval != NULL) {
+
+		lval->f = reg->link->f;
+	}
+	else if (rval != NULL) {
+
+		reg->link->f = rval->f;
+
+		/* Steady-state gains depend on noise covariance.
+		 * */
+		pm.kalman_sched_wS = 0.f;
+	}
+}
+
 static void
 reg_proc_lambda_kv(const reg_t *reg, rval_t *lval, const rval_t *rval)
 {
@@ -535,6 +656,9 @@ reg_proc_lambda_kv(const reg_t *reg, rval_t *lval, const rval_t *rval)
         else if (rval != NULL) {
 
                 reg->link->f = const_Kv / (rval->f * (float) pm.const_Zp);
+
+		pm.mtpa_table_kQ = 0.f;
+		pm.kalman_sched_wS = 0.f;
         }
 }
 
@@ -635,6 +759,10 @@ reg_proc_auto_maximal_current(const reg_t *reg, rval_t *lval, const rval_t *rval
 		else {
 			reg->link->f = rval->f;
 		}
+
+		/* Table range follows the maximal current.
+		 * */
+		pm.mtpa_table_kQ = 0.f;
 	}
 }
 
@@ -1524,8 +1652,10 @@ reg_format_textual(const reg_t *reg, const rval_t *rval)
 		case ID_PM_CONFIG_LU_FREEWHEEL:
 		case ID_PM_CONFIG_HFI_PERMANENT:
 		case ID_PM_CONFIG_RELUCTANCE:
+		case ID_PM_CONFIG_MTPA_TABLE:
 		case ID_PM_CONFIG_WEAKENING:
 		case ID_PM_CONFIG_CC_SPEED_TRACK:
+		case ID_PM_CONFIG_CC_DEADBEAT:
 
 			switch (msg) {
 
@@ -1555,6 +1685,7 @@ reg_format_textual(const reg_t *reg, const rval_t *rval)
 				PM_SFI_CASE(PM_FLUX_NONE);
 				PM_SFI_CASE(PM_FLUX_ORTEGA);
 				PM_SFI_CASE(PM_FLUX_KALMAN);
+				PM_SFI_CASE(PM_FLUX_KALMAN_SCHEDULED);
 
 				default: blank = 1; break;
 			}
@@ -1747,6 +1878,81 @@ reg_format_textual(const reg_t *reg, const rval_t *rval)
 				PM_SFI_CASE(TLM_MODE_GRAB);
 				PM_SFI_CASE(TLM_MODE_WATCH);
 				PM_SFI_CASE(TLM_MODE_STREAM);
+				PM_SFI_CASE(TLM_MODE_RECORD);
+				PM_SFI_CASE(TLM_MODE_STREAM_BINARY);
+				PM_SFI_CASE(TLM_MODE_TRIGGER);
+
+				default: blank = 1; break;
+			}
+			break;
+
+		case ID_TLM_REG_FMT0:
+		case ID_TLM_REG_FMT1:
+		case ID_TLM_REG_FMT2:
+		case ID_TLM_REG_FMT3:
+		case ID_TLM_REG_FMT4:
+		case ID_TLM_REG_FMT5:
+		case ID_TLM_REG_FMT6:
+		case ID_TLM_REG_FMT7:
+		case ID_TLM_REG_FMT8:
+		case ID_TLM_REG_FMT9:
+		case ID_TLM_REG_FMT10:
+		case ID_TLM_REG_FMT11:
+		case ID_TLM_REG_FMT12:
+		case ID_TLM_REG_FMT13:
+		case ID_TLM_REG_FMT14:
+		case ID_TLM_REG_FMT15:
+		case ID_TLM_REG_FMT16:
+		case ID_TLM_REG_FMT17:
+		case ID_TLM_REG_FMT18:
+		case ID_TLM_REG_FMT19:
+
+			switch (msg) {
+
+				PM_SFI_CASE(TLM_FORMAT_RAW);
+				PM_SFI_CASE(TLM_FORMAT_INT16);
+				PM_SFI_CASE(TLM_FORMAT_DELTA8);
+				PM_SFI_CASE(TLM_FORMAT_FLAG);
+
+				default: blank = 1; break;
+			}
+			break;
+
+		case ID_TLM_TRIG_TYPE:
+
+			switch (msg) {
+
+				PM_SFI_CASE(TLM_TRIG_RISING);
+				PM_SFI_CASE(TLM_TRIG_FALLING);
+				PM_SFI_CASE(TLM_TRIG_CHANGE);
+				PM_SFI_CASE(TLM_TRIG_ABOVE);
+				PM_SFI_CASE(TLM_TRIG_BELOW);
+				PM_SFI_CASE(TLM_TRIG_INSIDE);
+				PM_SFI_CASE(TLM_TRIG_OUTSIDE);
+
+				default: blank = 1; break;
+			}
+			break;
+
+		case ID_TLM_TRIG_ARM:
+
+			switch (msg) {
+
+				PM_SFI_CASE(TLM_ARM_SINGLE);
+				PM_SFI_CASE(TLM_ARM_AUTO);
+
+				default: blank = 1; break;
+			}
+			break;
+
+		case ID_TLM_TRIG_STATE:
+
+			switch (msg) {
+
+				PM_SFI_CASE(TLM_STATE_IDLE);
+				PM_SFI_CASE(TLM_STATE_ARMED);
+				PM_SFI_CASE(TLM_STATE_FIRED);
+				PM_SFI_CASE(TLM_STATE_DONE);
 
 				default: blank = 1; break;
 			}
@@ -2052,6 +2258,7 @@ const reg_t		regfile[] = {
 
 	REG_DEF(ap.load_HX711,,,		"",	"%0i",	REG_READ_ONLY, NULL, NULL),
 
+	REG_DEF(pm.m_decimate,,,		"",	"%0i",	REG_CONFIG, &reg_proc_decimate, NULL),
 	REG_DEF(pm.dc_resolution,,,		"",	"%0i",	REG_READ_ONLY, NULL, NULL),
 	REG_DEF(pm.dc_minimal,,,		"us",	"%3f",	REG_CONFIG, NULL, NULL),
 	REG_DEF(pm.dc_clearance,,,		"us",	"%3f",	REG_CONFIG, NULL, NULL),
@@ -2067,7 +2274,7 @@ const reg_t		regfile[] = {
 	REG_DEF(pm.self_RMSt,,,			"",	"%0i",	REG_READ_ONLY, NULL, &reg_format_self_RMSt),
 	REG_DEF(pm.self_DTu,,,			"V",	"%4f",	REG_READ_ONLY, NULL, NULL),
 
-	REG_DEF(pm.config_NOP,,,		"",	"%0i",	REG_CONFIG, NULL, &reg_format_enum),
+	REG_DEF(pm.config_NOP,,,		"",	"%0i",	REG_CONFIG, &reg_proc_config_lazy, &reg_format_enum),
 	REG_DEF(pm.config_IFB,,,		"",	"%0i",	REG_CONFIG, NULL, &reg_format_enum),
 	REG_DEF(pm.config_TVM,,,		"",	"%0i",	REG_CONFIG, NULL, &reg_format_enum),
 	REG_DEF(pm.config_DBG,,,		"",	"%0i",	REG_CONFIG, NULL, &reg_format_enum),
@@ -2077,18 +2284,20 @@ const reg_t		regfile[] = {
 	REG_DEF(pm.config_DCU_VOLTAGE,,,	"",	"%0i",	REG_CONFIG, NULL, &reg_format_enum),
 	REG_DEF(pm.config_LU_FORCED,,,		"",	"%0i",	REG_CONFIG, NULL, &reg_format_enum),
 	REG_DEF(pm.config_LU_FREEWHEEL,,,	"",	"%0i",	REG_CONFIG, NULL, &reg_format_enum),
-	REG_DEF(pm.config_LU_ESTIMATE,,,	"",	"%0i",	REG_CONFIG, NULL, &reg_format_enum),
-	REG_DEF(pm.config_LU_SENSOR,,,		"",	"%0i",	REG_CONFIG, NULL, &reg_format_enum),
+	REG_DEF(pm.config_LU_ESTIMATE,,,	"",	"%0i",	REG_CONFIG, &reg_proc_config_lazy, &reg_format_enum),
+	REG_DEF(pm.config_LU_SENSOR,,,		"",	"%0i",	REG_CONFIG, &reg_proc_config_lazy, &reg_format_enum),
 	REG_DEF(pm.config_LU_LOCATION,,,	"",	"%0i",	REG_CONFIG, NULL, &reg_format_enum),
-	REG_DEF(pm.config_LU_DRIVE,,,		"",	"%0i",	REG_CONFIG, NULL, &reg_format_enum),
-	REG_DEF(pm.config_HFI_WAVETYPE,,,	"",	"%0i",	REG_CONFIG, NULL, &reg_format_enum),
+	REG_DEF(pm.config_LU_DRIVE,,,		"",	"%0i",	REG_CONFIG, &reg_proc_config_lazy, &reg_format_enum),
+	REG_DEF(pm.config_HFI_WAVETYPE,,,	"",	"%0i",	REG_CONFIG, &reg_proc_config_lazy, &reg_format_enum),
 	REG_DEF(pm.config_HFI_PERMANENT,,,	"",	"%0i",	REG_CONFIG, NULL, &reg_format_enum),
 	REG_DEF(pm.config_EXCITATION,,,		"",	"%0i",	REG_CONFIG, NULL, &reg_format_enum),
 	REG_DEF(pm.config_SALIENCY,,,		"",	"%0i",	REG_CONFIG, NULL, &reg_format_enum),
-	REG_DEF(pm.config_RELUCTANCE,,,		"",	"%0i",	REG_CONFIG, NULL, &reg_format_enum),
+	REG_DEF(pm.config_RELUCTANCE,,,		"",	"%0i",	REG_CONFIG, &reg_proc_config_lazy, &reg_format_enum),
+	REG_DEF(pm.config_MTPA_TABLE,,,		"",	"%0i",	REG_CONFIG, &reg_proc_config_lazy, &reg_format_enum),
 	REG_DEF(pm.config_WEAKENING,,,		"",	"%0i",	REG_CONFIG, NULL, &reg_format_enum),
 	REG_DEF(pm.config_CC_BRAKE_STOP,,,	"",	"%0i",	REG_CONFIG, NULL, &reg_format_enum),
 	REG_DEF(pm.config_CC_SPEED_TRACK,,,	"",	"%0i",	REG_CONFIG, NULL, &reg_format_enum),
+	REG_DEF(pm.config_CC_DEADBEAT,,,	"",	"%0i",	REG_CONFIG, NULL, &reg_format_enum),
 	REG_DEF(pm.config_EABI_FRONTEND,,,	"",	"%0i",	REG_CONFIG, NULL, &reg_format_enum),
 	REG_DEF(pm.config_SINCOS_FRONTEND,,,	"",	"%0i",	REG_CONFIG, NULL, &reg_format_enum),
 
@@ -2109,6 +2318,7 @@ const reg_t		regfile[] = {
 	REG_DEF(pm.tm_pause_startup,,,		"ms",	"%1f",	REG_CONFIG, NULL, NULL),
 	REG_DEF(pm.tm_pause_forced,,,		"ms",	"%1f",	REG_CONFIG, NULL, NULL),
 	REG_DEF(pm.tm_pause_on_halt,,,		"ms",	"%1f",	REG_CONFIG, NULL, NULL),
+	REG_DEF(pm.tm_schedule_build,,,		"ms",	"%1f",	REG_CONFIG, NULL, NULL),
 
 	REG_DEF(pm.scale_iA, 0, [0],		"A",	"%3f",	REG_CONFIG, NULL, NULL),
 	REG_DEF(pm.scale_iA, 1, [1],		"",	"%4f",	REG_CONFIG, NULL, NULL),
@@ -2239,11 +2449,11 @@ const reg_t		regfile[] = {
 	REG_DEF(pm.kalman_rsu_Q,,,		"A",	"%3f",	REG_READ_ONLY, NULL, NULL),
 	REG_DEF(pm.kalman_bias_Q,,,		"V",	"%3f",	REG_READ_ONLY, NULL, NULL),
 	REG_DEF(pm.kalman_lpf_wS,,,	"rad/s",	"%2f",	REG_READ_ONLY, NULL, NULL),
-	REG_DEF(pm.kalman_gain_Q, 0, [0],	"",	"%2e",	REG_CONFIG, NULL, NULL),
-	REG_DEF(pm.kalman_gain_Q, 1, [1],	"",	"%2e",	REG_CONFIG, NULL, NULL),
-	REG_DEF(pm.kalman_gain_Q, 2, [2],	"",	"%2e",	REG_CONFIG, NULL, NULL),
-	REG_DEF(pm.kalman_gain_Q, 3, [3],	"",	"%2e",	REG_CONFIG, NULL, NULL),
-	REG_DEF(pm.kalman_gain_R,,,		"",	"%2e",	REG_CONFIG, NULL, NULL),
+	REG_DEF(pm.kalman_gain_Q, 0, [0],	"",	"%2e",	REG_CONFIG, &reg_proc_kalman_gain, NULL),
+	REG_DEF(pm.kalman_gain_Q, 1, [1],	"",	"%2e",	REG_CONFIG, &reg_proc_kalman_gain, NULL),
+	REG_DEF(pm.kalman_gain_Q, 2, [2],	"",	"%2e",	REG_CONFIG, &reg_proc_kalman_gain, NULL),
+	REG_DEF(pm.kalman_gain_Q, 3, [3],	"",	"%2e",	REG_CONFIG, &reg_proc_kalman_gain, NULL),
+	REG_DEF(pm.kalman_gain_R,,,		"",	"%2e",	REG_CONFIG, &reg_proc_kalman_gain, NULL),
 
 	REG_DEF(pm.zone_threshold,,, 	"rad/s",	"%2f",	REG_CONFIG, &reg_proc_auto_zone_threshold, NULL),
 	REG_DEF(pm.zone_threshold, _rpm,, 	"rpm",	"%2f",	0, &reg_proc_rpm, NULL),
@@ -2330,7 +2540,7 @@ const reg_t		regfile[] = {
 	REG_DEF(pm.sincos_gain_IF,,,		"%",	"%1f",	REG_CONFIG, &reg_proc_percent, NULL),
 
 	REG_DEF(pm.const_fb_U,,,		"V",	"%3f",	REG_READ_ONLY, NULL, NULL),
-	REG_DEF(pm.const_lambda,,,		"Wb",	"%4g",	REG_CONFIG, NULL, NULL),
+	REG_DEF(pm.const_lambda,,,		"Wb",	"%4g",	REG_CONFIG, &reg_proc_machine_const, NULL),
 	REG_DEF(pm.const_lambda, _kv,,	"rpm/V",	"%2f",	0, &reg_proc_lambda_kv, NULL),
 	REG_DEF(pm.const_lambda, _nm,,		"Nm/A",	"%4g",	0, &reg_proc_lambda_nm, NULL),
 	REG_DEF(pm.const_lambda, _rw,,		"Nm/W",	"%4g",	0, &reg_proc_lambda_rw, NULL),
@@ -2339,8 +2549,8 @@ const reg_t		regfile[] = {
 	REG_DEF(pm.const_Ja,,,		"ekgm2",	"%4g",	REG_CONFIG, NULL, NULL),
 	REG_DEF(pm.const_Ja, _kgm2,,		"kgm2",	"%4g",	0, &reg_proc_kgm2, NULL),
 	REG_DEF(pm.const_Ja, _kg,,		"kg",	"%4g",	0, &reg_proc_kg, NULL),
-	REG_DEF(pm.const_im_Ld,,,		"H",	"%4g",	REG_CONFIG, NULL, NULL),
-	REG_DEF(pm.const_im_Lq,,,		"H",	"%4g",	REG_CONFIG, NULL, NULL),
+	REG_DEF(pm.const_im_Ld,,,		"H",	"%4g",	REG_CONFIG, &reg_proc_machine_const, NULL),
+	REG_DEF(pm.const_im_Lq,,,		"H",	"%4g",	REG_CONFIG, &reg_proc_machine_const, NULL),
 	REG_DEF(pm.const_im_Ag,,,		"deg",	"%1f",	REG_CONFIG, NULL, NULL),
 	REG_DEF(pm.const_im_Rz,,,		"Ohm",	"%4g",	REG_CONFIG, NULL, NULL),
 	REG_DEF(pm.const_Sm,,,			"mm",	"%3f",	REG_CONFIG, &reg_proc_mm, NULL),
@@ -2379,13 +2589,14 @@ const reg_t		regfile[] = {
 	REG_DEF(pm.i_setpoint_torque,,,		"Nm",	"%3f",	0, &reg_proc_load_nm, NULL),
 	REG_DEF(pm.i_setpoint_torque, _pc,,	"%",	"%2f",	0, &reg_proc_torque_pc, NULL),
 	REG_DEF(pm.i_maximal,,,			"A",	"%3f",	REG_CONFIG, &reg_proc_auto_maximal_current, NULL),
-	REG_DEF(pm.i_reverse,,,			"A",	"%3f",	REG_CONFIG, NULL, NULL),
+	REG_DEF(pm.i_reverse,,,			"A",	"%3f",	REG_CONFIG, &reg_proc_mtpa_const, NULL),
 	REG_DEF(pm.i_track_D,,,			"A",	"%3f",	REG_READ_ONLY, NULL, NULL),
 	REG_DEF(pm.i_track_Q,,,			"A",	"%3f",	REG_READ_ONLY, NULL, NULL),
 	REG_DEF(pm.i_slew_rate,,,		"A/s",	"%1f",	REG_CONFIG, NULL, NULL),
 	REG_DEF(pm.i_damping,,,			"%",	"%1f",	REG_CONFIG, &reg_proc_auto_loop_current, NULL),
 	REG_DEF(pm.i_gain_P,,,			"",	"%2e",	REG_CONFIG, NULL, NULL),
 	REG_DEF(pm.i_gain_I,,,			"",	"%2e",	REG_CONFIG, NULL, NULL),
+	REG_DEF(pm.i_gain_DB,,,			"",	"%2e",	REG_CONFIG, NULL, NULL),
 
 	REG_DEF(pm.mtpa_revstep,,,		"A",	"%3f",	REG_CONFIG, NULL, NULL),
 	REG_DEF(pm.mtpa_track_D,,,		"A",	"%3f",	REG_READ_ONLY, NULL, NULL),
@@ -2454,14 +2665,46 @@ const reg_t		regfile[] = {
 
 	REG_DEF(pm.dbg_flux_rsu,,,		"deg",	"%3f",	REG_READ_ONLY, NULL, NULL),
 
+	REG_DEF(pm.prof_last, _scale, [PM_PROF_SCALE],	"us",	"%2f",	REG_READ_ONLY, &reg_proc_prof_us, NULL),
+	REG_DEF(pm.prof_last, _observer, [PM_PROF_OBSERVER],	"us",	"%2f",	REG_READ_ONLY, &reg_proc_prof_us, NULL),
+	REG_DEF(pm.prof_last, _estimate, [PM_PROF_ESTIMATE],	"us",	"%2f",	REG_READ_ONLY, &reg_proc_prof_us, NULL),
+	REG_DEF(pm.prof_last, _sensor, [PM_PROF_SENSOR],	"us",	"%2f",	REG_READ_ONLY, &reg_proc_prof_us, NULL),
+	REG_DEF(pm.prof_last, _current, [PM_PROF_CURRENT],	"us",	"%2f",	REG_READ_ONLY, &reg_proc_prof_us, NULL),
+	REG_DEF(pm.prof_last, _voltage, [PM_PROF_VOLTAGE],	"us",	"%2f",	REG_READ_ONLY, &reg_proc_prof_us, NULL),
+	REG_DEF(pm.prof_last, _fsm, [PM_PROF_FSM],	"us",	"%2f",	REG_READ_ONLY, &reg_proc_prof_us, NULL),
+	REG_DEF(pm.prof_last, _tlm, [PM_PROF_TLM],	"us",	"%2f",	REG_READ_ONLY, &reg_proc_prof_us, NULL),
+	REG_DEF(pm.prof_last, _epcan, [PM_PROF_EPCAN],	"us",	"%2f",	REG_READ_ONLY, &reg_proc_prof_us, NULL),
+	REG_DEF(pm.prof_last, _hal, [PM_PROF_HAL],	"us",	"%2f",	REG_READ_ONLY, &reg_proc_prof_us, NULL),
+
+	REG_DEF(pm.prof_max, _scale, [PM_PROF_SCALE],	"us",	"%2f",	REG_READ_ONLY, &reg_proc_prof_us, NULL),
+	REG_DEF(pm.prof_max, _observer, [PM_PROF_OBSERVER],	"us",	"%2f",	REG_READ_ONLY, &reg_proc_prof_us, NULL),
+	REG_DEF(pm.prof_max, _estimate, [PM_PROF_ESTIMATE],	"us",	"%2f",	REG_READ_ONLY, &reg_proc_prof_us, NULL),
+	REG_DEF(pm.prof_max, _sensor, [PM_PROF_SENSOR],	"us",	"%2f",	REG_READ_ONLY, &reg_proc_prof_us, NULL),
+	REG_DEF(pm.prof_max, _current, [PM_PROF_CURRENT],	"us",	"%2f",	REG_READ_ONLY, &reg_proc_prof_us, NULL),
+	REG_DEF(pm.prof_max, _voltage, [PM_PROF_VOLTAGE],	"us",	"%2f",	REG_READ_ONLY, &reg_proc_prof_us, NULL),
+	REG_DEF(pm.prof_max, _fsm, [PM_PROF_FSM],	"us",	"%2f",	REG_READ_ONLY, &reg_proc_prof_us, NULL),
+	REG_DEF(pm.prof_max, _tlm, [PM_PROF_TLM],	"us",	"%2f",	REG_READ_ONLY, &reg_proc_prof_us, NULL),
+	REG_DEF(pm.prof_max, _epcan, [PM_PROF_EPCAN],	"us",	"%2f",	REG_READ_ONLY, &reg_proc_prof_us, NULL),
+	REG_DEF(pm.prof_max, _hal, [PM_PROF_HAL],	"us",	"%2f",	REG_READ_ONLY, &reg_proc_prof_us, NULL),
+
 	REG_DEF(tlm.rate_grab,,,		"Hz",	"%1f",	REG_CONFIG, &reg_proc_tlm_rate, NULL),
 	REG_DEF(tlm.rate_watch,,,		"Hz",	"%1f",	REG_CONFIG, &reg_proc_tlm_rate, NULL),
 	REG_DEF(tlm.rate_stream,,,		"Hz",	"%1f",	REG_CONFIG, &reg_proc_tlm_rate, NULL),
+	REG_DEF(tlm.rate_binary,,,		"Hz",	"%1f",	REG_CONFIG, &reg_proc_tlm_rate, NULL),
 	REG_DEF(tlm.auto_STARTUP,,,		"",	"%0i",	REG_CONFIG, NULL, &reg_format_enum),
 	REG_DEF(tlm.mode,,,			"",	"%0i",	REG_READ_ONLY, NULL, &reg_format_enum),
 	REG_DEF(tlm.length_MAX,,,		"",	"%0i",	REG_READ_ONLY, NULL, NULL),
 	REG_DEF(tlm.line,,,			"",	"%0i",	REG_READ_ONLY, NULL, NULL),
 
+	REG_DEF(tlm.trig_ID,,,			"",	"%0i",	REG_CONFIG | REG_LINKED, NULL, NULL),
+	REG_DEF(tlm.trig_TYPE,,,		"",	"%0i",	REG_CONFIG, NULL, &reg_format_enum),
+	REG_DEF(tlm.trig_level,,,		"",	"%4g",	REG_CONFIG, NULL, NULL),
+	REG_DEF(tlm.trig_range,,,		"",	"%4g",	REG_CONFIG, NULL, NULL),
+	REG_DEF(tlm.trig_pre,,,			"%",	"%0i",	REG_CONFIG, NULL, NULL),
+	REG_DEF(tlm.trig_ARM,,,			"",	"%0i",	REG_CONFIG, NULL, &reg_format_enum),
+	REG_DEF(tlm.trig_state,,,		"",	"%0i",	REG_READ_ONLY, NULL, &reg_format_enum),
+	REG_DEF(tlm.trig_N,,,			"",	"%0i",	REG_READ_ONLY, NULL, NULL),
+
 	REG_DEF(tlm.reg_ID, 0, [0],		"",	"%0i",	REG_CONFIG | REG_LINKED, NULL, NULL),
 	REG_DEF(tlm.reg_ID, 1, [1],		"",	"%0i",	REG_CONFIG | REG_LINKED, NULL, NULL),
 	REG_DEF(tlm.reg_ID, 2, [2],		"",	"%0i",	REG_CONFIG | REG_LINKED, NULL, NULL),
@@ -2484,6 +2727,72 @@ const reg_t		regfile[] = {
 	REG_DEF(tlm.reg_ID, 18, [18],		"",	"%0i",	REG_CONFIG | REG_LINKED, NULL, NULL),
 	REG_DEF(tlm.reg_ID, 19, [19],		"",	"%0i",	REG_CONFIG | REG_LINKED, NULL, NULL),
 
+	REG_DEF(tlm.reg_FMT, 0, [0],		"",	"%0i",	REG_CONFIG, NULL, &reg_format_enum),
+	REG_DEF(tlm.reg_FMT, 1, [1],		"",	"%0i",	REG_CONFIG, NULL, &reg_format_enum),
+	REG_DEF(tlm.reg_FMT, 2, [2],		"",	"%0i",	REG_CONFIG, NULL, &reg_format_enum),
+	REG_DEF(tlm.reg_FMT, 3, [3],		"",	"%0i",	REG_CONFIG, NULL, &reg_format_enum),
+	REG_DEF(tlm.reg_FMT, 4, [4],		"",	"%0i",	REG_CONFIG, NULL, &reg_format_enum),
+	REG_DEF(tlm.reg_FMT, 5, [5],		"",	"%0i",	REG_CONFIG, NULL, &reg_format_enum),
+	REG_DEF(tlm.reg_FMT, 6, [6],		"",	"%0i",	REG_CONFIG, NULL, &reg_format_enum),
+	REG_DEF(tlm.reg_FMT, 7, [7],		"",	"%0i",	REG_CONFIG, NULL, &reg_format_enum),
+	REG_DEF(tlm.reg_FMT, 8, [8],		"",	"%0i",	REG_CONFIG, NULL, &reg_format_enum),
+	REG_DEF(tlm.reg_FMT, 9, [9],		"",	"%0i",	REG_CONFIG, NULL, &reg_format_enum),
+
+	REG_DEF(tlm.reg_FMT, 10, [10],		"",	"%0i",	REG_CONFIG, NULL, &reg_format_enum),
+	REG_DEF(tlm.reg_FMT, 11, [11],		"",	"%0i",	REG_CONFIG, NULL, &reg_format_enum),
+	REG_DEF(tlm.reg_FMT, 12, [12],		"",	"%0i",	REG_CONFIG, NULL, &reg_format_enum),
+	REG_DEF(tlm.reg_FMT, 13, [13],		"",	"%0i",	REG_CONFIG, NULL, &reg_format_enum),
+	REG_DEF(tlm.reg_FMT, 14, [14],		"",	"%0i",	REG_CONFIG, NULL, &reg_format_enum),
+	REG_DEF(tlm.reg_FMT, 15, [15],		"",	"%0i",	REG_CONFIG, NULL, &reg_format_enum),
+	REG_DEF(tlm.reg_FMT, 16, [16],		"",	"%0i",	REG_CONFIG, NULL, &reg_format_enum),
+	REG_DEF(tlm.reg_FMT, 17, [17],		"",	"%0i",	REG_CONFIG, NULL, &reg_format_enum),
+	REG_DEF(tlm.reg_FMT, 18, [18],		"",	"%0i",	REG_CONFIG, NULL, &reg_format_enum),
+	REG_DEF(tlm.reg_FMT, 19, [19],		"",	"%0i",	REG_CONFIG, NULL, &reg_format_enum),
+
+	REG_DEF(tlm.reg_scale, 0, [0],		"",	"%4g",	REG_CONFIG, NULL, NULL),
+	REG_DEF(tlm.reg_scale, 1, [1],		"",	"%4g",	REG_CONFIG, NULL, NULL),
+	REG_DEF(tlm.reg_scale, 2, [2],		"",	"%4g",	REG_CONFIG, NULL, NULL),
+	REG_DEF(tlm.reg_scale, 3, [3],		"",	"%4g",	REG_CONFIG, NULL, NULL),
+	REG_DEF(tlm.reg_scale, 4, [4],		"",	"%4g",	REG_CONFIG, NULL, NULL),
+	REG_DEF(tlm.reg_scale, 5, [5],		"",	"%4g",	REG_CONFIG, NULL, NULL),
+	REG_DEF(tlm.reg_scale, 6, [6],		"",	"%4g",	REG_CONFIG, NULL, NULL),
+	REG_DEF(tlm.reg_scale, 7, [7],		"",	"%4g",	REG_CONFIG, NULL, NULL),
+	REG_DEF(tlm.reg_scale, 8, [8],		"",	"%4g",	REG_CONFIG, NULL, NULL),
+	REG_DEF(tlm.reg_scale, 9, [9],		"",	"%4g",	REG_CONFIG, NULL, NULL),
+
+	REG_DEF(tlm.reg_scale, 10, [10],	"",	"%4g",	REG_CONFIG, NULL, NULL),
+	REG_DEF(tlm.reg_scale, 11, [11],	"",	"%4g",	REG_CONFIG, NULL, NULL),
+	REG_DEF(tlm.reg_scale, 12, [12],	"",	"%4g",	REG_CONFIG, NULL, NULL),
+	REG_DEF(tlm.reg_scale, 13, [13],	"",	"%4g",	REG_CONFIG, NULL, NULL),
+	REG_DEF(tlm.reg_scale, 14, [14],	"",	"%4g",	REG_CONFIG, NULL, NULL),
+	REG_DEF(tlm.reg_scale, 15, [15],	"",	"%4g",	REG_CONFIG, NULL, NULL),
+	REG_DEF(tlm.reg_scale, 16, [16],	"",	"%4g",	REG_CONFIG, NULL, NULL),
+	REG_DEF(tlm.reg_scale, 17, [17],	"",	"%4g",	REG_CONFIG, NULL, NULL),
+	REG_DEF(tlm.reg_scale, 18, [18],	"",	"%4g",	REG_CONFIG, NULL, NULL),
+	REG_DEF(tlm.reg_scale, 19, [19],	"",	"%4g",	REG_CONFIG, NULL, NULL),
+
+	REG_DEF(tlm.reg_DIV, 0, [0],		"",	"%0i",	REG_CONFIG, NULL, NULL),
+	REG_DEF(tlm.reg_DIV, 1, [1],		"",	"%0i",	REG_CONFIG, NULL, NULL),
+	REG_DEF(tlm.reg_DIV, 2, [2],		"",	"%0i",	REG_CONFIG, NULL, NULL),
+	REG_DEF(tlm.reg_DIV, 3, [3],		"",	"%0i",	REG_CONFIG, NULL, NULL),
+	REG_DEF(tlm.reg_DIV, 4, [4],		"",	"%0i",	REG_CONFIG, NULL, NULL),
+	REG_DEF(tlm.reg_DIV, 5, [5],		"",	"%0i",	REG_CONFIG, NULL, NULL),
+	REG_DEF(tlm.reg_DIV, 6, [6],		"",	"%0i",	REG_CONFIG, NULL, NULL),
+	REG_DEF(tlm.reg_DIV, 7, [7],		"",	"%0i",	REG_CONFIG, NULL, NULL),
+	REG_DEF(tlm.reg_DIV, 8, [8],		"",	"%0i",	REG_CONFIG, NULL, NULL),
+	REG_DEF(tlm.reg_DIV, 9, [9],		"",	"%0i",	REG_CONFIG, NULL, NULL),
+
+	REG_DEF(tlm.reg_DIV, 10, [10],		"",	"%0i",	REG_CONFIG, NULL, NULL),
+	REG_DEF(tlm.reg_DIV, 11, [11],		"",	"%0i",	REG_CONFIG, NULL, NULL),
+	REG_DEF(tlm.reg_DIV, 12, [12],		"",	"%0i",	REG_CONFIG, NULL, NULL),
+	REG_DEF(tlm.reg_DIV, 13, [13],		"",	"%0i",	REG_CONFIG, NULL, NULL),
+	REG_DEF(tlm.reg_DIV, 14, [14],		"",	"%0i",	REG_CONFIG, NULL, NULL),
+	REG_DEF(tlm.reg_DIV, 15, [15],		"",	"%0i",	REG_CONFIG, NULL, NULL),
+	REG_DEF(tlm.reg_DIV, 16, [16],		"",	"%0i",	REG_CONFIG, NULL, NULL),
+	REG_DEF(tlm.reg_DIV, 17, [17],		"",	"%0i",	REG_CONFIG, NULL, NULL),
+	REG_DEF(tlm.reg_DIV, 18, [18],		"",	"%0i",	REG_CONFIG, NULL, NULL),
+	REG_DEF(tlm.reg_DIV, 19, [19],		"",	"%0i",	REG_CONFIG, NULL, NULL),
+
 	{ NULL, "", 0, NULL, NULL, NULL }
 };
 
@@ -29,13 +29,19 @@ SH_DEF(pm_fsm_shutdown)
 SH_DEF(pm_default_config)
 SH_DEF(pm_default_machine)
 SH_DEF(pm_default_scale)
+SH_DEF(pm_profile)
 SH_DEF(tlm_default)
 SH_DEF(tlm_grab)
 SH_DEF(tlm_watch)
+SH_DEF(tlm_trigger)
+SH_DEF(tlm_record)
 SH_DEF(tlm_stop)
 SH_DEF(tlm_clean)
 SH_DEF(tlm_flush_sync)
+SH_DEF(tlm_flush_record)
 SH_DEF(tlm_stream_sync)
+SH_DEF(tlm_stream_binary)
+SH_DEF(tlm_flush_bulk)
 #ifdef HW_HAVE_NETWORK_EPCAN
 SH_DEF(tlm_stream_async)
 #endif /* HW_HAVE_NETWORK_EPCAN */
@@ -14,12 +14,22 @@
 
 void tlm_reg_default(tlm_t *tlm)
 {
+	int			N;
+
 	tlm->rate_grab = 1;
 	tlm->rate_watch = (int) (hal.PWM_frequency / 1000.f + 0.5f);
 	tlm->rate_stream = (int) (hal.PWM_frequency / 10.f + 0.5f);
+	tlm->rate_binary = (int) (hal.PWM_frequency / 1000.f + 0.5f);
 
 	tlm->auto_STARTUP = TLM_AUTO_DISABLED;
 
+	tlm->trig_ID = ID_PM_FSM_ERRNO;
+	tlm->trig_TYPE = TLM_TRIG_CHANGE;
+	tlm->trig_level = 0.f;
+	tlm->trig_range = 0.f;
+	tlm->trig_pre = 20;
+	tlm->trig_ARM = TLM_ARM_SINGLE;
+
 	tlm->reg_ID[0] = ID_HAL_CNT_DIAG2_PC;
 	tlm->reg_ID[1] = ID_PM_FSM_STATE;
 	tlm->reg_ID[2] = ID_AP_TEMP_PCB;
@@ -41,22 +51,209 @@ void tlm_reg_default(tlm_t *tlm)
 	tlm->reg_ID[17] = ID_PM_CONST_FB_U;
 	tlm->reg_ID[18] = ID_PM_WATT_DRAIN_WA;
 	tlm->reg_ID[19] = ID_PM_KALMAN_BIAS_Q;
+
+	for (N = 0; N < TLM_INPUT_MAX; ++N) {
+
+		tlm->reg_FMT[N] = TLM_FORMAT_RAW;
+		tlm->reg_scale[N] = 1.f;
+		tlm->reg_DIV[N] = 1;
+	}
+}
+
+LD_RAMCORE static int
+tlm_pack_quantize(const tlm_pack_t *pk, rval_t rval, float range)
+{
+	float			fval;
+
+	fval = (pk->integer != 0) ? (float) rval.i : rval.f;
+	fval *= pk->inv;
+
+	fval = (fval > range) ? range : (fval < - range) ? - range : fval;
+
+	return (int) (fval + ((fval < 0.f) ? - .5f : .5f));
 }
 
-void tlm_reg_grab(tlm_t *tlm)
+LD_RAMCORE static void
+tlm_line_pack(tlm_t *tlm)
+{
+	rval_t			*key = NULL;
+	int			N, q, d;
+
+	if ((tlm->line & (TLM_PACK_BLOCK - 1)) == TLM_PACK_BLOCK - 1) {
+
+		key = tlm->rdata + tlm->layout_key
+			+ (tlm->line / TLM_PACK_BLOCK) * tlm->layout_delta_N;
+	}
+
+	for (N = 0; N < tlm->layout_N; ++N) {
+
+		tlm_pack_t		*pk = &tlm->layout_pack[N];
+		rval_t			rval = *(tlm->layout_reg[N]->link);
+		uint8_t			*fdata;
+
+		if ((tlm->line & (pk->divider - 1)) != 0) {
+
+			/* Decimated channel is not sampled on this line.
+			 * */
+			continue;
+		}
+
+		fdata = (uint8_t *) tlm->rdata + pk->offset
+			+ (tlm->line >> pk->order) * pk->stride;
+
+		switch (pk->format) {
+
+			case TLM_FORMAT_RAW:
+				memcpy(fdata, &rval, sizeof(rval_t));
+				break;
+
+			case TLM_FORMAT_INT16:
+				q = tlm_pack_quantize(pk, rval, 32767.f);
+
+				fdata[0] = (uint8_t) (q & 0xFFU);
+				fdata[1] = (uint8_t) ((q >> 8) & 0xFFU);
+				break;
+
+			case TLM_FORMAT_DELTA8:
+				q = tlm_pack_quantize(pk, rval, 1.e+9f);
+
+				d = q - pk->last;
+				d = (d > 127) ? 127 : (d < - 127) ? - 127 : d;
+
+				/* Large steps are slew limited so that
+				 * decoded value follows with some delay.
+				 * */
+				pk->last += d;
+
+				fdata[0] = (uint8_t) (int8_t) d;
+
+				if (key != NULL) {
+
+					key[pk->delta].i = pk->last;
+				}
+				break;
+
+			case TLM_FORMAT_FLAG:
+				q = tlm_pack_quantize(pk, rval, (float) ((1 << TLM_FLAG_BITS) - 1));
+				q = (q < 0) ? 0 : q << pk->shift;
+
+				/* Flags are written in bit order so the byte
+				 * is cleared by the flag that starts it.
+				 * */
+				fdata[0] = (pk->shift == 0) ? (uint8_t) q
+					: fdata[0] | (uint8_t) (q & 0xFFU);
+
+				if (pk->shift + TLM_FLAG_BITS > 8) {
+
+					fdata[1] = (uint8_t) (q >> 8);
+				}
+				break;
+
+			default: break;
+		}
+	}
+}
+
+LD_RAMCORE static int
+tlm_trig_check(tlm_t *tlm, rval_t rval)
+{
+	float			fval, flast;
+	int			fired = 0;
+
+	if (tlm->trig_INT != 0) {
+
+		fval = (float) rval.i;
+		flast = (float) tlm->trig_last.i;
+	}
+	else {
+		fval = rval.f;
+		flast = tlm->trig_last.f;
+	}
+
+	switch (tlm->trig_TYPE) {
+
+		case TLM_TRIG_RISING:
+			fired = (flast < tlm->trig_level && fval >= tlm->trig_level);
+			break;
+
+		case TLM_TRIG_FALLING:
+			fired = (flast > tlm->trig_level && fval <= tlm->trig_level);
+			break;
+
+		case TLM_TRIG_CHANGE:
+			fired = (rval.i != tlm->trig_last.i);
+			break;
+
+		case TLM_TRIG_ABOVE:
+			fired = (fval > tlm->trig_level);
+			break;
+
+		case TLM_TRIG_BELOW:
+			fired = (fval < tlm->trig_level);
+			break;
+
+		case TLM_TRIG_INSIDE:
+			fired = (m_fabsf(fval - tlm->trig_level) <= tlm->trig_range);
+			break;
+
+		case TLM_TRIG_OUTSIDE:
+			fired = (m_fabsf(fval - tlm->trig_level) > tlm->trig_range);
+			break;
+
+		default: break;
+	}
+
+	return fired;
+}
+
+LD_RAMCORE static void
+tlm_trig_update(tlm_t *tlm)
+{
+	rval_t			rval = *(tlm->trig_reg->link);
+
+	/* We do not fire until pre-trigger lines are filled.
+	 * */
+	if (		   tlm->trig_state == TLM_STATE_ARMED
+			&& tlm->clock >= tlm->origin) {
+
+		if (tlm_trig_check(tlm, rval) != 0) {
+
+			/* Trigger line and the rest of the ring after it.
+			 * */
+			tlm->trig_hold = tlm->length_MAX - tlm->origin;
+			tlm->trig_state = TLM_STATE_FIRED;
+		}
+	}
+
+	tlm->trig_last = rval;
+}
+
+LD_RAMCORE void tlm_reg_grab(tlm_t *tlm)
 {
 	int			N;
 
-	if (unlikely(tlm->mode == TLM_MODE_DISABLED))
+	if (unlikely(		   tlm->mode == TLM_MODE_DISABLED
+				|| tlm->mode == TLM_MODE_RECORD))
 		return ;
 
 	if (tlm->skip == 0) {
 
-		rval_t		*rdata = tlm->rdata + tlm->line * tlm->layout_N;
+		if (tlm->layout_PACK != PM_DISABLED) {
 
-		for (N = 0; N < tlm->layout_N; ++N) {
+			tlm_line_pack(tlm);
+		}
+		else {
+			rval_t		*rdata = tlm->rdata + tlm->line * tlm->layout_N;
+
+			for (N = 0; N < tlm->layout_N; ++N) {
+
+				rdata[N] = *(tlm->layout_reg[N]->link);
+			}
+		}
+
+		if (tlm->mode == TLM_MODE_TRIGGER) {
 
-			rdata[N] = *(tlm->layout_reg[N]->link);
+			tlm_trig_update(tlm);
 		}
 	}
 
@@ -83,6 +280,146 @@ void tlm_reg_grab(tlm_t *tlm)
 				tlm->mode = TLM_MODE_DISABLED;
 			}
 		}
+		else if (tlm->mode == TLM_MODE_TRIGGER) {
+
+			if (tlm->trig_state == TLM_STATE_FIRED) {
+
+				tlm->trig_hold -= 1;
+
+				if (tlm->trig_hold <= 0) {
+
+					tlm->trig_state = TLM_STATE_DONE;
+					tlm->trig_N += 1;
+
+					tlm->mode = TLM_MODE_DISABLED;
+				}
+			}
+		}
+	}
+}
+
+void tlm_fb_record(tlm_t *tlm, const pmfb_t *fb)
+{
+	if (likely(tlm->mode != TLM_MODE_RECORD))
+		return ;
+
+	if (unlikely(pm.fsm_errno != PM_OK)) {
+
+		/* Keep the line that brought the fault.
+		 * */
+		tlm->mode = TLM_MODE_DISABLED;
+	}
+	else {
+		rval_t		*rdata = tlm->rdata + tlm->line * tlm->layout_N;
+
+		*(pmfb_t *) rdata = *fb;
+
+		rdata[TLM_RECORD_N - 1].i = pm.fsm_req;
+
+		tlm->clock += 1;
+		tlm->line += 1;
+
+		if (tlm->clock >= tlm->length_MAX) {
+
+			tlm->line = 0;
+			tlm->mode = TLM_MODE_DISABLED;
+		}
+	}
+}
+
+static void
+tlm_layout_pack(tlm_t *tlm)
+{
+	const int		width[4] = { 4, 2, 1, 1 };
+
+	int			N, K, bytes = 0, bits = 0, delta_N = 0;
+	int			block_N, block_size;
+
+	/* Byte fields go first from the widest to keep them aligned.
+	 * */
+	for (K = TLM_FORMAT_RAW; K <= TLM_FORMAT_DELTA8; ++K) {
+
+		for (N = 0; N < tlm->layout_N; ++N) {
+
+			tlm_pack_t	*pk = &tlm->layout_pack[N];
+
+			if (pk->format == K && pk->divider == 1) {
+
+				pk->offset = bytes;
+				pk->shift = 0;
+				pk->delta = (K == TLM_FORMAT_DELTA8) ? delta_N++ : 0;
+
+				bytes += width[K];
+			}
+		}
+	}
+
+	for (N = 0; N < tlm->layout_N; ++N) {
+
+		tlm_pack_t	*pk = &tlm->layout_pack[N];
+
+		if (pk->format == TLM_FORMAT_FLAG && pk->divider == 1) {
+
+			pk->offset = bytes + bits / 8;
+			pk->shift = bits % 8;
+			pk->delta = 0;
+
+			bits += TLM_FLAG_BITS;
+		}
+	}
+
+	tlm->layout_stride = bytes + (bits + 7) / 8;
+	tlm->layout_delta_N = delta_N;
+
+	block_size = TLM_PACK_BLOCK * tlm->layout_stride + delta_N * sizeof(rval_t);
+
+	for (N = 0; N < tlm->layout_N; ++N) {
+
+		tlm_pack_t	*pk = &tlm->layout_pack[N];
+
+		if (pk->divider != 1) {
+
+			block_size += TLM_PACK_BLOCK / pk->divider * width[pk->format];
+		}
+	}
+
+	if (block_size < TLM_PACK_BLOCK * tlm->layout_N * (int) sizeof(rval_t)) {
+
+		block_N = (sizeof(tlm->rdata) - sizeof(rval_t)) / block_size;
+
+		tlm->layout_PACK = PM_ENABLED;
+		tlm->length_MAX = block_N * TLM_PACK_BLOCK;
+
+		bytes = tlm->length_MAX * tlm->layout_stride;
+
+		/* Decimated channels have its own rings after the lines.
+		 * */
+		for (N = 0; N < tlm->layout_N; ++N) {
+
+			tlm_pack_t	*pk = &tlm->layout_pack[N];
+
+			if (pk->divider != 1) {
+
+				pk->offset = bytes;
+				pk->stride = width[pk->format];
+				pk->shift = 0;
+				pk->delta = 0;
+
+				bytes += tlm->length_MAX / pk->divider * pk->stride;
+			}
+			else {
+				pk->stride = tlm->layout_stride;
+			}
+		}
+
+		/* Each block of lines takes its keys in the tail of RAM.
+		 * */
+		tlm->layout_key = (bytes + sizeof(rval_t) - 1) / sizeof(rval_t);
+	}
+	else {
+		tlm->layout_PACK = PM_DISABLED;
+		tlm->length_MAX = TLM_DATA_MAX / tlm->layout_N;
+		tlm->layout_key = 0;
 	}
 }
 
@@ -94,23 +431,136 @@ void tlm_startup(tlm_t *tlm, int rate, int mode)
 
 	hal_memory_fence();
 
+	if (mode == TLM_MODE_RECORD) {
+
+		/* We record the raw feedback on each PWM cycle.
+		 * */
+		tlm->layout_N = TLM_RECORD_N;
+		tlm->layout_FB = PM_ENABLED;
+		tlm->layout_PACK = PM_DISABLED;
+		tlm->length_MAX = TLM_DATA_MAX / TLM_RECORD_N;
+
+		tlm->clock = 0;
+		tlm->skip = 0;
+
+		tlm->rate = 1;
+		tlm->line = 0;
+
+		hal_memory_fence();
+
+		tlm->mode = mode;
+
+		return ;
+	}
+
 	for (N = 0; N < TLM_INPUT_MAX; ++N) {
 
 		if (tlm->reg_ID[N] != ID_NULL) {
 
 			const reg_t	*reg = &regfile[tlm->reg_ID[N]];
+			tlm_pack_t	*pk = &tlm->layout_pack[layout_N];
+
+			pk->format = (	   tlm->reg_FMT[N] >= TLM_FORMAT_RAW
+					&& tlm->reg_FMT[N] <= TLM_FORMAT_FLAG)
+				? tlm->reg_FMT[N] : TLM_FORMAT_RAW;
+			pk->integer = (	   reg->fmt[2] == 'i'
+					|| reg->fmt[2] == 'x') ? 1 : 0;
+
+			pk->scale = (tlm->reg_scale[N] != 0.f) ? tlm->reg_scale[N] : 1.f;
+			pk->inv = 1.f / pk->scale;
+
+			pk->divider = (tlm->reg_DIV[N] < 1) ? 1
+				: (tlm->reg_DIV[N] > TLM_PACK_BLOCK) ? TLM_PACK_BLOCK
+				: tlm->reg_DIV[N];
+
+			/* Round down to the power of two.
+			 * */
+			while ((pk->divider & (pk->divider - 1)) != 0) {
+
+				pk->divider &= pk->divider - 1;
+			}
+
+			pk->order = 0;
+
+			while ((1 << pk->order) < pk->divider) {
+
+				pk->order += 1;
+			}
+
+			if (		   pk->divider != 1
+					&& pk->format == TLM_FORMAT_DELTA8) {
+
+				/* Decimated channel has no delta keys.
+				 * */
+				pk->format = TLM_FORMAT_INT16;
+			}
 
 			tlm->layout_reg[layout_N++] = reg;
 		}
 	}
 
 	tlm->layout_N = layout_N;
-	tlm->length_MAX = TLM_DATA_MAX / layout_N;
+	tlm->layout_FB = PM_DISABLED;
+
+	tlm_layout_pack(tlm);
+
+	if (		   tlm->layout_PACK != PM_DISABLED
+			|| tlm->line >= tlm->length_MAX) {
+
+		/* Packed lines are written from the block start.
+		 * */
+		tlm->line = 0;
+	}
+
+	if (tlm->layout_PACK != PM_DISABLED) {
+
+		rval_t		*key = tlm->rdata + tlm->layout_key
+			+ (tlm->length_MAX / TLM_PACK_BLOCK - 1) * tlm->layout_delta_N;
+
+		for (N = 0; N < layout_N; ++N) {
+
+			tlm_pack_t	*pk = &tlm->layout_pack[N];
+
+			if (pk->format == TLM_FORMAT_DELTA8) {
+
+				/* Start from the actual value as if it was
+				 * the end of previous block.
+				 * */
+				pk->last = tlm_pack_quantize(pk,
+						*(tlm->layout_reg[N]->link), 1.e+9f);
+
+				key[pk->delta].i = pk->last;
+			}
+		}
+	}
 
 	tlm->clock = 0;
 	tlm->skip = 0;
 
 	tlm->rate = rate;
+	tlm->origin = 0;
+
+	tlm->trig_state = TLM_STATE_IDLE;
+
+	if (mode == TLM_MODE_TRIGGER) {
+
+		const reg_t	*reg = &regfile[tlm->trig_ID];
+
+		tlm->trig_reg = reg;
+		tlm->trig_INT = (	   reg->fmt[2] == 'i'
+					|| reg->fmt[2] == 'x') ? 1 : 0;
+
+		tlm->trig_last = *(reg->link);
+
+		/* Time origin of the flushed capture is at trigger line.
+		 * */
+		tlm->origin = tlm->length_MAX * tlm->trig_pre / 100;
+		tlm->origin = (tlm->origin < 0) ? 0
+			: (tlm->origin > tlm->length_MAX - 1) ? tlm->length_MAX - 1
+			: tlm->origin;
+
+		tlm->trig_state = TLM_STATE_ARMED;
+	}
 
 	hal_memory_fence();
 
@@ -132,6 +582,9 @@ void tlm_wipe(tlm_t *tlm)
 	tlm->skip = 0;
 
 	tlm->line = 0;
+	tlm->origin = 0;
+
+	tlm->trig_state = TLM_STATE_IDLE;
 
 	memset(&tlm->rdata, 0, sizeof(tlm->rdata));
 }
@@ -159,6 +612,24 @@ SH_DEF(tlm_watch)
 	tlm_startup(&tlm, rate, TLM_MODE_WATCH);
 }
 
+SH_DEF(tlm_trigger)
+{
+	int		rate = tlm.rate_grab;
+
+	if (		   tlm.trig_ID == ID_NULL
+			|| tlm.trig_ID >= ID_MAX)
+		return ;
+
+	stoi(&rate, s);
+
+	tlm_startup(&tlm, rate, TLM_MODE_TRIGGER);
+}
+
+SH_DEF(tlm_record)
+{
+	tlm_startup(&tlm, 1, TLM_MODE_RECORD);
+}
+
 SH_DEF(tlm_stop)
 {
 	tlm_halt(&tlm);
@@ -169,6 +640,109 @@ SH_DEF(tlm_clean)
 	tlm_wipe(&tlm);
 }
 
+static int
+tlm_line_delta(tlm_t *tlm, int line, const tlm_pack_t *pk)
+{
+	const uint8_t		*fdata = (const uint8_t *) tlm->rdata + pk->offset;
+	const rval_t		*key = tlm->rdata + tlm->layout_key + pk->delta;
+
+	int			block, wline, L, q;
+
+	block = line / TLM_PACK_BLOCK;
+	wline = tlm->line;
+
+	if (		   block == wline / TLM_PACK_BLOCK
+			&& line >= wline) {
+
+		/* The line is older than the writer position in the same
+		 * block so we go back from the key at the block end.
+		 * */
+		q = key[block * tlm->layout_delta_N].i;
+
+		for (L = (block + 1) * TLM_PACK_BLOCK - 1; L > line; --L) {
+
+			q -= (int8_t) fdata[L * tlm->layout_stride];
+		}
+	}
+	else {
+		L = (block > 0) ? block - 1 : tlm->length_MAX / TLM_PACK_BLOCK - 1;
+
+		q = key[L * tlm->layout_delta_N].i;
+
+		for (L = block * TLM_PACK_BLOCK; L <= line; ++L) {
+
+			q += (int8_t) fdata[L * tlm->layout_stride];
+		}
+	}
+
+	return q;
+}
+
+static int
+tlm_line_unpack(tlm_t *tlm, int line, int N, rval_t *rval)
+{
+	const tlm_pack_t	*pk = &tlm->layout_pack[N];
+	const uint8_t		*fdata;
+
+	float			fval;
+	int			q = 0;
+
+	if (tlm->layout_PACK == PM_DISABLED) {
+
+		*rval = tlm->rdata[line * tlm->layout_N + N];
+
+		return 1;
+	}
+
+	if ((line & (pk->divider - 1)) != 0)
+		return 0;
+
+	fdata = (const uint8_t *) tlm->rdata + pk->offset
+		+ (line >> pk->order) * pk->stride;
+
+	switch (pk->format) {
+
+		case TLM_FORMAT_INT16:
+			q = (int16_t) (fdata[0] | (fdata[1] << 8));
+			break;
+
+		case TLM_FORMAT_DELTA8:
+			q = tlm_line_delta(tlm, line, pk);
+			break;
+
+		case TLM_FORMAT_FLAG:
+			q = fdata[0];
+
+			if (pk->shift + TLM_FLAG_BITS > 8) {
+
+				q |= fdata[1] << 8;
+			}
+
+			q = (q >> pk->shift) & ((1 << TLM_FLAG_BITS) - 1);
+			break;
+
+		default: break;
+	}
+
+	if (pk->format == TLM_FORMAT_RAW) {
+
+		memcpy(rval, fdata, sizeof(rval_t));
+	}
+	else {
+		fval = (float) q * pk->scale;
+
+		if (pk->integer != 0) {
+
+			rval->i = (int) (fval + ((fval < 0.f) ? - .5f : .5f));
+		}
+		else {
+			rval->f = fval;
+		}
+	}
+
+	return 1;
+}
+
 static void
 tlm_reg_label(tlm_t *tlm)
 {
@@ -199,22 +773,29 @@ tlm_reg_label(tlm_t *tlm)
 static void
 tlm_reg_flush_line(tlm_t *tlm, int line)
 {
-	const rval_t		*rdata = tlm->rdata + line * tlm->layout_N;
 	int			N;
 
 	for (N = 0; N < tlm->layout_N; ++N) {
 
 		const reg_t	*reg = tlm->layout_reg[N];
-		rval_t		rval = rdata[N];
+		rval_t		rval;
 
-		if (reg->proc != NULL) {
+		if (tlm_line_unpack(tlm, line, N, &rval) != 0) {
 
-			reg_t		lreg = { .link = &rval };
+			if (reg->proc != NULL) {
 
-			reg->proc(&lreg, &rval, NULL);
-		}
+				reg_t		lreg = { .link = &rval };
+
+				reg->proc(&lreg, &rval, NULL);
+			}
 
-		reg_format_rval(reg, &rval);
+			reg_format_rval(reg, &rval);
+		}
+		else {
+			/* Decimated channel has no sample on this line.
+			 * */
+			puts("-");
+		}
 
 		puts(";");
 	}
@@ -227,7 +808,8 @@ SH_DEF(tlm_flush_sync)
 	float			time, dT;
 	int			line, clock, precision;
 
-	if (tlm.mode != TLM_MODE_DISABLED)
+	if (		   tlm.mode != TLM_MODE_DISABLED
+			|| tlm.layout_FB != PM_DISABLED)
 		return ;
 
 	line = tlm.line;
@@ -242,7 +824,7 @@ SH_DEF(tlm_flush_sync)
 	tlm_reg_label(&tlm);
 
 	do {
-		time = (float) clock * dT;
+		time = (float) (clock - tlm.origin) * dT;
 
 		printf("%*f;", precision, &time);
 
@@ -257,6 +839,49 @@ SH_DEF(tlm_flush_sync)
 			break;
 	}
 	while (line != tlm.line);
+
+	if (		   line == tlm.line
+			&& tlm.trig_state == TLM_STATE_DONE
+			&& tlm.trig_ARM == TLM_ARM_AUTO) {
+
+		/* Capture is read out so we arm the trigger again.
+		 * */
+		tlm_startup(&tlm, tlm.rate, TLM_MODE_TRIGGER);
+	}
+}
+
+SH_DEF(tlm_flush_record)
+{
+	const rval_t		*rdata;
+	int			line, N;
+
+	if (		   tlm.mode != TLM_MODE_DISABLED
+			|| tlm.layout_FB != PM_ENABLED)
+		return ;
+
+	/* Raw values are printed in HEX to be restored bit exact.
+	 * */
+	printf("# pm.m_freq %8x" EOL, *(uint32_t *) &pm.m_freq);
+	printf("# pm.dc_resolution %i" EOL, pm.dc_resolution);
+
+	puts("current_A;current_B;current_C;voltage_U;voltage_A;voltage_B;"
+		"voltage_C;analog_SIN;analog_COS;pulse_HS;pulse_EP;fsm_req;" EOL);
+
+	for (line = 0; line < tlm.clock; ++line) {
+
+		rdata = tlm.rdata + line * tlm.layout_N;
+
+		for (N = 0; N < tlm.layout_N; ++N) {
+
+			printf("%8x;", rdata[N].i);
+		}
+
+		puts(EOL);
+
+		if (		   poll() != 0
+				&& getc() != K_LF)
+			break;
+	}
 }
 
 SH_DEF(tlm_stream_sync)
@@ -317,6 +942,413 @@ SH_DEF(tlm_stream_sync)
 	tlm_halt(&tlm);
 }
 
+static void
+tlm_slip_putc(int c)
+{
+	if (c == TLM_SLIP_END) {
+
+		putc(TLM_SLIP_ESC);
+		putc(TLM_SLIP_ESC_END);
+	}
+	else if (c == TLM_SLIP_ESC) {
+
+		putc(TLM_SLIP_ESC);
+		putc(TLM_SLIP_ESC_ESC);
+	}
+	else {
+		putc(c);
+	}
+}
+
+static void
+tlm_frame_send(uint8_t *frame, int len)
+{
+	uint32_t		crc32;
+	int			N;
+
+	crc32 = crc32u(frame, len);
+
+	memcpy(frame + len, &crc32, sizeof(uint32_t));
+
+	len += sizeof(uint32_t);
+
+	putc(TLM_SLIP_END);
+
+	for (N = 0; N < len; ++N) {
+
+		tlm_slip_putc(frame[N]);
+	}
+
+	putc(TLM_SLIP_END);
+}
+
+static int
+tlm_frame_head(uint8_t *frame, int type, int seq)
+{
+	frame[0] = (uint8_t) type;
+	frame[1] = (uint8_t) (seq & 0xFFU);
+	frame[2] = (uint8_t) ((seq >> 8) & 0xFFU);
+
+	return 3;
+}
+
+static void
+tlm_frame_layout(tlm_t *tlm, uint8_t *frame, int seq, float dT)
+{
+	int			N, len, reg_ID;
+
+	len = tlm_frame_head(frame, TLM_FRAME_HEADER, seq);
+
+	frame[len++] = (uint8_t) tlm->layout_N;
+
+	memcpy(frame + len, &dT, sizeof(float));
+
+	len += sizeof(float);
+
+	/* Describe each channel by register ID, value type and divider.
+	 * */
+	for (N = 0; N < tlm->layout_N; ++N) {
+
+		const reg_t	*reg = tlm->layout_reg[N];
+
+		reg_ID = (int) (reg - regfile);
+
+		frame[len++] = (uint8_t) (reg_ID & 0xFFU);
+		frame[len++] = (uint8_t) ((reg_ID >> 8) & 0xFFU);
+
+		frame[len++] = (	   reg->fmt[2] == 'i'
+					|| reg->fmt[2] == 'x') ? 'i' : 'f';
+
+		frame[len++] = (tlm->layout_PACK != PM_DISABLED)
+			? (uint8_t) tlm->layout_pack[N].divider : 1U;
+	}
+
+	tlm_frame_send(frame, len);
+}
+
+static int
+tlm_line_values(tlm_t *tlm, uint8_t *data, int line)
+{
+	int			N, len = 0;
+
+	for (N = 0; N < tlm->layout_N; ++N) {
+
+		const reg_t	*reg = tlm->layout_reg[N];
+		rval_t		rval;
+
+		if (tlm_line_unpack(tlm, line, N, &rval) != 0) {
+
+			if (reg->proc != NULL) {
+
+				reg_t		lreg = { .link = &rval };
+
+				reg->proc(&lreg, &rval, NULL);
+			}
+
+			memcpy(data + len, &rval, sizeof(rval_t));
+
+			len += sizeof(rval_t);
+		}
+	}
+
+	return len;
+}
+
+static void
+tlm_frame_line(tlm_t *tlm, uint8_t *frame, int seq, int line, int clock)
+{
+	int			len;
+
+	len = tlm_frame_head(frame, TLM_FRAME_DATA, seq);
+
+	memcpy(frame + len, &clock, sizeof(int));
+
+	len += sizeof(int);
+	len += tlm_line_values(tlm, frame + len, line);
+
+	tlm_frame_send(frame, len);
+}
+
+SH_DEF(tlm_stream_binary)
+{
+	uint8_t			frame[TLM_FRAME_MAX];
+
+	float			dT;
+	int			line, clock, rate, seq, end, lap;
+
+	if (tlm.mode != TLM_MODE_DISABLED)
+		return ;
+
+	rate = tlm.rate_binary;
+
+	if (stoi(&rate, s) != NULL) {
+
+		rate = (rate < 1) ? 1 : rate;
+	}
+
+	tlm_startup(&tlm, rate, TLM_MODE_STREAM_BINARY);
+
+	line = tlm.line;
+	clock = 0;
+	seq = 0;
+
+	dT = (float) tlm.rate / hal.PWM_frequency;
+
+	/* Text label goes first so that decoded stream is the same as
+	 * from tlm_stream_sync. Then binary frames follow.
+	 * */
+	tlm_reg_label(&tlm);
+
+	tlm_frame_layout(&tlm, frame, seq++, dT);
+
+	do {
+		vTaskDelay((TickType_t) 1);
+
+		end = tlm.clock;
+		lap = end - clock;
+
+		if (lap > tlm.length_MAX - 2) {
+
+			/* We are lapped by the writer so skip forward to
+			 * the lines that are not overwritten yet. Receiver
+			 * sees the gap in clock values.
+			 * */
+			lap -= tlm.length_MAX / 2;
+
+			clock += lap;
+			line = (line + lap) % tlm.length_MAX;
+		}
+
+		while (clock != end) {
+
+			tlm_frame_line(&tlm, frame, seq++, line, clock);
+
+			line = (line < (tlm.length_MAX - 1)) ? line + 1 : 0;
+
+			clock += 1;
+
+			hal_memory_fence();
+		}
+
+		if (		   poll() != 0
+				&& getc() != K_LF)
+			break;
+	}
+	while (1);
+
+	tlm_halt(&tlm);
+
+	tlm_frame_head(frame, TLM_FRAME_END, seq);
+
+	memcpy(frame + 3, &clock, sizeof(int));
+
+	tlm_frame_send(frame, 3 + sizeof(int));
+
+	puts(EOL);
+}
+
+/* Double buffer of bulk flush. Each block of lines is preceded by its
+ * size, number of lines and CRC32.
+ * */
+static struct {
+
+	uint32_t		head[2][3];
+	rval_t			stage[2][TLM_BULK_MAX / sizeof(rval_t)];
+}
+tlm_bulk;
+
+static void
+tlm_bulk_open()
+{
+#ifdef HW_HAVE_USB_CDC_ACM
+	if (iodef == &io_USB) {
+
+		USB_bulk_open();
+	}
+#endif /* HW_HAVE_USB_CDC_ACM */
+}
+
+static int
+tlm_bulk_send(const void *data, int len)
+{
+	const uint8_t		*raw = (const uint8_t *) data;
+	int			N;
+
+#ifdef HW_HAVE_USB_CDC_ACM
+	if (iodef == &io_USB) {
+
+		return USB_bulk_write(data, len);
+	}
+#endif /* HW_HAVE_USB_CDC_ACM */
+
+	for (N = 0; N < len; ++N) {
+
+		putc(raw[N]);
+	}
+
+	return HAL_OK;
+}
+
+static int
+tlm_bulk_wait(int depth)
+{
+#ifdef HW_HAVE_USB_CDC_ACM
+	if (iodef == &io_USB) {
+
+		return USB_bulk_wait(depth);
+	}
+#endif /* HW_HAVE_USB_CDC_ACM */
+
+	return HAL_OK;
+}
+
+SH_DEF(tlm_flush_bulk)
+{
+	uint8_t			frame[TLM_FRAME_MAX];
+	const uint8_t		*data;
+
+	float			dT;
+	int			N, line, clock, len, buf, seq, direct, rc;
+
+	if (		   tlm.mode != TLM_MODE_DISABLED
+			|| tlm.layout_FB != PM_DISABLED)
+		return ;
+
+	tlm_bulk_open();
+
+	dT = (float) tlm.rate / hal.PWM_frequency;
+
+	/* Lines are sent straight from RAM if there are no values to be
+	 * unpacked or converted.
+	 * */
+	direct = (	   tlm.layout_PACK == PM_DISABLED
+			&& tlm.layout_N != 0) ? 1 : 0;
+
+	for (N = 0; N < tlm.layout_N; ++N) {
+
+		if (tlm.layout_reg[N]->proc != NULL) {
+
+			direct = 0;
+		}
+	}
+
+	tlm_reg_label(&tlm);
+
+	seq = 0;
+
+	tlm_frame_layout(&tlm, frame, seq++, dT);
+
+	len = tlm_frame_head(frame, TLM_FRAME_BULK, seq++);
+
+	memcpy(frame + len, &tlm.line, sizeof(int));
+	len += sizeof(int);
+
+	memcpy(frame + len, &tlm.origin, sizeof(int));
+	len += sizeof(int);
+
+	tlm_frame_send(frame, len);
+
+	line = tlm.line;
+	clock = 0;
+	buf = 0;
+
+	do {
+		/* Wait for the previous block from the same buffer.
+		 * */
+		rc = tlm_bulk_wait(2);
+
+		if (rc != HAL_OK)
+			break;
+
+		if (direct != 0) {
+
+			N = TLM_BULK_MAX / (tlm.layout_N * sizeof(rval_t));
+			N = (N < tlm.length_MAX - line) ? N : tlm.length_MAX - line;
+			N = (N < tlm.length_MAX - clock) ? N : tlm.length_MAX - clock;
+
+			data = (const uint8_t *) (tlm.rdata + line * tlm.layout_N);
+			len = N * tlm.layout_N * sizeof(rval_t);
+		}
+		else {
+			data = (const uint8_t *) tlm_bulk.stage[buf];
+			len = 0;
+
+			for (N = 0; clock + N < tlm.length_MAX; ++N) {
+
+				if (len + tlm.layout_N * sizeof(rval_t) > TLM_BULK_MAX)
+					break;
+
+				len += tlm_line_values(&tlm, (uint8_t *) data + len,
+						(line + N) % tlm.length_MAX);
+			}
+		}
+
+		tlm_bulk.head[buf][0] = (uint32_t) len;
+		tlm_bulk.head[buf][1] = (uint32_t) N;
+		tlm_bulk.head[buf][2] = crc32u(data, len);
+
+		rc = tlm_bulk_send(tlm_bulk.head[buf], sizeof(tlm_bulk.head[0]));
+
+		if (rc == HAL_OK) {
+
+			rc = tlm_bulk_send(data, len);
+		}
+
+		if (rc != HAL_OK)
+			break;
+
+		line = (line + N) % tlm.length_MAX;
+		clock += N;
+
+		buf = (buf != 0) ? 0 : 1;
+
+		if (		   poll() != 0
+				&& getc() != K_LF)
+			break;
+	}
+	while (clock < tlm.length_MAX);
+
+	if (rc != HAL_OK) {
+
+		/* USB was reset or disconnected so there is no one to
+		 * receive the rest of data.
+		 * */
+		return ;
+	}
+
+	/* Empty block marks the end of bulk data.
+	 * */
+	if (tlm_bulk_wait(2) != HAL_OK)
+		return ;
+
+	tlm_bulk.head[buf][0] = 0U;
+	tlm_bulk.head[buf][1] = 0U;
+	tlm_bulk.head[buf][2] = 0U;
+
+	if (tlm_bulk_send(tlm_bulk.head[buf], sizeof(tlm_bulk.head[0])) != HAL_OK)
+		return ;
+
+	if (tlm_bulk_wait(0) != HAL_OK)
+		return ;
+
+	tlm_frame_head(frame, TLM_FRAME_END, seq);
+
+	memcpy(frame + 3, &clock, sizeof(int));
+
+	tlm_frame_send(frame, 3 + sizeof(int));
+
+	puts(EOL);
+
+	if (		   clock == tlm.length_MAX
+			&& tlm.trig_state == TLM_STATE_DONE
+			&& tlm.trig_ARM == TLM_ARM_AUTO) {
+
+		/* Capture is read out so we arm the trigger again.
+		 * */
+		tlm_startup(&tlm, tlm.rate, TLM_MODE_TRIGGER);
+	}
+}
+
 #ifdef HW_HAVE_NETWORK_EPCAN
 LD_TASK void task_TLM_EPCAN(void *pData)
 {
@@ -335,7 +1367,6 @@ LD_TASK void task_TLM_EPCAN(void *pData)
 
 		while (tlm.line != line) {
 
-			const rval_t	*rdata = tlm.rdata + line * tlm.layout_N;
 			int		N;
 
 			msg.ID = EPCAN_ID_OFFSET(net.tlm_ID);
@@ -349,7 +1380,15 @@ LD_TASK void task_TLM_EPCAN(void *pData)
 			for (N = 0; N < tlm.layout_N; ++N) {
 
 				const reg_t	*reg = tlm.layout_reg[N];
-				rval_t		rval = rdata[N];
+				rval_t		rval;
+
+				if (tlm_line_unpack(&tlm, line, N, &rval) == 0) {
+
+					/* Hold the last sample of decimated channel.
+					 * */
+					tlm_line_unpack(&tlm, line & ~(tlm.layout_pack[N].divider - 1),
+							N, &rval);
+				}
 
 				if (reg->proc != NULL) {
 
@@ -3,16 +3,85 @@
 
 #include <stdint.h>
 
+#include "phobia/pm.h"
 #include "regfile.h"
 
 #define TLM_DATA_MAX		22500
 #define TLM_INPUT_MAX		20
 
+/* Record line is raw feedback followed by FSM request word.
+ * */
+#define TLM_RECORD_N		(sizeof(pmfb_t) / sizeof(rval_t) + 1)
+
+/* Delta channels keep the key value at the end of each block of lines.
+ * Also this is the maximal divider of decimated channel.
+ * */
+#define TLM_PACK_BLOCK		32
+
+/* Width of the bit-packed flag channel.
+ * */
+#define TLM_FLAG_BITS		6
+
+/* Binary frame is type, sequence, clock, values and CRC32. Header frame
+ * has four bytes per channel as well.
+ * */
+#define TLM_FRAME_MAX		(12 + TLM_INPUT_MAX * 4)
+
+/* Bulk flush sends raw blocks of lines not larger than this.
+ * */
+#define TLM_BULK_MAX		1024
+
+/* Binary frames are delimited and escaped as in SLIP.
+ * */
+#define TLM_SLIP_END		0xC0
+#define TLM_SLIP_ESC		0xDB
+#define TLM_SLIP_ESC_END	0xDC
+#define TLM_SLIP_ESC_ESC	0xDD
+
 enum {
 	TLM_MODE_DISABLED	= 0,
 	TLM_MODE_GRAB,
 	TLM_MODE_WATCH,
-	TLM_MODE_STREAM
+	TLM_MODE_STREAM,
+	TLM_MODE_RECORD,
+	TLM_MODE_STREAM_BINARY,
+	TLM_MODE_TRIGGER
+};
+
+enum {
+	TLM_FORMAT_RAW		= 0,
+	TLM_FORMAT_INT16,
+	TLM_FORMAT_DELTA8,
+	TLM_FORMAT_FLAG
+};
+
+enum {
+	TLM_TRIG_RISING		= 0,
+	TLM_TRIG_FALLING,
+	TLM_TRIG_CHANGE,
+	TLM_TRIG_ABOVE,
+	TLM_TRIG_BELOW,
+	TLM_TRIG_INSIDE,
+	TLM_TRIG_OUTSIDE
+};
+
+enum {
+	TLM_ARM_SINGLE		= 0,
+	TLM_ARM_AUTO
+};
+
+enum {
+	TLM_STATE_IDLE		= 0,
+	TLM_STATE_ARMED,
+	TLM_STATE_FIRED,
+	TLM_STATE_DONE
+};
+
+enum {
+	TLM_FRAME_HEADER	= 'H',
+	TLM_FRAME_DATA		= 'D',
+	TLM_FRAME_BULK		= 'B',
+	TLM_FRAME_END		= 'E'
 };
 
 enum {
@@ -21,20 +90,55 @@ enum {
 	TLM_AUTO_NET_EPCAN
 };
 
+typedef struct {
+
+	int		format;
+	int		divider;
+	int		order;
+	int		offset;
+	int		stride;
+	int		shift;
+	int		delta;
+	int		integer;
+
+	float		scale;
+	float		inv;
+
+	int		last;
+}
+tlm_pack_t;
+
 typedef struct {
 
 	int		rate_grab;
 	int		rate_watch;
 	int		rate_stream;
+	int		rate_binary;
 
 	int		auto_STARTUP;
 
 	int		mode;
 	int		reg_ID[TLM_INPUT_MAX];
+	int		reg_FMT[TLM_INPUT_MAX];
+	float		reg_scale[TLM_INPUT_MAX];
+	int		reg_DIV[TLM_INPUT_MAX];
+
+	int		trig_ID;
+	int		trig_TYPE;
+	float		trig_level;
+	float		trig_range;
+	int		trig_pre;
+	int		trig_ARM;
 
 	const reg_t	*layout_reg[TLM_INPUT_MAX];
+	tlm_pack_t	layout_pack[TLM_INPUT_MAX];
 
 	int		layout_N;
+	int		layout_FB;
+	int		layout_PACK;
+	int		layout_stride;
+	int		layout_delta_N;
+	int		layout_key;
 	int		length_MAX;
 
 	int		clock;
@@ -42,6 +146,15 @@ typedef struct {
 
 	int		rate;
 	int		line;
+	int		origin;
+
+	const reg_t	*trig_reg;
+
+	int		trig_INT;
+	int		trig_state;
+	int		trig_hold;
+	int		trig_N;
+	rval_t		trig_last;
 
 	rval_t		rdata[TLM_DATA_MAX];	/* memory to keep telemetry data */
 }
@@ -49,6 +162,7 @@ tlm_t;
 
 void tlm_reg_default(tlm_t *tlm);
 void tlm_reg_grab(tlm_t *tlm);
+void tlm_fb_record(tlm_t *tlm, const pmfb_t *fb);
 void tlm_startup(tlm_t *tlm, int rate, int mode);
 void tlm_halt(tlm_t *tlm);
 void tlm_wipe(tlm_t *tlm);